@@ -0,0 +1,57 @@
+#ifndef ATOMICSHAREDPTR_H
+#define ATOMICSHAREDPTR_H
+
+#include <memory>
+
+/*
+ * A shared pointer that may be read, copied and replaced by several threads
+ * at the same time. Objects holding it can be copied while other threads
+ * store a new value.
+ */
+template <typename T> class AtomicSharedPtr{
+	public:
+	AtomicSharedPtr() = default;
+
+	AtomicSharedPtr(const AtomicSharedPtr& o) : ptr_(o.load()) {}
+
+	AtomicSharedPtr& operator=(const AtomicSharedPtr& o)
+	{
+		store(o.load());
+		return *this;
+	}
+
+	/**load
+	 *
+	 * @return the current value
+	 */
+	std::shared_ptr<T> load() const { return std::atomic_load(&ptr_); }
+
+	/**store
+	 *
+	 * @param value, the new value
+	 */
+	void store(std::shared_ptr<T> value) { std::atomic_store(&ptr_, std::move(value)); }
+
+	/**compareExchange
+	 *
+	 * @param expected, the assumed current value, receives the current value on failure
+	 * @param value, the new value
+	 *
+	 * @return true if the value was replaced, false if it differed from the expected one
+	 */
+	bool compareExchange(std::shared_ptr<T>& expected, std::shared_ptr<T> value)
+	{
+		return std::atomic_compare_exchange_strong(&ptr_, &expected, std::move(value));
+	}
+
+	/**reset
+	 *
+	 * Removes the current value
+	 */
+	void reset() { store(nullptr); }
+
+	private:
+	std::shared_ptr<T> ptr_;
+};
+
+#endif
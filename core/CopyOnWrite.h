@@ -0,0 +1,51 @@
+#ifndef COPYONWRITE_H
+#define COPYONWRITE_H
+
+#include <memory>
+
+/*
+ * A value that is shared between copies until one of them is modified.
+ * Copying is constant time, the first write access of a copy whose value is
+ * still shared copies the value.
+ */
+template <typename T> class CopyOnWrite{
+	public:
+	CopyOnWrite() : data_(std::make_shared<T>()) {}
+
+	CopyOnWrite(const T& value) : data_(std::make_shared<T>(value)) {}
+
+	CopyOnWrite& operator=(const T& value)
+	{
+		data_ = std::make_shared<T>(value);
+		return *this;
+	}
+
+	/**get
+	 *
+	 * @return a const reference to the value
+	 */
+	const T& get() const { return *data_; }
+
+	/**getMutable
+	 *
+	 * @return a reference to the value, which is copied first if it is shared
+	 */
+	T& getMutable()
+	{
+		if(data_.use_count() > 1) {
+			data_ = std::make_shared<T>(*data_);
+		}
+		return *data_;
+	}
+
+	/**isShared
+	 *
+	 * @return true if other copies refer to the same value
+	 */
+	bool isShared() const { return data_.use_count() > 1; }
+
+	private:
+	std::shared_ptr<T> data_;
+};
+
+#endif
@@ -8,6 +8,15 @@ DataDistribution::DataDistribution(Network& network, Matrix<int>& observations)
 {
 }
 
+DataDistribution::DataDistribution(Network& network, SamplePatterns& patterns)
+    : network_(network),
+      observations_(patterns.getPatterns()),
+      weights_(patterns.getWeights()),
+      observationsMap_(network.getObservationsMap()),
+      observationsMapR_(network.getObservationsMapR())
+{
+}
+
 int
 DataDistribution::computeParentCombinations(std::vector<unsigned int> parents)
 {
@@ -28,19 +37,28 @@ void DataDistribution::assignObservationsToNodes()
 			throw std::invalid_argument(n.getName()+" not contained in data");
 		}
 		n.setObservationRow(row);
-		n.setUniqueValues(
-		    observations_.getUniqueRowValues(n.getObservationRow()));
-		n.setUniqueValuesExcludingNA(
-		    observations_.getUniqueRowValues(n.getObservationRow(), -1));
+		assignUniqueValues(n);
 	}
 
 	for(auto& n : network_.getNodes()) {
-		n.setParentCombinations(computeParentCombinations(n.getParents()));
-		assignValueNames(n);
-		assignParentNames(n);
+		assignNames(n);
 	}
 }
 
+void DataDistribution::assignUniqueValues(Node& n)
+{
+	n.setUniqueValues(observations_.getUniqueRowValues(n.getObservationRow()));
+	n.setUniqueValuesExcludingNA(
+	    observations_.getUniqueRowValues(n.getObservationRow(), -1));
+}
+
+void DataDistribution::assignNames(Node& n)
+{
+	n.setParentCombinations(computeParentCombinations(n.getParents()));
+	assignValueNames(n);
+	assignParentNames(n);
+}
+
 void DataDistribution::assignValueNames(Node& n)
 {
 	for(const auto& value : n.getUniqueValues()) {
@@ -132,38 +150,54 @@ int DataDistribution::getObservationRowIndex(unsigned int sample, Node& n)
 
 void DataDistribution::countObservations(Matrix<int>& obsMatrix, Node& n)
 {
+	network_.computeFactor(n);
 	for(unsigned int sample = 0; sample < observations_.getColCount();
 	    sample++) {
 
 		int column = getObservationColIndex(sample, n);
-		
-		network_.computeFactor(n);
 	
 		int row = getObservationRowIndex(sample, n);
 
 		if(row != -1) {
-			obsMatrix(column, row)++;
+			obsMatrix(column, row) += weights_.empty() ? 1 : weights_[sample];
 		}
 	}
 }
 
 void DataDistribution::distributeObservations()
 {
-	// Generating matrices
 	for(auto& n : network_.getNodes()) {
-		// Generating suitable matrices
-		Matrix<int> obsMatrix =
-		    Matrix<int>(n.getValueNames(), n.getParentValueNames(), 0);
-		Matrix<float> probMatrix =
-		    Matrix<float>(n.getValueNamesProb(), n.getParentValueNames(), 0.0f);
-		// Count observations
-		countObservations(obsMatrix, n);
-		// Store matrices
-		n.setObservations(obsMatrix);
-		n.setObservationBackup(obsMatrix);
-		n.setProbability(probMatrix);
-		n.initialiseRevFactor();
-		n.clearDynProgMatrix();
-		n.createBackup();
+		distributeObservations(n);
+	}
+	network_.clearPriors();
+}
+
+void DataDistribution::distributeObservations(Node& n)
+{
+	// Generating suitable matrices
+	Matrix<int> obsMatrix =
+	    Matrix<int>(n.getValueNames(), n.getParentValueNames(), 0);
+	Matrix<float> probMatrix =
+	    Matrix<float>(n.getValueNamesProb(), n.getParentValueNames(), 0.0f);
+	// Count observations
+	countObservations(obsMatrix, n);
+	// Store matrices
+	n.setObservations(obsMatrix);
+	n.setObservationBackup(obsMatrix);
+	n.setProbability(probMatrix);
+	n.initialiseRevFactor();
+	n.createBackup();
+}
+
+void DataDistribution::redistributeObservations(
+    const std::vector<unsigned int>& ids)
+{
+	for(auto id : ids) {
+		Node& n = network_.getNode(id);
+		n.clearNameVectors();
+		assignUniqueValues(n);
+		assignNames(n);
+		distributeObservations(n);
 	}
+	network_.clearPriors();
 }
@@ -3,6 +3,7 @@
 
 #include"Network.h"
 #include"Combinations.h"
+#include"SamplePatterns.h"
 #include<map>
 
 class DataDistribution{
@@ -17,6 +18,16 @@ class DataDistribution{
 	 */
 	DataDistribution(Network& network, Matrix<int>& observations);
 
+	/**DataDistribution
+	 *
+	 * @param network, A reference to a network
+	 * @param patterns, A reference to the unique discretised samples with their weights
+	 *
+	 * @return DataDistribution object counting every pattern with its weight
+	 *
+	 */
+	DataDistribution(Network& network, SamplePatterns& patterns);
+
 	DataDistribution& operator=(const DataDistribution&) = delete;
 	DataDistribution& operator=(DataDistribution&&) = delete;
 
@@ -35,8 +46,43 @@ class DataDistribution{
 	 * CPT.
 	 */
 	void distributeObservations();
+
+	/**redistributeObservations
+	 *
+	 * @param ids, identifiers of the nodes whose parents changed
+	 *
+	 * Recomputes the names, the observation counts and a properly sized CPT
+	 * of the given nodes only. All other nodes have to be initialised by
+	 * assignObservationsToNodes and distributeObservations before.
+	 */
+	void redistributeObservations(const std::vector<unsigned int>& ids);
 	private:
 
+	/**assignUniqueValues
+	 *
+	 * @param n, Reference to a node
+	 *
+	 * Assigns the observed values of the node, with and without missing values
+	 */
+	void assignUniqueValues(Node& n);
+
+	/**assignNames
+	 *
+	 * @param n, Reference to a node
+	 *
+	 * Assigns the number of parent combinations, the value names and the
+	 * parent names of the node
+	 */
+	void assignNames(Node& n);
+
+	/**distributeObservations
+	 *
+	 * @param n, Reference to a node
+	 *
+	 * Counts the observations of a single node and initialises its CPT
+	 */
+	void distributeObservations(Node& n);
+
 	/**computeParentCombinations
 	 *
 	 * @param parents, a vector containing the node identifiers of the parents
@@ -99,6 +145,8 @@ class DataDistribution{
 	Network& network_;	
 	// A reference to the observation matrix
 	Matrix<int>& observations_;
+	// Number of samples represented by each column of the observations, empty if every column is a single sample
+	std::vector<unsigned int> weights_;
 	// A map from the original value names to the internal integer representation
 	std::unordered_map<std::string,int>& observationsMap_;
 	// A map from the internal integer representation (using the observationRow entry in the Node class) to the original string representation
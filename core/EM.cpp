@@ -1,25 +1,72 @@
 #include "EM.h"
 
-EM::EM(Network& network, Matrix<int>& observations, float difference,
-       unsigned int runs)
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <random>
+
+EM::EM(Network& network, SamplePatterns& patterns, float difference,
+       unsigned int runs, unsigned int restarts, unsigned int threads,
+       EMStrategy strategy)
     : network_(network),
-      observations_(observations),
+      patterns_(patterns),
+      observations_(patterns.getPatterns()),
       probHandler_(network),
       differenceThreshold_(difference),
-      maxRuns_(runs)
+      maxRuns_(runs),
+      restarts_(restarts),
+      threads_(threads),
+      strategy_(strategy),
+      savedRuns_(0),
+      logLikelihood_(0.0),
+      logLikelihoodComputed_(false)
 {
 	performEM();
 }
 
+EM::EM(Network& network, SamplePatterns& patterns,
+       const std::vector<unsigned int>& nodes, float difference,
+       unsigned int runs, unsigned int restarts, unsigned int threads,
+       EMStrategy strategy)
+    : network_(network),
+      patterns_(patterns),
+      observations_(patterns.getPatterns()),
+      probHandler_(network),
+      differenceThreshold_(difference),
+      nodes_(nodes),
+      maxRuns_(runs),
+      restarts_(restarts),
+      threads_(threads),
+      strategy_(strategy),
+      savedRuns_(0),
+      logLikelihood_(0.0),
+      logLikelihoodComputed_(false)
+{
+	std::sort(nodes_.begin(), nodes_.end());
+	performEM();
+}
+
+bool EM::isEstimated(unsigned int id) const
+{
+	return nodes_.empty() || std::binary_search(nodes_.begin(), nodes_.end(), id);
+}
+
 void EM::performEM()
 {
 	start = std::chrono::system_clock::now();
 	// Check completness of the data
 	if(observations_.contains(-1)) {
-		// Determine the best initialization method
-		method_ = getMaxMethod_();
-		// Perform another EM run with the best method.
-		std::tie(finalDifference_, neededRuns_) = runEMIterations_();
+		// The expected counts depend on the whole network
+		nodes_.clear();
+		countObservedFamilies();
+		std::unique_ptr<ThreadPool> ownPool;
+		if(threads_ > 0) {
+			ownPool.reset(new ThreadPool(threads_));
+		}
+		// Fit all initialisations and keep the most probable parameters
+		method_ = getMaxMethod_(ownPool ? *ownPool : ThreadPool::getGlobalPool());
 	} else {
 		// Calculate parameters directly
 		finalDifference_ = mPhase();
@@ -28,82 +75,434 @@ void EM::performEM()
 	end = std::chrono::system_clock::now();
 }
 
-unsigned int EM::getMaxMethod_()
+unsigned int EM::getMaxMethod_(ThreadPool& pool)
 {
-	float maxprob = 0.0f;
-	unsigned int maxmethod = 0;
+	unsigned int methods = 2 + restarts_;
+	// Every initialisation works on its own copy of the parameters
+	std::vector<Network> networks(methods, network_);
+	std::vector<std::pair<float, unsigned int>> results(methods);
+	std::vector<unsigned int> savedRuns(methods, 0);
+	std::vector<double> likelihoods(methods);
+	std::atomic<unsigned int> unfinished(methods);
+	std::exception_ptr error;
+	std::mutex errorMutex;
+	for(unsigned int method = 0; method < methods; method++) {
+		pool.submit([&, method] {
+			try {
+				results[method] = runEMIterations_(networks[method], method, pool,
+				                                   savedRuns[method], likelihoods[method]);
+			} catch(...) {
+				std::lock_guard<std::mutex> lock(errorMutex);
+				if(!error) {
+					error = std::current_exception();
+				}
+			}
+			unfinished--;
+		});
+	}
+	pool.waitUntil([&unfinished] { return unfinished == 0; });
+	if(error) {
+		std::rethrow_exception(error);
+	}
 
-	for(unsigned int method = 0; method < 2; method++) {
-		// Initialize and iterate E/M-Phase
-		method_ = method;
-		runEMIterations_();
-		float prob = calculateLikelihoodOfTheData();
-		if(prob > maxprob) {
-			maxprob = prob;
+	unsigned int maxmethod = 0;
+	for(unsigned int method = 1; method < methods; method++) {
+		if(likelihoods[method] > likelihoods[maxmethod]) {
 			maxmethod = method;
 		}
 	}
-
+	const Network& best = networks[maxmethod];
+	for(auto& n : network_.getNodes()) {
+		n.setProbability(best.getNode(n.getID()).getProbabilityMatrix());
+	}
+	network_.clearPriors();
+	std::tie(finalDifference_, neededRuns_) = results[maxmethod];
+	savedRuns_ = savedRuns[maxmethod];
+	logLikelihood_ = likelihoods[maxmethod];
+	logLikelihoodComputed_ = true;
 	return maxmethod;
 }
 
-std::pair<float, unsigned int> EM::runEMIterations_()
+std::pair<float, unsigned int> EM::runEMIterations_(Network& network,
+                                                   unsigned int method,
+                                                   ThreadPool& pool,
+                                                   unsigned int& savedRuns,
+                                                   double& logLikelihood) const
 {
 	unsigned int runs = 0;
 	float difference = std::numeric_limits<float>::infinity();
+	savedRuns = 0;
+
+	initalise(network, method);
+	if(strategy_ == EMStrategy::SQUAREM) {
+		std::tie(difference, runs) = runSQUAREMIterations_(network, pool, savedRuns);
+	} else {
+		while(difference > differenceThreshold_ && runs < maxRuns_) {
+			difference = mPhase(network, ePhase(network, pool));
+			runs++;
+		}
+	}
+	// Likelihood of the final parameters
+	ePhase(network, pool, logLikelihood);
+
+	return std::make_pair(difference, runs);
+}
+
+std::pair<float, unsigned int>
+EM::runSQUAREMIterations_(Network& network, ThreadPool& pool,
+                          unsigned int& savedRuns) const
+{
+	// Every executed ePhase counts as a run, a cycle of two iterations, the
+	// likelihood of the second one and the stabilising iteration takes four
+	unsigned int runs = 0;
+	float difference = std::numeric_limits<float>::infinity();
+	// Parameter difference of the first iteration and the sum of the
+	// logarithms of the convergence rates observed in the plain iterations
+	float firstDifference = 0.0f;
+	double logRates = 0.0;
+	unsigned int rates = 0;
 
-	initalise();
 	while(difference > differenceThreshold_ && runs < maxRuns_) {
-		ePhase();
-		difference = mPhase();
+		std::vector<float> theta0 = getParameters(network);
+		difference = mPhase(network, ePhase(network, pool));
+		runs++;
+		if(runs == 1) {
+			firstDifference = difference;
+		}
+		if(difference <= differenceThreshold_ || runs == maxRuns_) {
+			break;
+		}
+		float previousDifference = difference;
+		std::vector<float> theta1 = getParameters(network);
+		difference = mPhase(network, ePhase(network, pool));
+		runs++;
+		if(previousDifference > 0.0f && difference > 0.0f &&
+		   difference < previousDifference) {
+			logRates += std::log(difference / previousDifference);
+			rates++;
+		}
+		if(difference <= differenceThreshold_ || runs == maxRuns_) {
+			break;
+		}
+		std::vector<float> theta2 = getParameters(network);
+		// The fallback continues from the second iteration, an extrapolation
+		// has to be at least as likely
+		double logLikelihood2;
+		double impossibleWeight2;
+		auto counts2 = ePhase(network, pool, logLikelihood2, impossibleWeight2);
+		runs++;
+		if(runs == maxRuns_) {
+			// No ePhase is left for the extrapolation, finish a plain iteration
+			difference = mPhase(network, counts2);
+			break;
+		}
+
+		// Step length of the squared extrapolation (SqS3 scheme), a step
+		// length of -1 yields the result of the second iteration
+		double r = 0.0;
+		double v = 0.0;
+		for(size_t i = 0; i < theta0.size(); i++) {
+			double ri = theta1[i] - theta0[i];
+			double vi = theta2[i] - 2.0 * theta1[i] + theta0[i];
+			r += ri * ri;
+			v += vi * vi;
+		}
+		double alpha = v > 0.0 ? -std::sqrt(r / v) : -1.0;
+		alpha = std::min(alpha, -1.0);
+		std::vector<float> extrapolated(theta0.size());
+		for(size_t i = 0; i < theta0.size(); i++) {
+			double ri = theta1[i] - theta0[i];
+			double vi = theta2[i] - 2.0 * theta1[i] + theta0[i];
+			extrapolated[i] = theta0[i] - 2.0 * alpha * ri + alpha * alpha * vi;
+		}
+		setParameters(network, extrapolated);
+
+		// Stabilising iteration, it yields the likelihood of the extrapolation.
+		// Zero cells may make samples impossible, hence the number of
+		// impossible samples is compared before the likelihood of the others.
+		double logLikelihoodExtrapolated;
+		double impossibleWeightExtrapolated;
+		auto counts = ePhase(network, pool, logLikelihoodExtrapolated,
+		                     impossibleWeightExtrapolated);
+		bool improves =
+		    impossibleWeightExtrapolated < impossibleWeight2 ||
+		    (impossibleWeightExtrapolated == impossibleWeight2 &&
+		     logLikelihoodExtrapolated >= logLikelihood2);
+		if(improves) {
+			difference = mPhase(network, counts);
+		} else {
+			// Monotonicity safeguard, continue from the second iteration
+			setParameters(network, theta2);
+			difference = mPhase(network, counts2);
+		}
 		runs++;
 	}
 
+	// Rough estimate, the plain iterations are assumed to converge linearly
+	// at the mean rate observed, which does not hold close to the optimum.
+	// A plain iteration executes one ePhase, hence both counts are comparable.
+	if(rates > 0 && firstDifference > differenceThreshold_) {
+		double rate = std::exp(logRates / rates);
+		double plainRuns = 1.0 + std::ceil(std::log(differenceThreshold_ / firstDifference) /
+		                                   std::log(rate));
+		if(plainRuns > runs) {
+			savedRuns = std::min<double>(plainRuns, maxRuns_) - runs;
+		}
+	}
 	return std::make_pair(difference, runs);
 }
 
-float EM::calculateProbabilityEM(Node& n, unsigned int col, unsigned int row)
+std::vector<float> EM::getParameters(const Network& network) const
+{
+	std::vector<float> parameters;
+	for(const Node& n : network.getNodes()) {
+		const Matrix<float>& probMatrix = n.getProbabilityMatrix();
+		for(unsigned int row = 0; row < probMatrix.getRowCount(); row++) {
+			for(unsigned int col = 0; col < probMatrix.getColCount(); col++) {
+				parameters.push_back(probMatrix(col, row));
+			}
+		}
+	}
+	return parameters;
+}
+
+void EM::setParameters(Network& network,
+                       const std::vector<float>& parameters) const
+{
+	size_t i = 0;
+	for(auto& n : network.getNodes()) {
+		const Node& node = n;
+		unsigned int cols = node.getProbabilityMatrix().getColCount();
+		unsigned int rows = node.getProbabilityMatrix().getRowCount();
+		for(unsigned int row = 0; row < rows; row++, i += cols) {
+			float rowsum = 0.0f;
+			for(unsigned int col = 0; col < cols; col++) {
+				rowsum += std::max(parameters[i + col], 0.0f);
+			}
+			if(rowsum <= 0.0f) {
+				continue;
+			}
+			for(unsigned int col = 0; col < cols; col++) {
+				n.setProbability(std::max(parameters[i + col], 0.0f) / rowsum, col, row);
+			}
+		}
+	}
+	network.clearPriors();
+}
+
+void EM::countObservedFamilies()
+{
+	const Network& network = network_;
+	observedCounts_.assign(network.size(), {});
+	for(const Node& n : network.getNodes()) {
+		const Matrix<int>& obMatrix = n.getObservationMatrix();
+		unsigned int offset = obMatrix.hasNACol() ? 1 : 0;
+		unsigned int cols = obMatrix.getColCount() - offset;
+		auto& counts = observedCounts_[n.getID()];
+		counts.assign(cols * obMatrix.getRowCount(), 0.0f);
+		for(unsigned int row = 0; row < obMatrix.getRowCount(); row++) {
+			for(unsigned int col = 0; col < cols; col++) {
+				counts[row * cols + col] = obMatrix(col + offset, row);
+			}
+		}
+	}
+	incompleteSamples_.clear();
+	completeSamples_.clear();
+	for(unsigned int sample = 0; sample < observations_.getColCount(); sample++) {
+		if(!getSampleValues(sample).empty()) {
+			incompleteSamples_.push_back(sample);
+		} else {
+			completeSamples_.push_back(sample);
+		}
+	}
+}
+
+std::vector<int> EM::getSampleValues(unsigned int sample) const
 {
-	// get Parents
-	auto ParentIDs = n.getParents();
-	const Matrix<float>& probMatrix = n.getProbabilityMatrix();
+	const Network& network = network_;
+	std::vector<int> values(network.size());
+	bool incomplete = false;
+	for(const Node& n : network.getNodes()) {
+		values[n.getID()] = observations_(sample, n.getObservationRow());
+		incomplete |= values[n.getID()] == -1;
+	}
+	if(!incomplete) {
+		values.clear();
+	}
+	return values;
+}
 
-	// compute TotProbParentsRec
-	float totProbParents = 1.0f;
-	for(unsigned int key = 0; key < n.getNumberOfParents(); key++) {
-		totProbParents *= probHandler_.computeTotalProbability(
-		    ParentIDs[key], network_.reverseFactor(n, key,row));
+void EM::addExpectedCounts(JunctionTree& tree, const std::vector<int>& values,
+                           float weight,
+                           std::vector<std::vector<float>>& counts) const
+{
+	const Network& network = network_;
+	tree.calibrate(values);
+	std::vector<int> assignment(values);
+	for(const Node& n : network.getNodes()) {
+		const auto& parents = n.getParents();
+		std::vector<unsigned int> family{n.getID()};
+		family.insert(family.end(), parents.begin(), parents.end());
+		std::vector<unsigned int> missing;
+		for(auto id : family) {
+			if(values[id] == -1) {
+				missing.push_back(id);
+			}
+		}
+		// Completely observed families are contained in the observed counts
+		if(missing.empty()) {
+			continue;
+		}
+		Factor marginal = tree.getMarginal(family);
+		auto& nodeCounts = counts[n.getID()];
+		unsigned int cols = n.getNumberOfUniqueValuesExcludingNA();
+		for(auto id : missing) {
+			assignment[id] = 0;
+		}
+		// Enumerate all values of the missing family members
+		unsigned int k = 0;
+		while(k < missing.size()) {
+			float probability = marginal.getProbability(assignment);
+			// Samples with impossible evidence do not contribute
+			if(std::isfinite(probability)) {
+				unsigned int row = 0;
+				for(unsigned int i = 0; i < parents.size(); i++) {
+					row += n.getFactor(i) * assignment[parents[i]];
+				}
+				nodeCounts[row * cols + assignment[n.getID()]] += weight * probability;
+			}
+			for(k = 0; k < missing.size(); k++) {
+				if(++assignment[missing[k]] <
+				   static_cast<int>(network.getNode(missing[k])
+				                        .getNumberOfUniqueValuesExcludingNA())) {
+					break;
+				}
+				assignment[missing[k]] = 0;
+			}
+		}
+		for(auto id : missing) {
+			assignment[id] = -1;
+		}
 	}
+}
 
-	// computeNormalizingProb
-	float denominator = 0.0f;
-	for(unsigned int col = 0; col < probMatrix.getColCount(); col++) {
-		denominator += probMatrix(col, row) * totProbParents;
+std::vector<std::vector<float>> EM::ePhase(const Network& network,
+                                          ThreadPool& pool,
+                                          double& logLikelihood) const
+{
+	double impossibleWeight;
+	auto counts = ePhase(network, pool, logLikelihood, impossibleWeight);
+	if(impossibleWeight > 0.0) {
+		logLikelihood = -std::numeric_limits<double>::infinity();
 	}
+	return counts;
+}
 
-	// return result
-	float nominator = probMatrix(col - 1, row) * totProbParents;
-	return nominator / denominator;
+std::vector<std::vector<float>> EM::ePhase(const Network& network,
+                                          ThreadPool& pool) const
+{
+	double logLikelihood;
+	double impossibleWeight;
+	return computeExpectedCounts(network, pool, logLikelihood, impossibleWeight);
 }
 
-void EM::calculateExpectedValue(unsigned int row, Node& n)
+std::vector<std::vector<float>> EM::ePhase(const Network& network,
+                                          ThreadPool& pool,
+                                          double& logLikelihood,
+                                          double& impossibleWeight) const
 {
-	Matrix<int>& obMatrix = n.getObservationMatrix();	
-	if(obMatrix.hasNACol()) {
-		for(unsigned int col = 1; col < obMatrix.getColCount(); col++) {
-			float value =
-			    obMatrix(col, row) +
-			    calculateProbabilityEM(n, col, row) * obMatrix(0, row);
-			obMatrix.setData(value, col, row);
+	auto counts = computeExpectedCounts(network, pool, logLikelihood, impossibleWeight);
+	addLogLikelihoodOfCompleteSamples(network, logLikelihood, impossibleWeight);
+	return counts;
+}
+
+std::vector<std::vector<float>>
+EM::computeExpectedCounts(const Network& network, ThreadPool& pool,
+                          double& logLikelihood, double& impossibleWeight) const
+{
+	// The partition does not depend on the pool size, so the expected counts
+	// are summed in the same order whatever the number of threads
+	const size_t samplesPerTask = 64;
+	size_t tasks = (incompleteSamples_.size() + samplesPerTask - 1) / samplesPerTask;
+	std::vector<std::vector<std::vector<float>>> buffers(tasks);
+	std::vector<double> logLikelihoods(tasks, 0.0);
+	std::vector<double> impossibleWeights(tasks, 0.0);
+	std::atomic<unsigned int> unfinished(tasks);
+	std::exception_ptr error;
+	std::mutex errorMutex;
+	EliminationHeuristic heuristic = probHandler_.getEliminationHeuristic();
+	for(unsigned int task = 0; task < tasks; task++) {
+		pool.submit([&, task] {
+			try {
+				auto& counts = buffers[task];
+				counts.resize(observedCounts_.size());
+				for(unsigned int id = 0; id < counts.size(); id++) {
+					counts[id].assign(observedCounts_[id].size(), 0.0f);
+				}
+				JunctionTree tree(network, heuristic);
+				size_t begin = task * samplesPerTask;
+				size_t end = std::min(begin + samplesPerTask, incompleteSamples_.size());
+				for(size_t i = begin; i < end; i++) {
+					unsigned int sample = incompleteSamples_[i];
+					unsigned int weight = patterns_.getWeights()[sample];
+					addExpectedCounts(tree, getSampleValues(sample), weight, counts);
+					double evidence = tree.getLogEvidenceProbability();
+					if(std::isfinite(evidence)) {
+						logLikelihoods[task] += weight * evidence;
+					} else {
+						impossibleWeights[task] += weight;
+					}
+				}
+			} catch(...) {
+				std::lock_guard<std::mutex> lock(errorMutex);
+				if(!error) {
+					error = std::current_exception();
+				}
+			}
+			unfinished--;
+		});
+	}
+	pool.waitUntil([&unfinished] { return unfinished == 0; });
+	if(error) {
+		std::rethrow_exception(error);
+	}
+	// Reduce the expected counts of all tasks in a fixed order
+	std::vector<std::vector<float>> expectedCounts(observedCounts_);
+	logLikelihood = 0.0;
+	impossibleWeight = 0.0;
+	for(unsigned int task = 0; task < tasks; task++) {
+		const auto& counts = buffers[task];
+		for(unsigned int id = 0; id < counts.size(); id++) {
+			for(unsigned int i = 0; i < counts[id].size(); i++) {
+				expectedCounts[id][i] += counts[id][i];
+			}
 		}
+		logLikelihood += logLikelihoods[task];
+		impossibleWeight += impossibleWeights[task];
 	}
+	return expectedCounts;
 }
 
-void EM::ePhase()
+void EM::addLogLikelihoodOfCompleteSamples(const Network& network,
+                                           double& logLikelihood,
+                                           double& impossibleWeight) const
 {
-	for(auto& n : network_.getNodes()) {
-		for(unsigned int row = 0; row < n.getNumberOfParentValues(); row++) {
-			calculateExpectedValue(row, n);
+	for(auto sample : completeSamples_) {
+		double sampleLikelihood = 0.0;
+		for(const Node& n : network.getNodes()) {
+			unsigned int row = 0;
+			for(unsigned int i = 0; i < n.getParents().size(); i++) {
+				row += n.getFactor(i) *
+				       observations_(sample, network.getNode(n.getParents()[i])
+				                                 .getObservationRow());
+			}
+			sampleLikelihood += std::log(n.getProbability(
+			    observations_(sample, n.getObservationRow()), row));
+		}
+		if(std::isfinite(sampleLikelihood)) {
+			logLikelihood += patterns_.getWeights()[sample] * sampleLikelihood;
+		} else {
+			impossibleWeight += patterns_.getWeights()[sample];
 		}
 	}
 }
@@ -143,30 +542,65 @@ float EM::mPhase()
 	float difference = 0.0f;
 	unsigned int counter = 0;
 	for(auto& n : network_.getNodes()) {
+		if(!isEstimated(n.getID())) {
+			continue;
+		}
 		const Matrix<int>& obMatrix = n.getObservationMatrix();
 		for(unsigned int row = 0; row < obMatrix.getRowCount(); row++)
 			calculateMaximumLikelihood(row, counter, difference, n, obMatrix);
 		n.loadBackup();
 	}
+	network_.clearPriors();
 	return difference / counter;
 }
 
+float EM::mPhase(Network& network,
+                 const std::vector<std::vector<float>>& counts) const
+{
+	float difference = 0.0f;
+	unsigned int counter = 0;
+	for(auto& n : network.getNodes()) {
+		const auto& nodeCounts = counts[n.getID()];
+		unsigned int cols = n.getNumberOfUniqueValuesExcludingNA();
+		for(unsigned int row = 0; row * cols < nodeCounts.size(); row++) {
+			float rowsum = 0.0f;
+			for(unsigned int col = 0; col < cols; col++) {
+				rowsum += nodeCounts[row * cols + col];
+			}
+			for(unsigned int col = 0; col < cols; col++) {
+				float probability = 0.0f;
+				if(rowsum > 0.0f) {
+					probability = nodeCounts[row * cols + col] / rowsum;
+					difference += fabs(n.getProbability(col, row) - probability);
+				}
+				n.setProbability(probability, col, row);
+				counter++;
+			}
+		}
+	}
+	network.clearPriors();
+	return difference / counter;
+}
 
-void EM::initalise()
+void EM::initalise(Network& network, unsigned int method) const
 {
-	switch(method_) {
+	switch(method) {
 		case 0:
-			initaliseAssumingUniformDistribution();
+			initaliseAssumingUniformDistribution(network);
 			break;
 		case 1:
-			initaliseAccordingToInitialDistribution();
+			initaliseAccordingToInitialDistribution(network);
+			break;
+		default:
+			initaliseRandomly(network, method);
 			break;
 	}
+	network.clearPriors();
 }
 
-void EM::initaliseAssumingUniformDistribution()
+void EM::initaliseAssumingUniformDistribution(Network& network) const
 {
-	for(auto& n : network_.getNodes()) {
+	for(auto& n : network.getNodes()) {
 		const Matrix<float>& probMatrix = n.getProbabilityMatrix();
 		for(unsigned int row = 0; row < probMatrix.getRowCount(); row++) {
 			for(unsigned int col = 0; col < probMatrix.getColCount(); col++) {
@@ -177,9 +611,9 @@ void EM::initaliseAssumingUniformDistribution()
 	}
 }
 
-void EM::initaliseAccordingToInitialDistribution()
+void EM::initaliseAccordingToInitialDistribution(Network& network) const
 {
-	for(auto& n : network_.getNodes()) {
+	for(auto& n : network.getNodes()) {
 		const Matrix<int>& obMatrix = n.getObservationMatrix();
 		const Matrix<float>& probMatrix = n.getProbabilityMatrix();
 		for(unsigned int row = 0; row < probMatrix.getRowCount(); row++) {
@@ -199,9 +633,30 @@ void EM::initaliseAccordingToInitialDistribution()
 	}
 }
 
+void EM::initaliseRandomly(Network& network, unsigned int seed) const
+{
+	std::mt19937 generator(seed);
+	// Normalised Gamma(1) variables follow a uniform Dirichlet distribution
+	std::exponential_distribution<float> distribution(1.0f);
+	for(auto& n : network.getNodes()) {
+		const Matrix<float>& probMatrix = n.getProbabilityMatrix();
+		std::vector<float> row(probMatrix.getColCount());
+		for(unsigned int r = 0; r < probMatrix.getRowCount(); r++) {
+			float rowsum = 0.0f;
+			for(auto& value : row) {
+				value = distribution(generator);
+				rowsum += value;
+			}
+			for(unsigned int col = 0; col < row.size(); col++) {
+				n.setProbability(row[col] / rowsum, col, r);
+			}
+		}
+	}
+}
+
 float EM::calculateLikelihoodOfTheData()
 {
-	return probHandler_.calculateLikelihoodOfTheData(observations_);
+	return probHandler_.calculateLikelihoodOfTheData(patterns_);
 }
 
 
@@ -209,6 +664,21 @@ int EM::getNumberOfRuns(){
 	return neededRuns_;
 }
 
+double EM::getLogLikelihood(){
+	// Complete data is estimated without an ePhase, the likelihood is only
+	// computed if it is asked for
+	if(!logLikelihoodComputed_) {
+		countObservedFamilies();
+		ePhase(network_, ThreadPool::getGlobalPool(), logLikelihood_);
+		logLikelihoodComputed_ = true;
+	}
+	return logLikelihood_;
+}
+
+int EM::getEstimatedNumberOfSavedRuns(){
+	return savedRuns_;
+}
+
 
 float EM::getDifference(){
 	return finalDifference_;
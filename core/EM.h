@@ -2,25 +2,62 @@
 #define EM_H
 
 #include "ProbabilityHandler.h"
+#include "JunctionTree.h"
+#include "SamplePatterns.h"
+#include "ThreadPool.h"
 
 #include <cmath>
 #include <chrono>
 
+/*
+ * The strategies to iterate the E- and M-Phase until convergence.
+ *
+ * Plain: Every iteration executes one E- and one M-Phase.
+ * SQUAREM: Two EM iterations determine a squared extrapolation of the
+ * parameters, which is stabilised by a third EM iteration. The extrapolation
+ * is rejected if it decreases the likelihood of the data.
+ */
+enum class EMStrategy {
+	Plain,
+	SQUAREM
+};
+
 class EM{
 	public:
 	/**
 	 * This class performs the EM algorithm as described in Probablistic Graphical Models by
 	 * Koller & Friedmann.
-	 * The network is fitted given the data using 2 different initialisation techniques. According to
-	 * the log-likelihood, the most probable parameters are chosen.
+	 * The network is fitted given the data using 2 different initialisation techniques and the
+	 * given number of random restarts. According to the log-likelihood, the most probable
+	 * parameters are chosen. All initialisations are fitted concurrently on copies of the network.
+	 *
+	 * @param network A reference to the network
+	 * @param patterns The unique discretised samples with their weights
+	 * @param differenceThreshold_ The threshold for convergence of the EM algorithm (default is 0.0001)
+	 * @param maxRuns_ The allowed number of iterations for the EM algorithm (default is 10000)
+	 * @param restarts The number of additional initialisations drawn from a uniform Dirichlet distribution (default is 0)
+	 * @param threads The number of threads used, 0 uses the global thread pool (default is 0)
+	 * @param strategy The strategy iterating E- and M-Phase (default is Plain)
+	 *
+	 */
+	EM(Network& network, SamplePatterns& patterns, float differenceThreshold_ = 0.0001f, unsigned int maxRuns_=10000, unsigned int restarts = 0, unsigned int threads = 0, EMStrategy strategy = EMStrategy::Plain);
+
+	/**
+	 * Estimates the parameters of the given nodes only, e.g. after their parents changed.
+	 * The parameters of a node only depend on its own counts if the data is complete.
+	 * Missing values require a full EM run over all nodes.
 	 *
 	 * @param network A reference to the network
-	 * @param observations_ A matrix of type int containing the discretised sample data
+	 * @param patterns The unique discretised samples with their weights
+	 * @param nodes The identifiers of the nodes whose parameters are estimated
 	 * @param differenceThreshold_ The threshold for convergence of the EM algorithm (default is 0.0001)
 	 * @param maxRuns_ The allowed number of iterations for the EM algorithm (default is 10000)
+	 * @param restarts The number of additional initialisations drawn from a uniform Dirichlet distribution (default is 0)
+	 * @param threads The number of threads used, 0 uses the global thread pool (default is 0)
+	 * @param strategy The strategy iterating E- and M-Phase (default is Plain)
 	 *
 	 */
-	EM(Network& network, Matrix<int>& observations_,float differenceThreshold_ = 0.0001f, unsigned int maxRuns_=10000);	
+	EM(Network& network, SamplePatterns& patterns, const std::vector<unsigned int>& nodes, float differenceThreshold_ = 0.0001f, unsigned int maxRuns_=10000, unsigned int restarts = 0, unsigned int threads = 0, EMStrategy strategy = EMStrategy::Plain);
 
 	EM& operator=(const EM&) = delete;
 	EM& operator=(EM&&) = delete;
@@ -36,10 +73,27 @@ class EM{
 	float calculateLikelihoodOfTheData();
 
 	/**
-	 * @return The number of executed EM-iterations
+	 * @return The log-likelihood of all samples, including the incomplete ones,
+	 * given the estimated parameters. For complete data it is computed on the
+	 * first call.
+	 */
+	double getLogLikelihood();
+
+	/**
+	 * @return The number of executed EM-iterations. The SQUAREM strategy counts
+	 * every ePhase, including those that only evaluate the likelihood.
 	 */
 	int getNumberOfRuns();
 
+	/**
+	 * @return An estimate, not a measurement, of the number of ePhases saved by
+	 * the extrapolation of the SQUAREM strategy compared to plain EM, 0 for the
+	 * plain strategy.
+	 * It extrapolates the mean convergence rate of the plain iterations of the run
+	 * and is unreliable if plain EM slows down close to the optimum.
+	 */
+	int getEstimatedNumberOfSavedRuns();
+
 	/**
 	 * @return The final(final and pre-final iteration) parameter difference
 	 */
@@ -52,29 +106,92 @@ class EM{
 
 	private:
 	/**
-	 * @param n A cost reference to the Node in question
-	 * @param col column of the CPT
-	 * @param row row of the CPT
+	 * Stores the counts of all samples in which a node and its parents are
+	 * observed and collects the samples containing missing values
+	 */
+	void countObservedFamilies();
+
+	/**
+	 * @param sample The index of the pattern
+	 *
+	 * @return The values of the pattern indexed by node ID, empty if the pattern
+	 *         is complete
+	 */
+	std::vector<int> getSampleValues(unsigned int sample) const;
+
+	/**
+	 * Adds the posterior probabilities of all families that are not completely
+	 * observed in the given sample to the expected counts
+	 *
+	 * @param tree A junction tree of the network, calibrated for the sample
+	 * @param values The values of the sample indexed by node ID
+	 * @param weight The number of samples represented by the pattern
+	 * @param counts The expected counts of every node, in the layout of the CPTs
+	 */
+	void addExpectedCounts(JunctionTree& tree, const std::vector<int>& values,
+	                       float weight,
+	                       std::vector<std::vector<float>>& counts) const;
+
+	/**
+	 * Executes the ePhase of the EM algorithm. The posterior probabilities of the
+	 * families of every incomplete pattern are computed with a junction tree
+	 * and weighted by its number of samples. The patterns are distributed over the threads of the pool,
+	 * every task sums up its own expected counts.
+	 *
+	 * @param network The network providing the current parameters
+	 * @param pool The thread pool executing the tasks
+	 * @param logLikelihood Receives the log-likelihood of all samples given the current parameters
+	 *
+	 * @return The expected counts of every node, in the layout of the CPTs
+	 */
+	std::vector<std::vector<float>> ePhase(const Network& network, ThreadPool& pool, double& logLikelihood) const;
+
+	/**
+	 * Executes the ePhase of the EM algorithm without computing the log-likelihood
+	 * of the complete samples, for iterations that do not need the likelihood.
+	 *
+	 * @param network The network providing the current parameters
+	 * @param pool The thread pool executing the tasks
+	 *
+	 * @return The expected counts of every node, in the layout of the CPTs
+	 */
+	std::vector<std::vector<float>> ePhase(const Network& network, ThreadPool& pool) const;
+
+	/**
+	 * Executes the ePhase of the EM algorithm. Samples with probability zero
+	 * are accounted separately, so likelihoods remain comparable if zero cells
+	 * make some samples impossible.
+	 *
+	 * @param network The network providing the current parameters
+	 * @param pool The thread pool executing the tasks
+	 * @param logLikelihood Receives the log-likelihood of all possible samples
+	 * @param impossibleWeight Receives the number of samples with probability zero
 	 *
-	 * @return The probability at the specified position of the CPT
-	 * in the specified node
+	 * @return The expected counts of every node, in the layout of the CPTs
 	 */
-	float calculateProbabilityEM(Node& n, unsigned int col, unsigned int row);
+	std::vector<std::vector<float>> ePhase(const Network& network, ThreadPool& pool, double& logLikelihood, double& impossibleWeight) const;
 
 	/**
-	 * Calculates the expected values for the given row and node. The expected value is
-	 * the expected number of occurrences of certain observations. This is needed in the ePhase
-	 * of the EM algorithm
+	 * Computes the expected counts of the incomplete samples concurrently,
+	 * their log-likelihood is a by-product of the junction trees.
 	 *
-	 * @param row row of the CPT
-	 * @param n A reference to a node
+	 * @param network The network providing the current parameters
+	 * @param pool The thread pool executing the tasks
+	 * @param logLikelihood Receives the log-likelihood of the possible incomplete samples
+	 * @param impossibleWeight Receives the number of incomplete samples with probability zero
+	 *
+	 * @return The observed counts plus the expected counts of the incomplete samples
 	 */
-	void calculateExpectedValue(unsigned int row, Node& n);
+	std::vector<std::vector<float>> computeExpectedCounts(const Network& network, ThreadPool& pool, double& logLikelihood, double& impossibleWeight) const;
 
 	/**
-	 * Executes the ePhase of the EM algorithm
+	 * Adds the log-likelihood of the complete samples.
+	 *
+	 * @param network The network providing the current parameters
+	 * @param logLikelihood The log-likelihood of the possible samples is added to it
+	 * @param impossibleWeight The number of samples with probability zero is added to it
 	 */
-	void ePhase();
+	void addLogLikelihoodOfCompleteSamples(const Network& network, double& logLikelihood, double& impossibleWeight) const;
 
 	/**
 	 * Performs maximum likelihood estimation for the given node
@@ -88,42 +205,144 @@ class EM{
 	void calculateMaximumLikelihood(unsigned int row, unsigned int& counter, float& difference, Node& n, const Matrix<int> & obMatrix);
 
 	/**
-	 * Executes the mPhase of the EM algorithm.
+	 * Executes the mPhase of the EM algorithm on complete data.
 	 *
 	 * @return Difference of the parameters between the current and the previous state
 	 */
 	float mPhase();
 
+	/**
+	 * Executes the mPhase of the EM algorithm using expected counts.
+	 *
+	 * @param network The network whose parameters are estimated
+	 * @param counts The expected counts computed by the ePhase
+	 *
+	 * @return Difference of the parameters between the current and the previous state
+	 */
+	float mPhase(Network& network, const std::vector<std::vector<float>>& counts) const;
+
 	/**
 	 * Calls different initialisation methods.
+	 *
+	 * @param network The network whose parameters are initialised
+	 * @param method 0 for a uniform, 1 for a data based and any other value for a random initialisation
 	 */
-	void initalise();
+	void initalise(Network& network, unsigned int method) const;
 
 	/**
 	 * Initialises all parameters assuming an equal distribution.
+	 *
+	 * @param network The network whose parameters are initialised
 	 */
-	void initaliseAssumingUniformDistribution();
+	void initaliseAssumingUniformDistribution(Network& network) const;
 
 	/**
 	 * Initialises all parameters using MLE for the observed values.
+	 *
+	 * @param network The network whose parameters are initialised
+	 */
+	void initaliseAccordingToInitialDistribution(Network& network) const;
+
+	/**
+	 * Draws every row of the CPTs from a uniform Dirichlet distribution.
+	 *
+	 * @param network The network whose parameters are initialised
+	 * @param seed The seed of the random number generator
+	 */
+	void initaliseRandomly(Network& network, unsigned int seed) const;
+
+	/**
+	 * @param id Identifier of a node
+	 *
+	 * @return True if the parameters of the node are estimated by mPhase
 	 */
-	void initaliseAccordingToInitialDistribution();
+	bool isEstimated(unsigned int id) const;
 
-	std::pair<float, unsigned int> runEMIterations_();
-	unsigned int getMaxMethod_();
+	/**
+	 * @param network A network
+	 *
+	 * @return The entries of all CPTs, row by row
+	 */
+	std::vector<float> getParameters(const Network& network) const;
+
+	/**
+	 * Replaces the entries of all CPTs. Negative entries are set to 0 and every
+	 * row is normalised, rows summing up to 0 are left unchanged.
+	 *
+	 * @param network The network whose parameters are replaced
+	 * @param parameters The entries of all CPTs, row by row
+	 */
+	void setParameters(Network& network, const std::vector<float>& parameters) const;
+
+	/**
+	 * Initialises the network and iterates E/M-Phase until convergence.
+	 *
+	 * @param network The network whose parameters are estimated
+	 * @param method The initialisation method
+	 * @param pool The thread pool executing the ePhase
+	 * @param savedRuns Receives the estimated number of saved plain iterations
+	 * @param logLikelihood Receives the log-likelihood of all samples given the final parameters
+	 *
+	 * @return The final parameter difference and the number of iterations
+	 */
+	std::pair<float, unsigned int> runEMIterations_(Network& network, unsigned int method, ThreadPool& pool, unsigned int& savedRuns, double& logLikelihood) const;
+
+	/**
+	 * Iterates E/M-Phase using squared extrapolation until convergence.
+	 *
+	 * @param network The initialised network whose parameters are estimated
+	 * @param pool The thread pool executing the ePhase
+	 * @param savedRuns Receives the estimated number of saved plain iterations
+	 *
+	 * @return The final parameter difference and the number of iterations
+	 */
+	std::pair<float, unsigned int> runSQUAREMIterations_(Network& network, ThreadPool& pool, unsigned int& savedRuns) const;
+
+	/**
+	 * Fits all initialisations concurrently on copies of the network and
+	 * stores the parameters with the highest log-likelihood of all samples,
+	 * including the incomplete ones, in the network.
+	 *
+	 * @param pool The thread pool executing the EM runs
+	 *
+	 * @return The initialisation method with the highest likelihood
+	 */
+	unsigned int getMaxMethod_(ThreadPool& pool);
 
 	//A reference to the network
 	Network& network_;
-	//The initialisation method
+	//The initialisation method with the highest likelihood
 	unsigned int method_;
-	//The discretised observations
+	//The unique discretised samples with their weights
+	SamplePatterns& patterns_;
+	//The unique discretised samples, one per column
 	Matrix<int>& observations_;
 	//An instance of the probabilityHandler
 	ProbabilityHandler probHandler_;
 	//The parameter difference
 	float differenceThreshold_;
+	//The sorted identifiers of the estimated nodes, empty if all nodes are estimated
+	std::vector<unsigned int> nodes_;
+	//Counts of the completely observed families, in the layout of the CPTs
+	std::vector<std::vector<float>> observedCounts_;
+	//Indices of the patterns containing missing values
+	std::vector<unsigned int> incompleteSamples_;
+	//Indices of the patterns without missing values
+	std::vector<unsigned int> completeSamples_;
 	//Fields dealing with run information
 	unsigned int maxRuns_;
+	//Number of random initialisations in addition to the uniform and the data based one
+	unsigned int restarts_;
+	//Number of threads, 0 if the global thread pool is used
+	unsigned int threads_;
+	//The strategy iterating E- and M-Phase
+	EMStrategy strategy_;
+	//Estimated number of plain iterations saved by the strategy
+	int savedRuns_;
+	//Log-likelihood of all samples given the estimated parameters
+	double logLikelihood_;
+	//Whether logLikelihood_ has been computed, it is computed lazily for complete data
+	bool logLikelihoodComputed_;
 	int neededRuns_;	
 	//The resulting parameter difference
 	float finalDifference_;
@@ -0,0 +1,113 @@
+#include "EliminationOrdering.h"
+
+#include <iterator>
+
+EliminationOrdering::EliminationOrdering(
+    const Network& network, const std::vector<unsigned int>& factorisation,
+    const std::vector<int>& values)
+    : neighbours_(network.size()), weights_(network.size(), 1.0)
+{
+	for(auto& id : factorisation) {
+		const Node& n = network.getNode(id);
+		std::vector<unsigned int> family;
+		if(values[id] == -1) {
+			family.push_back(id);
+			weights_[id] = n.getNumberOfUniqueValuesExcludingNA();
+		}
+		for(auto& pid : n.getParents()) {
+			if(values[pid] == -1) {
+				family.push_back(pid);
+			}
+		}
+		for(auto& first : family) {
+			for(auto& second : family) {
+				if(first != second) {
+					neighbours_[first].insert(second);
+				}
+			}
+		}
+	}
+}
+
+const std::set<unsigned int>&
+EliminationOrdering::getNeighbours(unsigned int id) const
+{
+	return neighbours_[id];
+}
+
+double EliminationOrdering::computeCost(unsigned int id,
+                                        EliminationHeuristic heuristic) const
+{
+	const auto& neighbours = neighbours_[id];
+	if(heuristic == EliminationHeuristic::MinDegree) {
+		return neighbours.size();
+	}
+	double cost = 0.0;
+	for(auto first = neighbours.begin(); first != neighbours.end(); ++first) {
+		for(auto second = std::next(first); second != neighbours.end();
+		    ++second) {
+			if(neighbours_[*first].find(*second) == neighbours_[*first].end()) {
+				if(heuristic == EliminationHeuristic::WeightedMinFill) {
+					cost += weights_[*first] * weights_[*second];
+				} else {
+					cost += 1.0;
+				}
+			}
+		}
+	}
+	return cost;
+}
+
+const std::vector<std::vector<unsigned int>>&
+EliminationOrdering::getCliques() const
+{
+	return cliques_;
+}
+
+void EliminationOrdering::eliminateNode(unsigned int id)
+{
+	std::vector<unsigned int> clique{id};
+	clique.insert(clique.end(), neighbours_[id].begin(), neighbours_[id].end());
+	cliques_.push_back(clique);
+	for(auto& first : neighbours_[id]) {
+		neighbours_[first].erase(id);
+		for(auto& second : neighbours_[id]) {
+			if(first != second) {
+				neighbours_[first].insert(second);
+			}
+		}
+	}
+	neighbours_[id].clear();
+}
+
+std::vector<unsigned int>
+EliminationOrdering::getOrdering(const std::vector<unsigned int>& nodes,
+                                 EliminationHeuristic heuristic)
+{
+	cliques_.clear();
+	if(heuristic == EliminationHeuristic::Factorisation) {
+		for(auto& id : nodes) {
+			eliminateNode(id);
+		}
+		return nodes;
+	}
+	std::vector<unsigned int> remaining = nodes;
+	std::vector<unsigned int> ordering;
+	ordering.reserve(nodes.size());
+	while(!remaining.empty()) {
+		// Ties are broken by the position in the given node list
+		auto best = remaining.begin();
+		double bestCost = computeCost(*best, heuristic);
+		for(auto it = std::next(remaining.begin()); it != remaining.end(); ++it) {
+			double cost = computeCost(*it, heuristic);
+			if(cost < bestCost) {
+				bestCost = cost;
+				best = it;
+			}
+		}
+		ordering.push_back(*best);
+		eliminateNode(*best);
+		remaining.erase(best);
+	}
+	return ordering;
+}
@@ -0,0 +1,104 @@
+#ifndef ELIMINATIONORDERING_H
+#define ELIMINATIONORDERING_H
+
+#include "Network.h"
+
+/*
+ * Heuristics that can be used to determine the order in which nodes are
+ * eliminated during variable elimination.
+ * Factorisation: The order in which the nodes occur in the factorisation.
+ * MinDegree: The node with the fewest neighbours is eliminated first.
+ * MinFill: The node introducing the fewest fill edges is eliminated first.
+ * WeightedMinFill: The node introducing the fill edges with the lowest total
+ * weight is eliminated first. The weight of an edge is the product of the
+ * number of values of its two nodes.
+ */
+enum class EliminationHeuristic {
+	Factorisation,
+	MinDegree,
+	MinFill,
+	WeightedMinFill
+};
+
+/*
+ * This class computes greedy elimination orderings on the moral graph of a
+ * factorisation. Observed nodes are not part of the moral graph, as they do
+ * not increase the size of any factor.
+ */
+class EliminationOrdering{
+	public:
+	/**EliminationOrdering
+	 *
+	 * @param network, a const reference to the network
+	 * @param factorisation, factorisation produced for the query nodes
+	 * @param values, vector containing the observed values, -1 for unobserved nodes
+	 *
+	 * @return an EliminationOrdering object
+	 *
+	 * Builds the moral graph of the unobserved nodes in the factorisation
+	 */
+	EliminationOrdering(const Network& network,
+	                    const std::vector<unsigned int>& factorisation,
+	                    const std::vector<int>& values);
+
+	EliminationOrdering& operator=(const EliminationOrdering&) = delete;
+	EliminationOrdering& operator=(EliminationOrdering&&) = delete;
+
+	/**getOrdering
+	 *
+	 * @param nodes, identifiers of the nodes that should be eliminated
+	 * @param heuristic, the heuristic used to choose the next node
+	 *
+	 * @return the given nodes in the order of elimination
+	 *
+	 * Nodes of the moral graph that are not contained in nodes are never
+	 * eliminated, but are considered in the cost computation.
+	 */
+	std::vector<unsigned int> getOrdering(const std::vector<unsigned int>& nodes,
+	                                      EliminationHeuristic heuristic);
+
+	/**getNeighbours
+	 *
+	 * @param id, identifier of the node of interest
+	 *
+	 * @return identifiers of the neighbours of the node in the current moral graph
+	 */
+	const std::set<unsigned int>& getNeighbours(unsigned int id) const;
+
+	/**getCliques
+	 *
+	 * @return for every node eliminated by the last call of getOrdering, the node
+	 * and its neighbours at the time of its elimination. These are the cliques of
+	 * the triangulated moral graph.
+	 */
+	const std::vector<std::vector<unsigned int>>& getCliques() const;
+
+	private:
+	/**computeCost
+	 *
+	 * @param id, identifier of the node of interest
+	 * @param heuristic, the heuristic determining the cost function
+	 *
+	 * @return the cost of eliminating the given node next
+	 */
+	double computeCost(unsigned int id, EliminationHeuristic heuristic) const;
+
+	/**eliminateNode
+	 *
+	 * @param id, identifier of the node to eliminate
+	 *
+	 * Connects all neighbours of the node and removes it from the graph
+	 */
+	void eliminateNode(unsigned int id);
+
+	//Neighbours of every node in the moral graph, indexed by node identifier
+	std::vector<std::set<unsigned int>> neighbours_;
+
+	//Number of values of every node, indexed by node identifier
+	std::vector<double> weights_;
+
+	//Cliques created while eliminating the nodes
+	std::vector<std::vector<unsigned int>> cliques_;
+};
+
+#endif
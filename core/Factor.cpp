@@ -1,220 +1,242 @@
 #include "Factor.h"
-#include "cmath"
+#include "FactorKernels.h"
 #include "algorithm"
-#include <cstdlib>
 
 Factor::Factor(const Node& n, const std::vector<int>& values)
+    : nodeIDs_{n.getID()}
 {
-	std::vector<unsigned int> nodeIDs = {n.getID()};
-	nodeIDs.insert(nodeIDs.end(), n.getParents().begin(), n.getParents().end());
-	nodeIDs_ = nodeIDs;
-	length_ = 0;
-	Matrix<float> p = n.getProbabilityMatrix();
-	bool parentsKnown = false;
-	std::vector<unsigned int> knownParents;
-	std::set<std::vector<int>> usedValues;
-	for(auto& id : n.getParents()) {
-		if(values[id] != -1) {
-			parentsKnown = true;
-			knownParents.push_back(id);
+	const auto& parents = n.getParents();
+	const Matrix<float>& p = n.getProbabilityMatrix();
+	nodeIDs_.insert(nodeIDs_.end(), parents.begin(), parents.end());
+	cardinalities_.resize(nodeIDs_.size());
+	observed_.resize(nodeIDs_.size(), -1);
+	// Steps in the flat CPT storage for the node (columns) and its parents (rows)
+	ArenaVector<size_t> cptSteps(nodeIDs_.size(), 1);
+	size_t offset = 0;
+	for(unsigned int i = 0; i < nodeIDs_.size(); i++) {
+		unsigned int cardinality = p.getColCount();
+		if(i > 0) {
+			unsigned int upper =
+			    (i == 1) ? p.getRowCount() : n.getFactor(i - 2);
+			cardinality = upper / n.getFactor(i - 1);
+			cptSteps[i] = n.getFactor(i - 1) * p.getColCount();
+		}
+		int value = values[nodeIDs_[i]];
+		if(value == -1) {
+			cardinalities_[i] = cardinality;
+		} else if(value < 0 || static_cast<unsigned int>(value) >= cardinality) {
+			throw std::invalid_argument("In Factor::Factor, the value of node " +
+			                            std::to_string(nodeIDs_[i]) +
+			                            " is out of range");
+		} else {
+			// Observed dimensions are removed by moving the offset
+			cardinalities_[i] = 1;
+			observed_[i] = value;
+			offset += cptSteps[i] * value;
 		}
 	}
-	if(values[n.getID()] == -1) {
-		for(unsigned int col = 0; col < p.getColCount(); col++) {
-			for(unsigned int row = 0; row < p.getRowCount(); row++) {
-				std::vector<int> v{n.getUniqueValuesExcludingNA()[col]};
-				if(n.getNumberOfParents() != 0) {
-					v.insert(v.end(), n.getParentValues()[row].begin(),
-					         n.getParentValues()[row].end());
-				}
-				if(!parentsKnown && (usedValues.find(v) ==
-				                         usedValues.end())) {
-					val_.insert(val_.end(), v.begin(), v.end());
-					addProbability(p(col, row));
-					length_++;
-					usedValues.insert(v);
-				} else {
-					bool useRow = true;
-					for(auto& id : knownParents) {
-						if(v[getIndex(id)] != values[id]) {
-							useRow = false;
-						}
-					}
-					if(useRow && (usedValues.find(v) == usedValues.end())) {
-						val_.insert(val_.end(), v.begin(), v.end());
-						addProbability(p(col, row));
-						length_++;
-						usedValues.insert(v);
-					}
-				}
-			}
+	computeStrides();
+	// Strided gather from the CPT, the last node changes fastest
+	const float* cpt = p.getRawData() + offset;
+	const unsigned int last = nodeIDs_.size() - 1;
+	const unsigned int run = cardinalities_[last];
+	const size_t step = cptSteps[last];
+	ArenaVector<unsigned int> counter(nodeIDs_.size(), 0);
+	size_t position = 0;
+	for(size_t start = 0; start < probabilities_.size(); start += run) {
+		for(unsigned int k = 0; k < run; k++) {
+			probabilities_[start + k] = cpt[position + k * step];
 		}
-	} else {
-		for(unsigned int row = 0; row < p.getRowCount(); row++) {
-			std::vector<int> v{values[n.getID()]};
-			if(n.getNumberOfParents() != 0) {
-				v.insert(v.end(), n.getParentValues()[row].begin(),
-				         n.getParentValues()[row].end());
-			}
-			if(!parentsKnown && (usedValues.find(v) == usedValues.end())) {
-				val_.insert(val_.end(), v.begin(), v.end());
-				addProbability(p(values[n.getID()], row));
-				length_++;
-				usedValues.insert(v);
-			} else {
-				bool useRow = true;
-				for(auto& id : knownParents) {
-					if(v[getIndex(id)] != values[id]) {
-						useRow = false;
-					}
-				}
-				if(useRow && (usedValues.find(v) == usedValues.end())) {
-					val_.insert(val_.end(), v.begin(), v.end());
-					addProbability(p(values[n.getID()], row));
-					length_++;
-					usedValues.insert(v);
-				}
+		for(int i = last - 1; i >= 0; i--) {
+			if(++counter[i] < cardinalities_[i]) {
+				position += cptSteps[i];
+				break;
 			}
+			position -= (cardinalities_[i] - 1) * cptSteps[i];
+			counter[i] = 0;
 		}
 	}
 }
 
-Factor::Factor(unsigned int length, std::vector<unsigned int> ids)
+Factor::Factor(const std::vector<unsigned int>& ids,
+               const std::vector<unsigned int>& cardinalities,
+               const std::vector<int>& observed)
     : nodeIDs_(ids),
-      val_(length * ids.size()),
-      probabilities_(length),
-      length_(length)
-{
-}
-
-std::vector<unsigned int> Factor::getCommonIDs(const Factor& factor) const
+      cardinalities_(cardinalities),
+      observed_(observed.begin(), observed.end())
 {
-	std::vector<unsigned int> intersection;
-	intersection.reserve(std::min(nodeIDs_.size(), factor.getIDs().size()));
-
-	std::vector<unsigned int> thisIDs = nodeIDs_;
-	std::vector<unsigned int> otherIDs = factor.getIDs();
-	std::sort(thisIDs.begin(), thisIDs.end());
-	std::sort(otherIDs.begin(), otherIDs.end());
-
-	std::set_intersection(thisIDs.begin(), thisIDs.end(), otherIDs.begin(),
-	                      otherIDs.end(), std::back_inserter(intersection));
-	return intersection;
+	if(cardinalities_.size() != nodeIDs_.size()) {
+		throw std::invalid_argument("In Factor::Factor, the number of "
+		                            "cardinalities does not match the number "
+		                            "of node identifiers");
+	}
+	observed_.resize(nodeIDs_.size(), -1);
+	computeStrides();
 }
 
-std::vector<unsigned int>
-Factor::getUnionOfIDs(const std::vector<unsigned int>& commonIDs,
-                      const Factor& factor) const
+void Factor::computeStrides()
 {
-	std::vector<unsigned int> uni = nodeIDs_;
-	for(auto& id : factor.getIDs()) {
-		if(std::find(commonIDs.begin(), commonIDs.end(), id) ==
-		   commonIDs.end()) {
-			uni.push_back(id);
-		}
+	strides_.resize(nodeIDs_.size());
+	size_t length = 1;
+	for(int i = nodeIDs_.size() - 1; i >= 0; i--) {
+		strides_[i] = length;
+		length *= cardinalities_[i];
 	}
-	return uni;
+	probabilities_.assign(length, 0.0f);
 }
 
 void Factor::normalize(){
 	if (probabilities_.size() > 1){
-		float probSum = 0.0f;
-		for (auto& v : probabilities_){
-			probSum+=v;
-		}
+		float probSum = FactorKernels::sum(probabilities_.data(), probabilities_.size());
 		if (probSum > 0.0f){
-			for (auto& v : probabilities_){
-				v = v / probSum;
-			}
+			FactorKernels::scale(probabilities_.data(), 1.0f / probSum,
+			                     probabilities_.size());
 		}
 	}
 }
 
-
-
-Factor Factor::product(Factor& factor, const Network& network_, const std::vector<int>& values)
+Factor Factor::product(const Factor& factor) const
 {
-	std::vector<unsigned int> commonIDs = getCommonIDs(factor);
-	std::vector<unsigned int> unionIDs = getUnionOfIDs(commonIDs, factor);
-	std::vector<unsigned int> uniqueIDs(unionIDs.begin() + nodeIDs_.size(),
-	                                    unionIDs.end());
-	int newFactorLength = 1;
-	for (auto& id : unionIDs){
-		if (values[id] == -1){
-			newFactorLength*=network_.getNode(id).getNumberOfUniqueValuesExcludingNA();
+	std::vector<unsigned int> unionIDs = nodeIDs_;
+	std::vector<unsigned int> unionCardinalities = cardinalities_;
+	std::vector<int> unionObserved(observed_.begin(), observed_.end());
+	// Strides of both factors with respect to the nodes of the new factor
+	ArenaVector<unsigned int> strides = strides_;
+	ArenaVector<unsigned int> otherStrides(nodeIDs_.size(), 0);
+	for(unsigned int j = 0; j < factor.nodeIDs_.size(); j++) {
+		auto it = std::find(nodeIDs_.begin(), nodeIDs_.end(), factor.nodeIDs_[j]);
+		if(it == nodeIDs_.end()) {
+			unionIDs.push_back(factor.nodeIDs_[j]);
+			unionCardinalities.push_back(factor.cardinalities_[j]);
+			unionObserved.push_back(factor.observed_[j]);
+			strides.push_back(0);
+			otherStrides.push_back(factor.strides_[j]);
+		} else {
+			unsigned int i = it - nodeIDs_.begin();
+			if(cardinalities_[i] != factor.cardinalities_[j]) {
+				throw std::invalid_argument(
+				    "In Factor::product, a node shared by both factors has "
+				    "different cardinalities");
+			}
+			otherStrides[i] = factor.strides_[j];
 		}
 	}
-	Factor newFactor(newFactorLength, unionIDs);
-	int counter = 0;
-	for (int i = 0; i< length_; i++){
-		for (int j = 0; j < factor.length_; j++){
-			bool valid = true;
-			for(auto& id : commonIDs) {
-				if(val_[getIndex(id)+i*nodeIDs_.size()] != factor.val_[factor.getIndex(id)+j*factor.nodeIDs_.size()]) {
-					valid = false;
-					break;
-				}
+	Factor newFactor(unionIDs, unionCardinalities, unionObserved);
+	// The trailing nodes in which each factor is either contiguous or constant
+	// form runs that are computed by a single kernel call
+	size_t run = 1;
+	int outer = unionIDs.size();
+	bool contiguous = true, constant = true;
+	bool otherContiguous = true, otherConstant = true;
+	for(; outer > 0; outer--) {
+		unsigned int i = outer - 1;
+		if(unionCardinalities[i] > 1) {
+			bool c = contiguous && strides[i] == run;
+			bool z = constant && strides[i] == 0;
+			bool otherC = otherContiguous && otherStrides[i] == run;
+			bool otherZ = otherConstant && otherStrides[i] == 0;
+			if(!(c || z) || !(otherC || otherZ)) {
+				break;
 			}
-			if(valid) {
-				for (unsigned int h = 0; h < nodeIDs_.size(); h++){
-					newFactor.val_[h+counter*unionIDs.size()]=val_[h+i*nodeIDs_.size()];
-				}
-				int h=nodeIDs_.size();
-				for (auto id : uniqueIDs){
-					newFactor.val_[h+counter*unionIDs.size()]=factor.val_[factor.getIndex(id)+j*factor.nodeIDs_.size()];
-					h++;
-				}	
-				newFactor.setProbability(getProbability(i) *
-				                         factor.getProbability(j),counter);
-				counter++;
+			contiguous = c;
+			constant = z;
+			otherContiguous = otherC;
+			otherConstant = otherZ;
+		}
+		run *= unionCardinalities[i];
+	}
+	ArenaVector<unsigned int> counter(outer, 0);
+	unsigned int index = 0;
+	unsigned int otherIndex = 0;
+	for(size_t start = 0; start < newFactor.probabilities_.size(); start += run) {
+		float* target = &newFactor.probabilities_[start];
+		const float* source = &probabilities_[index];
+		const float* otherSource = &factor.probabilities_[otherIndex];
+		if(contiguous && otherContiguous) {
+			FactorKernels::multiply(target, source, otherSource, run);
+		} else if(contiguous) {
+			FactorKernels::multiply(target, source, *otherSource, run);
+		} else {
+			FactorKernels::multiply(target, otherSource, *source, run);
+		}
+		for(int i = outer - 1; i >= 0; i--) {
+			if(++counter[i] < unionCardinalities[i]) {
+				index += strides[i];
+				otherIndex += otherStrides[i];
+				break;
 			}
+			index -= (unionCardinalities[i] - 1) * strides[i];
+			otherIndex -= (unionCardinalities[i] - 1) * otherStrides[i];
+			counter[i] = 0;
 		}
 	}
 	return newFactor;
 }
 
-Factor Factor::sumOut(unsigned int id, Network& network_,
-                      const std::vector<int>& values)
+Factor Factor::sumOut(unsigned int id) const
 {
-	unsigned int index = getIndex(id);
-	unsigned int jump = 1;
-	for(unsigned int i = index + 1; i < nodeIDs_.size(); i++) {
-		if(values[nodeIDs_[i]] == -1) {
-			jump *= network_.getNode(nodeIDs_[i])
-			            .getNumberOfUniqueValuesExcludingNA();
+	unsigned int position = getIndex(id);
+	std::vector<unsigned int> newIDs = nodeIDs_;
+	std::vector<unsigned int> newCardinalities = cardinalities_;
+	std::vector<int> newObserved(observed_.begin(), observed_.end());
+	newIDs.erase(newIDs.begin() + position);
+	newCardinalities.erase(newCardinalities.begin() + position);
+	newObserved.erase(newObserved.begin() + position);
+	Factor newFactor(newIDs, newCardinalities, newObserved);
+
+	// Entries are laid out as [outer][cardinality][inner]
+	size_t inner = strides_[position];
+	size_t cardinality = cardinalities_[position];
+	size_t outer = probabilities_.size() / (inner * cardinality);
+	if(inner == 1) {
+		for(size_t o = 0; o < outer; o++) {
+			newFactor.probabilities_[o] =
+			    FactorKernels::sum(&probabilities_[o * cardinality], cardinality);
 		}
+		return newFactor;
 	}
-	unsigned int jumptimes = 0;
-	unsigned int newFactorLength = length_;
-	unsigned int totalCombinations = jump;
-	if(values[id] == -1) {
-		jumptimes =
-		    network_.getNode(id).getNumberOfUniqueValuesExcludingNA() - 1;
-		totalCombinations*=network_.getNode(id).getNumberOfUniqueValuesExcludingNA();
-		newFactorLength = length_/(jumptimes+1);
+	for(size_t o = 0; o < outer; o++) {
+		for(size_t v = 0; v < cardinality; v++) {
+			FactorKernels::add(&newFactor.probabilities_[o * inner],
+			                   &probabilities_[(o * cardinality + v) * inner],
+			                   inner);
+		}
 	}
-	
+	return newFactor;
+}
+
+Factor Factor::maxOut(unsigned int id) const
+{
+	unsigned int position = getIndex(id);
 	std::vector<unsigned int> newIDs = nodeIDs_;
-	newIDs.erase(newIDs.begin() + index);
-	Factor newFactor(newFactorLength, newIDs);
-	// std::div only works for _signed_ integers, hence i is of type int
-	for (int i = 0; i < newFactorLength; i++) {
-		float prob = 0.0;
-		auto division = std::div(i, jump);
-		unsigned int old = division.rem + totalCombinations * division.quot;
-		for (unsigned int j = 0; j<=jumptimes; j++){
-			prob+=probabilities_[old+j*jump];
+	std::vector<unsigned int> newCardinalities = cardinalities_;
+	std::vector<int> newObserved(observed_.begin(), observed_.end());
+	newIDs.erase(newIDs.begin() + position);
+	newCardinalities.erase(newCardinalities.begin() + position);
+	newObserved.erase(newObserved.begin() + position);
+	Factor newFactor(newIDs, newCardinalities, newObserved);
+
+	// Same layout as in sumOut, probabilities are never negative
+	size_t inner = strides_[position];
+	size_t cardinality = cardinalities_[position];
+	size_t outer = probabilities_.size() / (inner * cardinality);
+	for(size_t o = 0; o < outer; o++) {
+		for(size_t v = 0; v < cardinality; v++) {
+			FactorKernels::maximum(&newFactor.probabilities_[o * inner],
+			                       &probabilities_[(o * cardinality + v) * inner],
+			                       inner);
+		}
+	}
+	return newFactor;
+}
+
+Factor Factor::marginalise(const std::vector<unsigned int>& ids) const
+{
+	Factor newFactor = *this;
+	for(auto& id : nodeIDs_) {
+		if(std::find(ids.begin(), ids.end(), id) == ids.end()) {
+			newFactor = newFactor.sumOut(id);
 		}
-		for (unsigned int c = 0; c < nodeIDs_.size(); c++){
-				unsigned int d = c;
-				if (c != index){
-					if (c > index){
-						d = c - 1;
-					}
-					newFactor.val_[d+i*newIDs.size()]=val_[c+old*nodeIDs_.size()];
-				}
-			}
-			newFactor.setProbability(prob,i);	
 	}
 	return newFactor;
 }
@@ -233,7 +255,12 @@ unsigned int Factor::getIndex(unsigned int id) const
 
 const std::vector<unsigned int>& Factor::getIDs() const { return nodeIDs_; }
 
-void Factor::addProbability(float prob) { probabilities_.push_back(prob); }
+const std::vector<unsigned int>& Factor::getCardinalities() const
+{
+	return cardinalities_;
+}
+
+size_t Factor::size() const { return probabilities_.size(); }
 
 void Factor::setProbability(float prob, unsigned int index)
 {
@@ -247,22 +274,24 @@ float Factor::getProbability(unsigned int index) const
 
 float Factor::getProbability(const std::vector<int>& values) const
 {
-	for(int i = 0; i< length_; i++){
-		if (nodeIDs_.size() > 0){
-			bool flag = true;
-			for (unsigned int j = 0; j < nodeIDs_.size(); j++){
-				if (val_[j+i*nodeIDs_.size()] != values[nodeIDs_[j]]){
-					flag = false;
-					break;
-				}
-			}
-			if (flag){
-				return probabilities_[i];
+	if(nodeIDs_.empty()) {
+		return 1.0f;
+	}
+	size_t index = 0;
+	for(unsigned int i = 0; i < nodeIDs_.size(); i++) {
+		int value = values[nodeIDs_[i]];
+		if(observed_[i] != -1) {
+			if(value != observed_[i]) {
+				return 1.0f;
 			}
+		} else if(value < 0 ||
+		          static_cast<unsigned int>(value) >= cardinalities_[i]) {
+			return 1.0f;
+		} else {
+			index += strides_[i] * value;
 		}
 	}
-
-	return 1.0f;
+	return probabilities_[index];
 }
 
 std::ostream& operator<<(std::ostream& os, const Factor& f)
@@ -274,13 +303,15 @@ std::ostream& operator<<(std::ostream& os, const Factor& f)
 	}
 	os << "\n"
 	   << "Table:" << std::endl;
-	for(int i = 0; i < f.length_; i++) {
-		for (unsigned int j = 0; j < f.nodeIDs_.size(); j++){
-			os << f.val_[j+i*f.nodeIDs_.size()]<< " ";
+	for(size_t index = 0; index < f.probabilities_.size(); index++) {
+		for(unsigned int j = 0; j < f.nodeIDs_.size(); j++) {
+			if(f.observed_[j] != -1) {
+				os << f.observed_[j] << " ";
+			} else {
+				os << (index / f.strides_[j]) % f.cardinalities_[j] << " ";
+			}
 		}
-		os << f.probabilities_[i] << std::endl;
-		;
+		os << f.probabilities_[index] << std::endl;
 	}
 	return os;
 }
-
@@ -1,29 +1,46 @@
 #ifndef FACTOR_H
 #define FACTOR_H
 
-#include "Network.h"
-
+#include "Node.h"
+#include "QueryArena.h"
+
+/*
+ * A Factor is a dense table over a set of nodes. The probabilities are stored
+ * in row-major order with respect to the node identifiers, i.e. the value of
+ * the last node changes fastest. Instead of storing the value assignment of
+ * every row, only the cardinality and the stride of each node are kept, hence
+ * the position of an assignment is computed using mixed-radix arithmetic.
+ * Observed nodes stay part of the factor, but have a cardinality of one.
+ * The probabilities and all temporaries of the factor operations are taken
+ * from the current QueryArena of the thread, if there is one.
+ */
 class Factor{
 	public:
 	/**Factor
 	 *
 	 * @param n, a const reference to a node
 	 * @param values, a const reference to known values of the nodes
-	 * 
-	 * @return a Factor object
 	 *
+	 * @return the factor of the CPT of the node reduced by the known values.
+	 * The entries are gathered directly from the CPT storage, hence the
+	 * construction is linear in the size of the reduced factor.
+	 *
+	 * @throw invalid_argument if a known value is out of range
 	 */
 	Factor(const Node& n, const std::vector<int>& values);
 
 	/**Factor
 	 *
-	 * @param length, number of different value combinations represented by the factor
 	 * @param ids, vector of node identifiers represented by the factor
-	 * 
-	 * @return a Factor object
+	 * @param cardinalities, number of values per node represented by the factor
+	 * @param observed, observed value per node, -1 if the node is not observed (optional)
+	 *
+	 * @return a Factor object, all probabilities are initialised with 0.0
 	 *
 	 */
-	Factor(unsigned int length, std::vector<unsigned int> ids);
+	Factor(const std::vector<unsigned int>& ids,
+	       const std::vector<unsigned int>& cardinalities,
+	       const std::vector<int>& observed = {});
 
 	/**getIDs
 	 *
@@ -32,22 +49,25 @@ class Factor{
 	 */
 	const std::vector<unsigned int>& getIDs() const ;
 
-	/**addProbability
+	/**getCardinalities
+	 *
+	 * @return vector containing the number of values per node of the factor
 	 *
-	 * @param
-	 * @param
-	 * 
-	 * @return
+	 */
+	const std::vector<unsigned int>& getCardinalities() const;
+
+	/**size
 	 *
+	 * @return number of different value combinations represented by the factor
 	 *
 	 */
-	void addProbability(float prob);
+	size_t size() const;
 
 	/**setProbability
 	 *
 	 * @param prob, probability to set
 	 * @param index, position in the factor
-	 * 
+	 *
 	 * Stores the given probability at the given position in the factor
 	 */
 	void setProbability(float prob, unsigned int index);
@@ -55,7 +75,7 @@ class Factor{
 	/**getProbability
 	 *
 	 * @param index, position in the factor
-	 * 
+	 *
 	 * @return Probability at the given position
 	 *
 	 */
@@ -63,19 +83,18 @@ class Factor{
 
 	/**getProbability
 	 *
-	 * @param
-	 * @param
-	 * 
-	 * @return
+	 * @param values, vector of node values indexed by node identifier
 	 *
+	 * @return Probability of the given value assignment, 1.0 if the assignment
+	 * is not represented by this factor
 	 *
 	 */
 	float getProbability(const std::vector<int>& values) const;
-	
+
 	/**getIndex
 	 *
 	 * @param index, identifier of the node of interest
-	 * 
+	 *
 	 * @return position of the node specified with index in the node identifier list
 	 *
 	 */
@@ -83,26 +102,42 @@ class Factor{
 
 	/**product
 	 *
-	 * @param factor, a reference to the Factor to form the product with
-	 * @param network_, a const reference to the network
-	 * @param values, a const reference to a vector containing known values for the nodes
-	 * 
+	 * @param factor, a const reference to the Factor to form the product with
+	 *
 	 * @return a new Factor representing the product of the former two
 	 *
-	 * Performs a product operation on two factors
+	 * Performs a product operation on two factors. The runtime is linear in
+	 * the size of the resulting factor.
 	 */
-	Factor product(Factor& factor,const Network& network_, const std::vector<int>& values);
+	Factor product(const Factor& factor) const;
 
 	/**sumOut
 	 *
 	 * @param id, identifier of the node to be summed out
-	 * @param network_, a reference to the network
-	 * @param values, a reference to a vector containing known values for the nodes
 	 *
 	 * @return a new Factor representing the result of summing out the node with the given id
 	 *
 	 */
-	Factor sumOut(unsigned int id, Network& network_, const std::vector<int>& values);
+	Factor sumOut(unsigned int id) const;
+
+	/**maxOut
+	 *
+	 * @param id, identifier of the node to be maximised out
+	 *
+	 * @return a new Factor containing, for every assignment of the remaining nodes,
+	 * the maximal probability over all values of the node with the given id
+	 *
+	 */
+	Factor maxOut(unsigned int id) const;
+
+	/**marginalise
+	 *
+	 * @param ids, identifiers of the nodes to keep
+	 *
+	 * @return a new Factor in which all nodes not contained in ids are summed out
+	 *
+	 */
+	Factor marginalise(const std::vector<unsigned int>& ids) const;
 
 	/**normalize
 	 *
@@ -114,45 +149,36 @@ class Factor{
 	 *
 	 * @param os, ostream reference
 	 * @param f, const reference to a Factor
-	 * 
+	 *
 	 * @return ostream
 	 *
 	 * Ostream operator implementation for a factor
 	 */
 	friend std::ostream& operator<< (std::ostream& os,const Factor& f);
-	
-	private:
 
-	/**getUnionOfIDs
-	 *
-	 * @param commonIDs, common ids between this factor and the factor to form the union with
-	 * @param factor, a reference to the factor to join ids with
-	 * 
-	 * @return vector containing the union of IDs
-	 *
-	 */
-	std::vector<unsigned int> getUnionOfIDs(const std::vector<unsigned int>& commonIDs, const Factor& factor) const;
+	private:
 
-	/**getCommonIDs
-	 *
-	 * @param factor, Factor to find common IDs 
-	 * 
-	 * @return vector containing common ids between this and the given factor
+	/**computeStrides
 	 *
+	 * Computes the strides of all nodes and resizes the probability vector
+	 * according to the cardinalities
 	 */
-	std::vector<unsigned int> getCommonIDs(const Factor& factor) const;
+	void computeStrides();
 
-	//Vector of node identifieres contained in this node
+	//Vector of node identifieres contained in this factor
 	std::vector<unsigned int> nodeIDs_;
 
-	//Vector representing the values of the represented nodes
-	std::vector<int> val_;
+	//Number of values per node, observed nodes have a cardinality of one
+	std::vector<unsigned int> cardinalities_;
 
-	//vector containing the probabilities of the factor
-	std::vector<float> probabilities_;
+	//Distance between two consecutive values of a node in probabilities_
+	ArenaVector<unsigned int> strides_;
+
+	//Observed value per node, -1 if the node is not observed
+	ArenaVector<int> observed_;
 
-	//Number of different value combinations contained in the factor
-	int length_;
+	//vector containing the probabilities of the factor
+	ArenaVector<float> probabilities_;
 };
 
 #endif
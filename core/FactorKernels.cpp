@@ -0,0 +1,296 @@
+#include "FactorKernels.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FACTORKERNELS_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+struct KernelTable {
+	InstructionSet set;
+	void (*multiply)(float*, const float*, const float*, size_t);
+	void (*multiplyBroadcast)(float*, const float*, float, size_t);
+	void (*add)(float*, const float*, size_t);
+	void (*maximum)(float*, const float*, size_t);
+	float (*sum)(const float*, size_t);
+	void (*scale)(float*, float, size_t);
+};
+
+void multiplyScalar(float* target, const float* a, const float* b, size_t n)
+{
+	for(size_t i = 0; i < n; i++) {
+		target[i] = a[i] * b[i];
+	}
+}
+
+void multiplyBroadcastScalar(float* target, const float* a, float b, size_t n)
+{
+	for(size_t i = 0; i < n; i++) {
+		target[i] = a[i] * b;
+	}
+}
+
+void addScalar(float* target, const float* source, size_t n)
+{
+	for(size_t i = 0; i < n; i++) {
+		target[i] += source[i];
+	}
+}
+
+void maximumScalar(float* target, const float* source, size_t n)
+{
+	for(size_t i = 0; i < n; i++) {
+		target[i] = std::max(target[i], source[i]);
+	}
+}
+
+float sumScalar(const float* source, size_t n)
+{
+	float result = 0.0f;
+	for(size_t i = 0; i < n; i++) {
+		result += source[i];
+	}
+	return result;
+}
+
+void scaleScalar(float* target, float factor, size_t n)
+{
+	for(size_t i = 0; i < n; i++) {
+		target[i] *= factor;
+	}
+}
+
+#ifdef FACTORKERNELS_X86
+
+__attribute__((target("sse2"))) void
+multiplySSE2(float* target, const float* a, const float* b, size_t n)
+{
+	size_t i = 0;
+	for(; i + 4 <= n; i += 4) {
+		_mm_storeu_ps(target + i,
+		              _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+	}
+	multiplyScalar(target + i, a + i, b + i, n - i);
+}
+
+__attribute__((target("sse2"))) void
+multiplyBroadcastSSE2(float* target, const float* a, float b, size_t n)
+{
+	__m128 factor = _mm_set1_ps(b);
+	size_t i = 0;
+	for(; i + 4 <= n; i += 4) {
+		_mm_storeu_ps(target + i, _mm_mul_ps(_mm_loadu_ps(a + i), factor));
+	}
+	multiplyBroadcastScalar(target + i, a + i, b, n - i);
+}
+
+__attribute__((target("sse2"))) void
+addSSE2(float* target, const float* source, size_t n)
+{
+	size_t i = 0;
+	for(; i + 4 <= n; i += 4) {
+		_mm_storeu_ps(target + i, _mm_add_ps(_mm_loadu_ps(target + i),
+		                                     _mm_loadu_ps(source + i)));
+	}
+	addScalar(target + i, source + i, n - i);
+}
+
+__attribute__((target("sse2"))) void
+maximumSSE2(float* target, const float* source, size_t n)
+{
+	size_t i = 0;
+	for(; i + 4 <= n; i += 4) {
+		_mm_storeu_ps(target + i, _mm_max_ps(_mm_loadu_ps(target + i),
+		                                     _mm_loadu_ps(source + i)));
+	}
+	maximumScalar(target + i, source + i, n - i);
+}
+
+__attribute__((target("sse2"))) float horizontalSumSSE2(__m128 v)
+{
+	v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+	v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+	return _mm_cvtss_f32(v);
+}
+
+__attribute__((target("sse2"))) float sumSSE2(const float* source, size_t n)
+{
+	__m128 acc = _mm_setzero_ps();
+	size_t i = 0;
+	for(; i + 4 <= n; i += 4) {
+		acc = _mm_add_ps(acc, _mm_loadu_ps(source + i));
+	}
+	return horizontalSumSSE2(acc) + sumScalar(source + i, n - i);
+}
+
+__attribute__((target("sse2"))) void
+scaleSSE2(float* target, float factor, size_t n)
+{
+	__m128 f = _mm_set1_ps(factor);
+	size_t i = 0;
+	for(; i + 4 <= n; i += 4) {
+		_mm_storeu_ps(target + i, _mm_mul_ps(_mm_loadu_ps(target + i), f));
+	}
+	scaleScalar(target + i, factor, n - i);
+}
+
+__attribute__((target("avx2"))) void
+multiplyAVX2(float* target, const float* a, const float* b, size_t n)
+{
+	size_t i = 0;
+	for(; i + 8 <= n; i += 8) {
+		_mm256_storeu_ps(target + i, _mm256_mul_ps(_mm256_loadu_ps(a + i),
+		                                           _mm256_loadu_ps(b + i)));
+	}
+	multiplySSE2(target + i, a + i, b + i, n - i);
+}
+
+__attribute__((target("avx2"))) void
+multiplyBroadcastAVX2(float* target, const float* a, float b, size_t n)
+{
+	__m256 factor = _mm256_set1_ps(b);
+	size_t i = 0;
+	for(; i + 8 <= n; i += 8) {
+		_mm256_storeu_ps(target + i, _mm256_mul_ps(_mm256_loadu_ps(a + i), factor));
+	}
+	multiplyBroadcastSSE2(target + i, a + i, b, n - i);
+}
+
+__attribute__((target("avx2"))) void
+addAVX2(float* target, const float* source, size_t n)
+{
+	size_t i = 0;
+	for(; i + 8 <= n; i += 8) {
+		_mm256_storeu_ps(target + i, _mm256_add_ps(_mm256_loadu_ps(target + i),
+		                                           _mm256_loadu_ps(source + i)));
+	}
+	addSSE2(target + i, source + i, n - i);
+}
+
+__attribute__((target("avx2"))) void
+maximumAVX2(float* target, const float* source, size_t n)
+{
+	size_t i = 0;
+	for(; i + 8 <= n; i += 8) {
+		_mm256_storeu_ps(target + i, _mm256_max_ps(_mm256_loadu_ps(target + i),
+		                                           _mm256_loadu_ps(source + i)));
+	}
+	maximumSSE2(target + i, source + i, n - i);
+}
+
+__attribute__((target("avx2"))) float sumAVX2(const float* source, size_t n)
+{
+	__m256 acc = _mm256_setzero_ps();
+	size_t i = 0;
+	for(; i + 8 <= n; i += 8) {
+		acc = _mm256_add_ps(acc, _mm256_loadu_ps(source + i));
+	}
+	__m128 half = _mm_add_ps(_mm256_castps256_ps128(acc),
+	                         _mm256_extractf128_ps(acc, 1));
+	return horizontalSumSSE2(half) + sumSSE2(source + i, n - i);
+}
+
+__attribute__((target("avx2"))) void
+scaleAVX2(float* target, float factor, size_t n)
+{
+	__m256 f = _mm256_set1_ps(factor);
+	size_t i = 0;
+	for(; i + 8 <= n; i += 8) {
+		_mm256_storeu_ps(target + i, _mm256_mul_ps(_mm256_loadu_ps(target + i), f));
+	}
+	scaleSSE2(target + i, factor, n - i);
+}
+
+#endif
+
+KernelTable createTable(InstructionSet set)
+{
+	switch(set) {
+#ifdef FACTORKERNELS_X86
+		case InstructionSet::AVX2:
+			return {set, multiplyAVX2, multiplyBroadcastAVX2, addAVX2,
+			        maximumAVX2, sumAVX2, scaleAVX2};
+		case InstructionSet::SSE2:
+			return {set, multiplySSE2, multiplyBroadcastSSE2, addSSE2,
+			        maximumSSE2, sumSSE2, scaleSSE2};
+#endif
+		default:
+			return {InstructionSet::Scalar, multiplyScalar,
+			        multiplyBroadcastScalar, addScalar, maximumScalar,
+			        sumScalar, scaleScalar};
+	}
+}
+
+InstructionSet detectInstructionSet()
+{
+#ifdef FACTORKERNELS_X86
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx2")) {
+		return InstructionSet::AVX2;
+	}
+	if(__builtin_cpu_supports("sse2")) {
+		return InstructionSet::SSE2;
+	}
+#endif
+	return InstructionSet::Scalar;
+}
+
+KernelTable& table()
+{
+	static KernelTable kernels = createTable(detectInstructionSet());
+	return kernels;
+}
+
+}
+
+InstructionSet FactorKernels::getInstructionSet() { return table().set; }
+
+InstructionSet FactorKernels::getSupportedInstructionSet()
+{
+	static const InstructionSet supported = detectInstructionSet();
+	return supported;
+}
+
+void FactorKernels::setInstructionSet(InstructionSet set)
+{
+	if(static_cast<int>(set) > static_cast<int>(getSupportedInstructionSet())) {
+		throw std::invalid_argument(
+		    "The requested instruction set is not supported by this CPU");
+	}
+	table() = createTable(set);
+}
+
+void FactorKernels::multiply(float* target, const float* a, const float* b,
+                             size_t n)
+{
+	table().multiply(target, a, b, n);
+}
+
+void FactorKernels::multiply(float* target, const float* a, float b, size_t n)
+{
+	table().multiplyBroadcast(target, a, b, n);
+}
+
+void FactorKernels::add(float* target, const float* source, size_t n)
+{
+	table().add(target, source, n);
+}
+
+void FactorKernels::maximum(float* target, const float* source, size_t n)
+{
+	table().maximum(target, source, n);
+}
+
+float FactorKernels::sum(const float* source, size_t n)
+{
+	return table().sum(source, n);
+}
+
+void FactorKernels::scale(float* target, float factor, size_t n)
+{
+	table().scale(target, factor, n);
+}
@@ -0,0 +1,89 @@
+#ifndef FACTORKERNELS_H
+#define FACTORKERNELS_H
+
+#include <cstddef>
+
+enum class InstructionSet { Scalar, SSE2, AVX2 };
+
+/*
+ * Contiguous float loops used by the Factor class. On x86 processors the
+ * widest instruction set supported by the CPU is selected at runtime, on all
+ * other platforms the scalar implementation is used.
+ */
+class FactorKernels{
+	public:
+	/**getInstructionSet
+	 *
+	 * @return the instruction set currently used by the kernels
+	 */
+	static InstructionSet getInstructionSet();
+
+	/**getSupportedInstructionSet
+	 *
+	 * @return the widest instruction set supported by the CPU
+	 */
+	static InstructionSet getSupportedInstructionSet();
+
+	/**setInstructionSet
+	 *
+	 * @param set, the instruction set to use
+	 *
+	 * Selects the kernels of the given instruction set. This is meant for
+	 * tests and benchmarks and must not be called while factors are computed.
+	 * Throws an invalid_argument exception if the CPU does not support the set.
+	 */
+	static void setInstructionSet(InstructionSet set);
+
+	/**multiply
+	 *
+	 * @param target, array of n elements receiving a[i] * b[i]
+	 * @param a, array of n elements
+	 * @param b, array of n elements
+	 * @param n, number of elements
+	 */
+	static void multiply(float* target, const float* a, const float* b, size_t n);
+
+	/**multiply
+	 *
+	 * @param target, array of n elements receiving a[i] * b
+	 * @param a, array of n elements
+	 * @param b, value broadcast to all elements
+	 * @param n, number of elements
+	 */
+	static void multiply(float* target, const float* a, float b, size_t n);
+
+	/**add
+	 *
+	 * @param target, array of n elements to which source is added
+	 * @param source, array of n elements
+	 * @param n, number of elements
+	 */
+	static void add(float* target, const float* source, size_t n);
+
+	/**maximum
+	 *
+	 * @param target, array of n elements receiving max(target[i], source[i])
+	 * @param source, array of n elements
+	 * @param n, number of elements
+	 */
+	static void maximum(float* target, const float* source, size_t n);
+
+	/**sum
+	 *
+	 * @param source, array of n elements
+	 * @param n, number of elements
+	 *
+	 * @return the sum of all elements
+	 */
+	static float sum(const float* source, size_t n);
+
+	/**scale
+	 *
+	 * @param target, array of n elements which are multiplied by factor
+	 * @param factor, the scaling factor
+	 * @param n, number of elements
+	 */
+	static void scale(float* target, float factor, size_t n);
+};
+
+#endif
@@ -0,0 +1,393 @@
+#include "GibbsSampler.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <exception>
+#include <limits>
+#include <random>
+#include <stdexcept>
+
+namespace {
+
+struct TableNode {
+	unsigned int id;
+	std::vector<unsigned int> parents;
+	std::vector<unsigned int> factors;
+	unsigned int cardinality;
+	// Position of the first CPT entry in the flat table
+	size_t offset;
+	// Value of a condition node, -1 for sampled nodes
+	int value;
+};
+
+// A CPT in the Markov blanket of a node. Changing the value of the node by
+// one moves the entry of the CPT by stride.
+struct BlanketEntry {
+	unsigned int node;
+	size_t stride;
+};
+
+struct ChainModel {
+	// The ancestors of the query and condition nodes in topological order
+	std::vector<TableNode> nodes;
+	// The CPT entries of all nodes, row by row
+	std::vector<float> probabilities;
+	// Positions of the unobserved nodes in nodes and their Markov blankets
+	std::vector<unsigned int> variables;
+	std::vector<std::vector<BlanketEntry>> blankets;
+	std::vector<std::pair<unsigned int, int>> query;
+	size_t networkSize;
+};
+
+struct Chain {
+	std::mt19937_64 rng;
+	std::vector<int> values;
+	size_t samples = 0;
+	double hits = 0.0;
+	// Mean of the query indicator for every check interval
+	std::vector<double> batchMeans;
+};
+
+ChainModel createModel(const Network& network,
+                       const std::vector<unsigned int>& queryNodes,
+                       const std::vector<unsigned int>& conditionNodes,
+                       const std::vector<int>& queryValues,
+                       const std::vector<int>& conditionValues)
+{
+	ChainModel model;
+	model.networkSize = network.size();
+	std::vector<bool> observed(network.size(), false);
+	for(unsigned int id : conditionNodes) {
+		observed[id] = true;
+	}
+	for(unsigned int id : queryNodes) {
+		if(queryValues[id] == -1) {
+			throw std::invalid_argument(
+			    "The current node does not contain the query value");
+		}
+		model.query.push_back(std::make_pair(id, queryValues[id]));
+	}
+	std::vector<unsigned int> nodes(conditionNodes);
+	nodes.insert(nodes.end(), queryNodes.begin(), queryNodes.end());
+
+	std::vector<int> position(network.size(), -1);
+	for(unsigned int id : network.getAncestralOrder(nodes)) {
+		const Node& n = network.getNode(id);
+		const auto& probMatrix = n.getProbabilityMatrix();
+		TableNode node;
+		node.id = id;
+		node.parents = n.getParents();
+		for(unsigned int i = 0; i < node.parents.size(); i++) {
+			node.factors.push_back(n.getFactor(i));
+		}
+		node.cardinality = probMatrix.getColCount();
+		node.offset = model.probabilities.size();
+		node.value = observed[id] ? conditionValues[id] : -1;
+		// Nodes without parents, e.g. after a do-intervention, use the first row
+		size_t rows = node.parents.empty() ? 1 : probMatrix.getRowCount();
+		for(size_t row = 0; row < rows; row++) {
+			for(unsigned int col = 0; col < node.cardinality; col++) {
+				model.probabilities.push_back(probMatrix(col, row));
+			}
+		}
+		position[id] = model.nodes.size();
+		model.nodes.push_back(node);
+	}
+
+	// The Markov blanket consists of the CPT of the node and of its children
+	std::vector<std::vector<BlanketEntry>> blankets(model.nodes.size());
+	for(unsigned int i = 0; i < model.nodes.size(); i++) {
+		const TableNode& node = model.nodes[i];
+		blankets[i].push_back(BlanketEntry{i, 1});
+		for(unsigned int p = 0; p < node.parents.size(); p++) {
+			blankets[position[node.parents[p]]].push_back(
+			    BlanketEntry{i, node.factors[p] * node.cardinality});
+		}
+	}
+	for(unsigned int i = 0; i < model.nodes.size(); i++) {
+		if(model.nodes[i].value == -1) {
+			model.variables.push_back(i);
+			model.blankets.push_back(std::move(blankets[i]));
+		}
+	}
+	return model;
+}
+
+/**getEntry
+ *
+ * @return the position of the CPT entry of the node for the current values
+ */
+size_t getEntry(const ChainModel& model, unsigned int i,
+                const std::vector<int>& values)
+{
+	const TableNode& node = model.nodes[i];
+	size_t row = 0;
+	for(unsigned int p = 0; p < node.parents.size(); p++) {
+		row += node.factors[p] * values[node.parents[p]];
+	}
+	return node.offset + row * node.cardinality + values[node.id];
+}
+
+/**initialiseChain
+ *
+ * Forward samples the unobserved nodes until the state has a positive
+ * probability given the conditions.
+ */
+void initialiseChain(const ChainModel& model, Chain& chain)
+{
+	std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+	chain.values.assign(model.networkSize, -1);
+	for(unsigned int attempt = 0; attempt < 1000; attempt++) {
+		float probability = 1.0f;
+		for(unsigned int i = 0; i < model.nodes.size(); i++) {
+			const TableNode& node = model.nodes[i];
+			if(node.value != -1) {
+				chain.values[node.id] = node.value;
+				probability *= model.probabilities[getEntry(model, i, chain.values)];
+				continue;
+			}
+			chain.values[node.id] = 0;
+			size_t base = getEntry(model, i, chain.values);
+			float rowSum = 0.0f;
+			for(unsigned int col = 0; col < node.cardinality; col++) {
+				rowSum += model.probabilities[base + col];
+			}
+			float u = uniform(chain.rng) * rowSum;
+			unsigned int col = 0;
+			for(; col + 1 < node.cardinality; col++) {
+				u -= model.probabilities[base + col];
+				if(u < 0.0f) {
+					break;
+				}
+			}
+			chain.values[node.id] = col;
+		}
+		if(probability > 0.0f) {
+			return;
+		}
+	}
+	throw std::invalid_argument(
+	    "No state consistent with the conditions was found");
+}
+
+/**sweep
+ *
+ * Resamples every unobserved node once given its Markov blanket
+ */
+void sweep(const ChainModel& model, Chain& chain,
+           std::vector<float>& distribution)
+{
+	std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+	for(unsigned int v = 0; v < model.variables.size(); v++) {
+		const TableNode& node = model.nodes[model.variables[v]];
+		const auto& blanket = model.blankets[v];
+		int current = chain.values[node.id];
+		distribution.assign(node.cardinality, 1.0f);
+		for(const auto& entry : blanket) {
+			size_t base = getEntry(model, entry.node, chain.values) -
+			              entry.stride * current;
+			for(unsigned int col = 0; col < node.cardinality; col++) {
+				distribution[col] *= model.probabilities[base + entry.stride * col];
+			}
+		}
+		float sum = 0.0f;
+		for(float p : distribution) {
+			sum += p;
+		}
+		if(sum <= 0.0f) {
+			continue;
+		}
+		float u = uniform(chain.rng) * sum;
+		unsigned int col = 0;
+		for(; col + 1 < node.cardinality; col++) {
+			u -= distribution[col];
+			if(u < 0.0f) {
+				break;
+			}
+		}
+		chain.values[node.id] = col;
+	}
+}
+
+/**runChains
+ *
+ * Runs the given number of sweeps on every chain in parallel and records the
+ * query indicator if requested
+ */
+void runChains(const ChainModel& model, std::vector<Chain>& chains,
+               size_t sweeps, bool record)
+{
+	std::atomic<unsigned int> finished(0);
+	std::vector<std::exception_ptr> errors(chains.size());
+	ThreadPool& pool = ThreadPool::getGlobalPool();
+	for(unsigned int c = 0; c < chains.size(); c++) {
+		pool.submit([&, c]() {
+			try {
+				Chain& chain = chains[c];
+				std::vector<float> distribution;
+				double hits = 0.0;
+				for(size_t s = 0; s < sweeps; s++) {
+					sweep(model, chain, distribution);
+					bool hit = true;
+					for(const auto& q : model.query) {
+						hit = hit && chain.values[q.first] == q.second;
+					}
+					hits += hit ? 1.0 : 0.0;
+				}
+				if(record && sweeps > 0) {
+					chain.samples += sweeps;
+					chain.hits += hits;
+					chain.batchMeans.push_back(hits / sweeps);
+				}
+			} catch(...) {
+				errors[c] = std::current_exception();
+			}
+			finished++;
+		});
+	}
+	pool.waitUntil([&]() { return finished == chains.size(); });
+	for(const auto& error : errors) {
+		if(error) {
+			std::rethrow_exception(error);
+		}
+	}
+}
+
+/**computeRHat
+ *
+ * @return the potential scale reduction factor of the query indicator
+ */
+double computeRHat(const std::vector<Chain>& chains)
+{
+	double n = chains[0].samples;
+	if(chains.size() < 2 || n < 2) {
+		return 1.0;
+	}
+	double mean = 0.0;
+	double within = 0.0;
+	for(const auto& chain : chains) {
+		double p = chain.hits / n;
+		mean += p;
+		within += n / (n - 1) * p * (1.0 - p);
+	}
+	mean /= chains.size();
+	within /= chains.size();
+	double between = 0.0;
+	for(const auto& chain : chains) {
+		double p = chain.hits / n;
+		between += (p - mean) * (p - mean);
+	}
+	between *= n / (chains.size() - 1);
+	// Without variance within the chains, every chain either never or always
+	// hits the query state. Chains that all agree have converged, a query
+	// state that was never reached is rejected by the caller.
+	if(within <= 0.0) {
+		return between <= 0.0 ? 1.0 : std::numeric_limits<double>::infinity();
+	}
+	double variance = (n - 1) / n * within + between / n;
+	return std::sqrt(variance / within);
+}
+
+}
+
+GibbsSampler::GibbsSampler(const Network& network)
+    : network_(network),
+      chains_(4),
+      burnIn_(500),
+      sweeps_(50000),
+      checkInterval_(500),
+      minSamples_(1000),
+      threshold_(1.01f),
+      seed_(5489u)
+{
+}
+
+void GibbsSampler::setNumberOfChains(unsigned int chains)
+{
+	if(chains == 0) {
+		throw std::invalid_argument("At least one chain is required");
+	}
+	chains_ = chains;
+}
+
+void GibbsSampler::setBurnIn(size_t sweeps) { burnIn_ = sweeps; }
+
+void GibbsSampler::setSampleBudget(size_t sweeps) { sweeps_ = sweeps; }
+
+void GibbsSampler::setConvergenceThreshold(float threshold,
+                                           size_t checkInterval)
+{
+	if(checkInterval == 0) {
+		throw std::invalid_argument("The check interval must be positive");
+	}
+	threshold_ = threshold;
+	checkInterval_ = checkInterval;
+}
+
+void GibbsSampler::setMinimumSamples(size_t sweeps) { minSamples_ = sweeps; }
+
+void GibbsSampler::setSeed(uint64_t seed) { seed_ = seed; }
+
+SamplingEstimate GibbsSampler::computeProbability(
+    const std::vector<unsigned int>& queryNodes,
+    const std::vector<unsigned int>& conditionNodes,
+    const std::vector<int>& queryValues,
+    const std::vector<int>& conditionValues) const
+{
+	if(sweeps_ == 0) {
+		throw std::invalid_argument("The sample budget must be positive");
+	}
+	ChainModel model = createModel(network_, queryNodes, conditionNodes,
+	                               queryValues, conditionValues);
+	std::vector<Chain> chains(chains_);
+	for(unsigned int c = 0; c < chains_; c++) {
+		std::seed_seq sequence{static_cast<uint32_t>(seed_),
+		                       static_cast<uint32_t>(seed_ >> 32), c};
+		chains[c].rng.seed(sequence);
+		initialiseChain(model, chains[c]);
+	}
+
+	runChains(model, chains, burnIn_, false);
+	double rHat = 1.0;
+	while(chains[0].samples < sweeps_) {
+		runChains(model, chains,
+		          std::min(checkInterval_, sweeps_ - chains[0].samples), true);
+		rHat = computeRHat(chains);
+		double hits = 0.0;
+		for(const auto& chain : chains) {
+			hits += chain.hits;
+		}
+		// A query state that was never reached gives no evidence of convergence
+		if(rHat <= threshold_ && chains[0].samples >= minSamples_ && hits > 0.0) {
+			break;
+		}
+	}
+
+	// Batch means over all chains
+	std::vector<double> batches;
+	double hits = 0.0;
+	size_t samples = 0;
+	for(const auto& chain : chains) {
+		batches.insert(batches.end(), chain.batchMeans.begin(),
+		               chain.batchMeans.end());
+		hits += chain.hits;
+		samples += chain.samples;
+	}
+	double p = hits / samples;
+	double variance = 0.0;
+	for(double batch : batches) {
+		variance += (batch - p) * (batch - p);
+	}
+	SamplingEstimate estimate;
+	estimate.probability = static_cast<float>(p);
+	estimate.standardError =
+	    batches.size() > 1
+	        ? static_cast<float>(std::sqrt(variance / (batches.size() - 1) /
+	                                       batches.size()))
+	        : 0.0f;
+	estimate.samples = samples;
+	estimate.rHat = static_cast<float>(rHat);
+	return estimate;
+}
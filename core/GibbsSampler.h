@@ -0,0 +1,135 @@
+#ifndef GIBBSSAMPLER_H
+#define GIBBSSAMPLER_H
+
+#include "SamplingHandler.h"
+
+/*
+ * Approximates conditional probabilities with Gibbs sampling. Several
+ * independent chains are run in parallel on the global thread pool. Every
+ * unobserved ancestor of the query and condition nodes is resampled from its
+ * distribution given its Markov blanket, which is the product of its own CPT
+ * and the CPTs of its children. The positions of these entries are
+ * precomputed, hence resampling a node only multiplies a few table entries.
+ * The chains are stopped as soon as the potential scale reduction factor
+ * (R-hat) of the query indicator drops below a threshold. Twin networks
+ * created by Network::createTwinNetwork are sampled like any other network.
+ */
+class GibbsSampler
+{
+	public:
+	/**GibbsSampler
+	 *
+	 * @param network, a reference to the network
+	 *
+	 * @return GibbsSampler object using 4 chains, 500 burn-in sweeps, at least
+	 * 1000 and at most 50000 sweeps per chain and an R-hat threshold of 1.01
+	 * checked every 500 sweeps
+	 */
+	explicit GibbsSampler(const Network& network);
+
+	GibbsSampler(const GibbsSampler& o)
+		: network_(o.network_),
+		  chains_(o.chains_),
+		  burnIn_(o.burnIn_),
+		  sweeps_(o.sweeps_),
+		  checkInterval_(o.checkInterval_),
+		  minSamples_(o.minSamples_),
+		  threshold_(o.threshold_),
+		  seed_(o.seed_)
+	{
+	}
+
+	/**GibbsSampler
+	 *
+	 * @param o, the GibbsSampler whose settings are copied
+	 * @param network, a reference to the network the new sampler works on
+	 *
+	 * @return a GibbsSampler object
+	 */
+	GibbsSampler(const GibbsSampler& o, const Network& network)
+		: network_(network),
+		  chains_(o.chains_),
+		  burnIn_(o.burnIn_),
+		  sweeps_(o.sweeps_),
+		  checkInterval_(o.checkInterval_),
+		  minSamples_(o.minSamples_),
+		  threshold_(o.threshold_),
+		  seed_(o.seed_)
+	{
+	}
+
+	GibbsSampler& operator=(const GibbsSampler&) = delete;
+	GibbsSampler& operator=(GibbsSampler&&) = delete;
+
+	/**setNumberOfChains
+	 *
+	 * @param chains, the number of independent chains, at least one
+	 *
+	 * R-hat can only detect a lack of convergence for two or more chains.
+	 */
+	void setNumberOfChains(unsigned int chains);
+
+	/**setBurnIn
+	 *
+	 * @param sweeps, the number of sweeps per chain that are discarded
+	 */
+	void setBurnIn(size_t sweeps);
+
+	/**setSampleBudget
+	 *
+	 * @param sweeps, the maximal number of recorded sweeps per chain
+	 */
+	void setSampleBudget(size_t sweeps);
+
+	/**setConvergenceThreshold
+	 *
+	 * @param threshold, the chains stop once R-hat is at most this value, 0
+	 * to always use the whole sample budget
+	 * @param checkInterval, the number of sweeps between two convergence checks
+	 */
+	void setConvergenceThreshold(float threshold, size_t checkInterval = 500);
+
+	/**setMinimumSamples
+	 *
+	 * @param sweeps, the number of recorded sweeps per chain before the chains
+	 * may stop early. The chains never stop early before the query state was
+	 * reached at least once.
+	 */
+	void setMinimumSamples(size_t sweeps);
+
+	/**setSeed
+	 *
+	 * @param seed, the seed of the random number streams of the chains
+	 */
+	void setSeed(uint64_t seed);
+
+	/**computeProbability
+	 *
+	 * @param queryNodes, identifiers of the query nodes
+	 * @param conditionNodes, identifiers of the condition nodes
+	 * @param queryValues, values of the query nodes, indexed by node identifier
+	 * @param conditionValues, values of the condition nodes, indexed by node identifier
+	 *
+	 * @return the estimated probability of the query values given the condition
+	 * values. The standard error is computed from the means of the sweeps
+	 * between two convergence checks (batch means). Throws an invalid_argument
+	 * exception if no state consistent with the conditions is found.
+	 */
+	SamplingEstimate computeProbability(
+	    const std::vector<unsigned int>& queryNodes,
+	    const std::vector<unsigned int>& conditionNodes,
+	    const std::vector<int>& queryValues,
+	    const std::vector<int>& conditionValues) const;
+
+	private:
+	const Network& network_;
+	unsigned int chains_;
+	size_t burnIn_;
+	size_t sweeps_;
+	size_t checkInterval_;
+	size_t minSamples_;
+	float threshold_;
+	uint64_t seed_;
+};
+
+#endif
@@ -0,0 +1,81 @@
+#include "InferenceSession.h"
+
+InferenceSession::InferenceSession(const Network& network,
+                                   EliminationHeuristic heuristic)
+    : network_(network), heuristic_(heuristic)
+{
+}
+
+void InferenceSession::start(const std::vector<int>& values)
+{
+	if(values.size() != network_.size()) {
+		throw std::invalid_argument("In InferenceSession::start, the number "
+		                            "of values differs from the network size");
+	}
+	QueryArena::Scope scope(nullptr);
+	tree_.reset(new JunctionTree(network_, heuristic_));
+	tree_->calibrate(values);
+}
+
+void InferenceSession::setEvidence(unsigned int id, int value)
+{
+	if(value == -1) {
+		throw std::invalid_argument(
+		    "In InferenceSession::setEvidence, use removeEvidence instead");
+	}
+	QueryArena::Scope scope(nullptr);
+	getTree().updateEvidence(id, value);
+}
+
+void InferenceSession::removeEvidence(unsigned int id)
+{
+	QueryArena::Scope scope(nullptr);
+	getTree().updateEvidence(id, -1);
+}
+
+const std::vector<int>& InferenceSession::getEvidence() const
+{
+	return getTree().getEvidence();
+}
+
+std::vector<float> InferenceSession::getPosterior(unsigned int id) const
+{
+	const JunctionTree& tree = getTree();
+	const Node& n = network_.getNode(id);
+	std::vector<float> posterior(n.getNumberOfUniqueValuesExcludingNA(), 0.0f);
+	int observed = tree.getEvidence()[id];
+	if(observed != -1) {
+		posterior[observed] = 1.0f;
+		return posterior;
+	}
+	QueryArena::Scope scope(nullptr);
+	Factor marginal = tree.getMarginal({id});
+	for(unsigned int value = 0; value < posterior.size(); value++) {
+		posterior[value] = marginal.getProbability(value);
+	}
+	return posterior;
+}
+
+float InferenceSession::getProbability(const std::vector<unsigned int>& nodes,
+                                       const std::vector<int>& values) const
+{
+	QueryArena::Scope scope(nullptr);
+	return getTree().getProbability(nodes, values);
+}
+
+size_t InferenceSession::getNumberOfSentMessages() const
+{
+	return getTree().getNumberOfSentMessages();
+}
+
+bool InferenceSession::isOpen() const { return tree_ != nullptr; }
+
+void InferenceSession::close() { tree_.reset(); }
+
+JunctionTree& InferenceSession::getTree() const
+{
+	if(!tree_) {
+		throw std::invalid_argument("The inference session is not started");
+	}
+	return *tree_;
+}
@@ -0,0 +1,116 @@
+#ifndef INFERENCESESSION_H
+#define INFERENCESESSION_H
+
+#include "JunctionTree.h"
+
+#include <memory>
+
+/*
+ * An interactive inference session on a network. Starting the session
+ * calibrates a junction tree with the initial evidence. Afterwards, evidence
+ * can be set, changed or removed one node at a time, only the part of the
+ * tree depending on the changed node is recalibrated. The session keeps a
+ * reference to the network, which must not be changed while the session is
+ * open. Factors of the session are allocated on the heap, hence the session
+ * may outlive any QueryArena.
+ */
+class InferenceSession{
+	public:
+	/**InferenceSession
+	 *
+	 * @param network, a const reference to the network
+	 * @param heuristic, the heuristic used to triangulate the moral graph
+	 *
+	 * @return an InferenceSession object, which is closed
+	 */
+	explicit InferenceSession(const Network& network,
+	    EliminationHeuristic heuristic = EliminationHeuristic::WeightedMinFill);
+
+	InferenceSession& operator=(const InferenceSession&) = delete;
+	InferenceSession& operator=(InferenceSession&&) = delete;
+
+	/**start
+	 *
+	 * @param values, vector containing the observed values, -1 for unobserved nodes
+	 *
+	 * Builds and calibrates the junction tree of the network, a running
+	 * session is restarted
+	 */
+	void start(const std::vector<int>& values);
+
+	/**setEvidence
+	 *
+	 * @param id, identifier of the node
+	 * @param value, the observed value of the node
+	 *
+	 * Adds or changes the observed value of one node and recalibrates the
+	 * affected part of the junction tree
+	 */
+	void setEvidence(unsigned int id, int value);
+
+	/**removeEvidence
+	 *
+	 * @param id, identifier of the node
+	 *
+	 * Removes the observed value of one node and recalibrates the affected
+	 * part of the junction tree
+	 */
+	void removeEvidence(unsigned int id);
+
+	/**getEvidence
+	 *
+	 * @return the observed values of the session, -1 for unobserved nodes
+	 */
+	const std::vector<int>& getEvidence() const;
+
+	/**getPosterior
+	 *
+	 * @param id, identifier of the node
+	 *
+	 * @return the probability of every value of the node given the evidence
+	 */
+	std::vector<float> getPosterior(unsigned int id) const;
+
+	/**getProbability
+	 *
+	 * @param nodes, identifiers of the query nodes
+	 * @param values, vector containing the values for the query nodes
+	 *
+	 * @return the probability of the given values given the evidence
+	 *
+	 * The nodes have to be contained in a single clique of the junction tree.
+	 */
+	float getProbability(const std::vector<unsigned int>& nodes,
+	                     const std::vector<int>& values) const;
+
+	/**getNumberOfSentMessages
+	 *
+	 * @return the number of messages computed since the session was started
+	 */
+	size_t getNumberOfSentMessages() const;
+
+	/**isOpen
+	 *
+	 * @return true if the session has been started and not closed
+	 */
+	bool isOpen() const;
+
+	/**close
+	 *
+	 * Releases the junction tree of the session
+	 */
+	void close();
+
+	private:
+	/**getTree
+	 *
+	 * @return the junction tree of the session, throws if the session is closed
+	 */
+	JunctionTree& getTree() const;
+
+	const Network& network_;
+	EliminationHeuristic heuristic_;
+	std::unique_ptr<JunctionTree> tree_;
+};
+
+#endif
@@ -35,12 +35,14 @@ void Interventions::reverseDoIntervention(const std::string& NodeName){
 	Network& network = controller_.getNetwork();
 	Node& n = network.getNode(NodeName);
 	n.loadBackupDoIntervention();
+	network.clearPriors();
 }
 
 void Interventions::reverseDoIntervention(int nodeID){
 	Network& network = controller_.getNetwork();
 	Node& n = network.getNode(nodeID);
 	n.loadBackupDoIntervention();
+	network.clearPriors();
 }
 
 void Interventions::addEdge(const std::string& source, const std::string& target){
@@ -0,0 +1,348 @@
+#include "JunctionTree.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+JunctionTree::JunctionTree(const Network& network, EliminationHeuristic heuristic)
+    : network_(network), sentMessages_(0)
+{
+	std::vector<unsigned int> nodes(network.size());
+	std::iota(nodes.begin(), nodes.end(), 0);
+	std::vector<int> values(network.size(), -1);
+	EliminationOrdering ordering(network, nodes, values);
+	ordering.getOrdering(nodes, heuristic);
+	// An elimination clique can only be contained in a clique created earlier
+	for(auto clique : ordering.getCliques()) {
+		std::sort(clique.begin(), clique.end());
+		bool maximal = true;
+		for(auto& other : cliques_) {
+			if(std::includes(other.begin(), other.end(), clique.begin(),
+			                 clique.end())) {
+				maximal = false;
+				break;
+			}
+		}
+		if(maximal) {
+			cliques_.push_back(clique);
+		}
+	}
+	connectCliques();
+	assignFactors();
+}
+
+void JunctionTree::connectCliques()
+{
+	neighbours_.assign(cliques_.size(), {});
+	parent_.assign(cliques_.size(), -1);
+	traversal_.clear();
+	if(cliques_.empty()) {
+		return;
+	}
+	// Prim's algorithm, separators may be empty if the network is not connected
+	std::vector<bool> inTree(cliques_.size(), false);
+	std::vector<int> weight(cliques_.size(), -1);
+	std::vector<int> link(cliques_.size(), -1);
+	weight[0] = 0;
+	for(unsigned int step = 0; step < cliques_.size(); step++) {
+		int next = -1;
+		for(unsigned int i = 0; i < cliques_.size(); i++) {
+			if(!inTree[i] && (next == -1 || weight[i] > weight[next])) {
+				next = i;
+			}
+		}
+		inTree[next] = true;
+		if(link[next] != -1) {
+			neighbours_[next].push_back(link[next]);
+			neighbours_[link[next]].push_back(next);
+		}
+		for(unsigned int i = 0; i < cliques_.size(); i++) {
+			if(!inTree[i]) {
+				std::vector<unsigned int> separator;
+				std::set_intersection(cliques_[next].begin(), cliques_[next].end(),
+				                      cliques_[i].begin(), cliques_[i].end(),
+				                      std::back_inserter(separator));
+				if(static_cast<int>(separator.size()) > weight[i]) {
+					weight[i] = separator.size();
+					link[i] = next;
+				}
+			}
+		}
+	}
+	// Depth first traversal starting at the first clique
+	std::vector<unsigned int> stack{0};
+	std::vector<bool> visited(cliques_.size(), false);
+	visited[0] = true;
+	while(!stack.empty()) {
+		unsigned int clique = stack.back();
+		stack.pop_back();
+		traversal_.push_back(clique);
+		for(auto& neighbour : neighbours_[clique]) {
+			if(!visited[neighbour]) {
+				visited[neighbour] = true;
+				parent_[neighbour] = clique;
+				stack.push_back(neighbour);
+			}
+		}
+	}
+}
+
+void JunctionTree::assignFactors()
+{
+	assignedNodes_.assign(cliques_.size(), {});
+	for(const Node& n : network_.getNodes()) {
+		std::vector<unsigned int> family{n.getID()};
+		family.insert(family.end(), n.getParents().begin(), n.getParents().end());
+		int clique = findClique(family);
+		if(clique == -1) {
+			throw std::invalid_argument("In JunctionTree::assignFactors, the "
+			                            "family of node " + n.getName() +
+			                            " is not contained in a clique");
+		}
+		assignedNodes_[clique].push_back(n.getID());
+	}
+}
+
+int JunctionTree::findClique(const std::vector<unsigned int>& nodes) const
+{
+	std::vector<unsigned int> sorted = nodes;
+	std::sort(sorted.begin(), sorted.end());
+	sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+	int result = -1;
+	size_t size = std::numeric_limits<size_t>::max();
+	for(unsigned int i = 0; i < cliques_.size(); i++) {
+		if(cliques_[i].size() < size &&
+		   std::includes(cliques_[i].begin(), cliques_[i].end(), sorted.begin(),
+		                 sorted.end())) {
+			result = i;
+			size = cliques_[i].size();
+		}
+	}
+	return result;
+}
+
+Factor JunctionTree::createPotential(unsigned int clique,
+                                     const std::vector<int>& values) const
+{
+	std::vector<unsigned int> cardinalities;
+	std::vector<int> observed;
+	for(auto& id : cliques_[clique]) {
+		if(values[id] == -1) {
+			cardinalities.push_back(
+			    network_.getNode(id).getNumberOfUniqueValuesExcludingNA());
+		} else {
+			cardinalities.push_back(1);
+		}
+		observed.push_back(values[id]);
+	}
+	Factor potential(cliques_[clique], cardinalities, observed);
+	for(unsigned int i = 0; i < potential.size(); i++) {
+		potential.setProbability(1.0f, i);
+	}
+	for(auto& id : assignedNodes_[clique]) {
+		potential = potential.product(Factor(network_.getNode(id), values));
+	}
+	return potential;
+}
+
+void JunctionTree::sendMessage(unsigned int from, unsigned int to)
+{
+	Factor message = potentials_[from];
+	for(auto& neighbour : neighbours_[from]) {
+		if(neighbour != to) {
+			message = message.product(messages_.at(std::make_pair(neighbour, from)));
+		}
+	}
+	std::vector<unsigned int> separator;
+	std::set_intersection(cliques_[from].begin(), cliques_[from].end(),
+	                      cliques_[to].begin(), cliques_[to].end(),
+	                      std::back_inserter(separator));
+	message = message.marginalise(separator);
+	double normalizer = 0.0;
+	for(size_t i = 0; i < message.size(); i++) {
+		normalizer += message.getProbability(i);
+	}
+	// Messages are normalized to avoid underflows, constant factors cancel out
+	if(message.size() == 1 && message.getProbability(0) > 0.0f) {
+		message.setProbability(1.0f, 0);
+	} else {
+		message.normalize();
+	}
+	auto key = std::make_pair(from, to);
+	messages_.erase(key);
+	messages_.emplace(key, message);
+	logNormalizers_[key] = std::log(normalizer);
+	sentMessages_++;
+}
+
+void JunctionTree::calibrate(const std::vector<int>& values)
+{
+	potentials_.clear();
+	messages_.clear();
+	logNormalizers_.clear();
+	values_ = values;
+	for(unsigned int i = 0; i < cliques_.size(); i++) {
+		potentials_.push_back(createPotential(i, values));
+	}
+	// Collect towards the root
+	for(auto it = traversal_.rbegin(); it != traversal_.rend(); ++it) {
+		if(parent_[*it] != -1) {
+			sendMessage(*it, parent_[*it]);
+		}
+	}
+	// Distribute from the root
+	for(auto& clique : traversal_) {
+		for(auto& neighbour : neighbours_[clique]) {
+			if(static_cast<int>(neighbour) != parent_[clique]) {
+				sendMessage(clique, neighbour);
+			}
+		}
+	}
+	std::vector<unsigned int> none;
+	beliefs_.assign(cliques_.size(), Factor(none, none));
+	beliefValid_.assign(cliques_.size(), false);
+}
+
+void JunctionTree::updateEvidence(unsigned int id, int value)
+{
+	if(!isCalibrated()) {
+		throw std::invalid_argument(
+		    "The junction tree has to be calibrated before updating it");
+	}
+	if(id >= values_.size() || value < -1 ||
+	   value >= static_cast<int>(
+	                network_.getNode(id).getNumberOfUniqueValuesExcludingNA())) {
+		throw std::invalid_argument("In JunctionTree::updateEvidence, the "
+		                            "node or the value is out of range");
+	}
+	if(values_[id] == value) {
+		return;
+	}
+	values_[id] = value;
+	// The cliques containing the node form a connected subtree
+	std::vector<bool> changed(cliques_.size(), false);
+	int root = -1;
+	for(unsigned int i = 0; i < cliques_.size(); i++) {
+		if(std::binary_search(cliques_[i].begin(), cliques_[i].end(), id)) {
+			changed[i] = true;
+			potentials_[i] = createPotential(i, values_);
+			root = (root == -1) ? i : root;
+		}
+	}
+	if(root == -1) {
+		return;
+	}
+	// Order the tree from a changed clique, the path from the root to every
+	// changed clique only contains changed cliques
+	std::vector<unsigned int> order{static_cast<unsigned int>(root)};
+	std::vector<int> parent(cliques_.size(), -1);
+	std::vector<bool> visited(cliques_.size(), false);
+	visited[root] = true;
+	for(unsigned int k = 0; k < order.size(); k++) {
+		for(auto& neighbour : neighbours_[order[k]]) {
+			if(!visited[neighbour]) {
+				visited[neighbour] = true;
+				parent[neighbour] = order[k];
+				order.push_back(neighbour);
+			}
+		}
+	}
+	// Messages towards the root only change within the changed subtree
+	for(auto it = order.rbegin(); it != order.rend(); ++it) {
+		if(changed[*it] && parent[*it] != -1) {
+			sendMessage(*it, parent[*it]);
+		}
+	}
+	// All messages away from the root depend on the changed potentials
+	for(auto& clique : order) {
+		for(auto& neighbour : neighbours_[clique]) {
+			if(static_cast<int>(neighbour) != parent[clique]) {
+				sendMessage(clique, neighbour);
+			}
+		}
+	}
+	beliefValid_.assign(cliques_.size(), false);
+}
+
+const std::vector<int>& JunctionTree::getEvidence() const { return values_; }
+
+size_t JunctionTree::getNumberOfSentMessages() const { return sentMessages_; }
+
+const Factor& JunctionTree::getBelief(unsigned int clique) const
+{
+	if(!beliefValid_[clique]) {
+		Factor belief = potentials_[clique];
+		for(auto& neighbour : neighbours_[clique]) {
+			belief = belief.product(messages_.at(std::make_pair(neighbour, clique)));
+		}
+		belief.normalize();
+		beliefs_[clique] = std::move(belief);
+		beliefValid_[clique] = true;
+	}
+	return beliefs_[clique];
+}
+
+bool JunctionTree::isCalibrated() const
+{
+	return !cliques_.empty() && beliefs_.size() == cliques_.size();
+}
+
+const std::vector<std::vector<unsigned int>>& JunctionTree::getCliques() const
+{
+	return cliques_;
+}
+
+const std::vector<unsigned int>&
+JunctionTree::getNeighbours(unsigned int clique) const
+{
+	return neighbours_[clique];
+}
+
+Factor JunctionTree::getMarginal(const std::vector<unsigned int>& nodes) const
+{
+	if(!isCalibrated()) {
+		throw std::invalid_argument(
+		    "The junction tree has to be calibrated before querying it");
+	}
+	int clique = findClique(nodes);
+	if(clique == -1) {
+		throw std::invalid_argument(
+		    "The query nodes are not contained in a single clique");
+	}
+	Factor marginal = getBelief(clique).marginalise(nodes);
+	marginal.normalize();
+	return marginal;
+}
+
+float JunctionTree::getProbability(const std::vector<unsigned int>& nodes,
+                                   const std::vector<int>& values) const
+{
+	return getMarginal(nodes).getProbability(values);
+}
+
+double JunctionTree::getLogEvidenceProbability() const
+{
+	if(!isCalibrated()) {
+		throw std::invalid_argument(
+		    "The junction tree has to be calibrated before querying it");
+	}
+	// The traversal starts at the first clique, hence it receives all
+	// messages sent towards the root
+	Factor belief = potentials_[0];
+	for(auto& neighbour : neighbours_[0]) {
+		belief = belief.product(messages_.at(std::make_pair(neighbour, 0u)));
+	}
+	double probability = 0.0;
+	for(size_t i = 0; i < belief.size(); i++) {
+		probability += belief.getProbability(i);
+	}
+	double logProbability = std::log(probability);
+	for(unsigned int clique = 0; clique < cliques_.size(); clique++) {
+		if(parent_[clique] != -1) {
+			logProbability += logNormalizers_.at(
+			    std::make_pair(clique, static_cast<unsigned int>(parent_[clique])));
+		}
+	}
+	return logProbability;
+}
@@ -0,0 +1,209 @@
+#ifndef JUNCTIONTREE_H
+#define JUNCTIONTREE_H
+
+#include "Factor.h"
+#include "EliminationOrdering.h"
+
+#include <map>
+
+/*
+ * A junction tree (clique tree) of a network. The moral graph of the network
+ * is triangulated using an elimination ordering, the maximal cliques are
+ * connected by a maximum spanning tree with respect to the size of their
+ * separators. Given a set of observed values, the tree is calibrated once
+ * using Shafer-Shenoy message passing. Afterwards, the distribution of any set
+ * of nodes contained in a single clique can be read from the clique beliefs.
+ * If a single observed value changes afterwards, only the potentials of the
+ * cliques containing the node and the messages depending on them are
+ * recomputed. Beliefs are computed on demand.
+ */
+class JunctionTree{
+	public:
+	/**JunctionTree
+	 *
+	 * @param network, a const reference to the network
+	 * @param heuristic, the heuristic used to triangulate the moral graph
+	 *
+	 * @return a JunctionTree object, which is not yet calibrated
+	 *
+	 */
+	explicit JunctionTree(const Network& network,
+	    EliminationHeuristic heuristic = EliminationHeuristic::WeightedMinFill);
+
+	JunctionTree& operator=(const JunctionTree&) = delete;
+	JunctionTree& operator=(JunctionTree&&) = delete;
+
+	/**calibrate
+	 *
+	 * @param values, vector containing the observed values, -1 for unobserved nodes
+	 *
+	 * Computes the clique beliefs given the observed values using one collect
+	 * and one distribute pass
+	 */
+	void calibrate(const std::vector<int>& values);
+
+	/**updateEvidence
+	 *
+	 * @param id, identifier of the node whose observed value changes
+	 * @param value, the new observed value, -1 to remove the observation
+	 *
+	 * Recalibrates an already calibrated tree. The potentials of the cliques
+	 * containing the node are recomputed. Messages sent from these cliques
+	 * and from there on away from them are updated, messages sent towards
+	 * them are kept.
+	 */
+	void updateEvidence(unsigned int id, int value);
+
+	/**getEvidence
+	 *
+	 * @return the observed values the tree is calibrated with
+	 */
+	const std::vector<int>& getEvidence() const;
+
+	/**getNumberOfSentMessages
+	 *
+	 * @return the number of messages computed since the tree was created
+	 */
+	size_t getNumberOfSentMessages() const;
+
+	/**isCalibrated
+	 *
+	 * @return true if calibrate has been called, false otherwise
+	 */
+	bool isCalibrated() const;
+
+	/**getCliques
+	 *
+	 * @return vector containing the node identifiers of every clique
+	 */
+	const std::vector<std::vector<unsigned int>>& getCliques() const;
+
+	/**getNeighbours
+	 *
+	 * @param clique, index of the clique of interest
+	 *
+	 * @return indices of the cliques connected to the given clique
+	 */
+	const std::vector<unsigned int>& getNeighbours(unsigned int clique) const;
+
+	/**findClique
+	 *
+	 * @param nodes, identifiers of the nodes of interest
+	 *
+	 * @return index of the smallest clique containing all given nodes, -1 if
+	 * there is no such clique
+	 */
+	int findClique(const std::vector<unsigned int>& nodes) const;
+
+	/**getMarginal
+	 *
+	 * @param nodes, identifiers of the nodes of interest
+	 *
+	 * @return the distribution of the given nodes given the observed values,
+	 * normalized to 1.0
+	 *
+	 * The nodes have to be contained in a single clique.
+	 */
+	Factor getMarginal(const std::vector<unsigned int>& nodes) const;
+
+	/**getProbability
+	 *
+	 * @param nodes, identifiers of the query nodes
+	 * @param values, vector containing the values for the query nodes
+	 *
+	 * @return the probability of the given values given the observed values
+	 *
+	 * The nodes have to be contained in a single clique.
+	 */
+	float getProbability(const std::vector<unsigned int>& nodes,
+	                     const std::vector<int>& values) const;
+
+	/**getLogEvidenceProbability
+	 *
+	 * @return the natural logarithm of the probability of the observed values,
+	 * -infinity if they are impossible
+	 *
+	 * The normalizing constants of all messages sent towards the first clique
+	 * are combined with the unnormalized belief of that clique.
+	 */
+	double getLogEvidenceProbability() const;
+
+	private:
+	/**assignFactors
+	 *
+	 * Assigns every node of the network to a clique containing its family
+	 */
+	void assignFactors();
+
+	/**connectCliques
+	 *
+	 * Connects the cliques by a maximum spanning tree using the separator
+	 * sizes as weights
+	 */
+	void connectCliques();
+
+	/**createPotential
+	 *
+	 * @param clique, index of the clique of interest
+	 * @param values, vector containing the observed values
+	 *
+	 * @return the product of all factors assigned to the clique
+	 */
+	Factor createPotential(unsigned int clique,
+	                       const std::vector<int>& values) const;
+
+	/**sendMessage
+	 *
+	 * @param from, index of the sending clique
+	 * @param to, index of the receiving clique
+	 *
+	 * Computes the message from one clique to a neighbouring one using the
+	 * messages the sender received from all other neighbours
+	 */
+	void sendMessage(unsigned int from, unsigned int to);
+
+	/**getBelief
+	 *
+	 * @param clique, index of the clique of interest
+	 *
+	 * @return the normalized belief of the clique, computed if it is outdated
+	 */
+	const Factor& getBelief(unsigned int clique) const;
+
+	//A const reference to the network
+	const Network& network_;
+
+	//The node identifiers of every clique
+	std::vector<std::vector<unsigned int>> cliques_;
+
+	//The neighbouring cliques of every clique
+	std::vector<std::vector<unsigned int>> neighbours_;
+
+	//The identifiers of the nodes whose CPT is assigned to a clique
+	std::vector<std::vector<unsigned int>> assignedNodes_;
+
+	//The cliques in the order of a depth first traversal of the tree,
+	//together with the parent of each clique in that traversal
+	std::vector<unsigned int> traversal_;
+	std::vector<int> parent_;
+
+	//Clique potentials with respect to the observed values
+	std::vector<Factor> potentials_;
+
+	//Messages between neighbouring cliques, keyed by (sender, receiver)
+	std::map<std::pair<unsigned int, unsigned int>, Factor> messages_;
+
+	//Logarithm of the constant every message was normalized with
+	std::map<std::pair<unsigned int, unsigned int>, double> logNormalizers_;
+
+	//Observed values the tree is calibrated with, empty if not calibrated
+	std::vector<int> values_;
+
+	//Calibrated beliefs of the cliques, computed on demand
+	mutable std::vector<Factor> beliefs_;
+	mutable std::vector<bool> beliefValid_;
+
+	size_t sentMessages_;
+};
+
+#endif
@@ -0,0 +1,253 @@
+#include "LoopyBeliefPropagation.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <queue>
+#include <set>
+#include <stdexcept>
+
+LoopyBeliefPropagation::LoopyBeliefPropagation(const Network& network)
+    : network_(network),
+      damping_(0.0f),
+      threshold_(1e-4f),
+      maxUpdates_(100),
+      batchSize_(0),
+      converged_(false),
+      updates_(0)
+{
+}
+
+void LoopyBeliefPropagation::setDamping(float damping)
+{
+	if(damping < 0.0f || damping >= 1.0f) {
+		throw std::invalid_argument("The damping has to be in [0,1)");
+	}
+	damping_ = damping;
+}
+
+void LoopyBeliefPropagation::setConvergenceThreshold(float threshold)
+{
+	threshold_ = threshold;
+}
+
+void LoopyBeliefPropagation::setMaxUpdates(unsigned int updates)
+{
+	maxUpdates_ = updates;
+}
+
+void LoopyBeliefPropagation::setBatchSize(unsigned int batchSize)
+{
+	batchSize_ = batchSize;
+}
+
+bool LoopyBeliefPropagation::hasConverged() const { return converged_; }
+
+size_t LoopyBeliefPropagation::getNumberOfUpdates() const { return updates_; }
+
+void LoopyBeliefPropagation::createFactorGraph(const std::vector<int>& values)
+{
+	factors_.clear();
+	edges_.clear();
+	factorEdges_.assign(network_.size(), {});
+	nodeEdges_.assign(network_.size(), {});
+	messages_.clear();
+	for(const auto& n : network_.getNodes()) {
+		factors_.push_back(Factor(n, values));
+		const Factor& factor = factors_.back();
+		unsigned int f = factors_.size() - 1;
+		for(unsigned int slot = 0; slot < factor.getIDs().size(); slot++) {
+			unsigned int node = factor.getIDs()[slot];
+			unsigned int cardinality = factor.getCardinalities()[slot];
+			factorEdges_[f].push_back(edges_.size());
+			nodeEdges_[node].push_back(edges_.size());
+			edges_.push_back(Edge{f, slot, node});
+			messages_.push_back(std::vector<float>(cardinality, 1.0f / cardinality));
+		}
+	}
+	candidates_ = messages_;
+	residuals_.assign(edges_.size(), 0.0f);
+}
+
+void LoopyBeliefPropagation::computeCandidate(unsigned int edge)
+{
+	const Edge& target = edges_[edge];
+	const Factor& factor = factors_[target.factor];
+	const auto& cardinalities = factor.getCardinalities();
+	const auto& slots = factorEdges_[target.factor];
+
+	// Node-to-factor messages of all other nodes of the factor
+	std::vector<std::vector<float>> incoming(slots.size());
+	for(unsigned int slot = 0; slot < slots.size(); slot++) {
+		if(slot == target.slot || cardinalities[slot] == 1) {
+			continue;
+		}
+		auto& message = incoming[slot];
+		message.assign(cardinalities[slot], 1.0f);
+		for(unsigned int other : nodeEdges_[edges_[slots[slot]].node]) {
+			if(edges_[other].factor == target.factor) {
+				continue;
+			}
+			for(unsigned int value = 0; value < message.size(); value++) {
+				message[value] *= messages_[other][value];
+			}
+		}
+		float sum = 0.0f;
+		for(float p : message) {
+			sum += p;
+		}
+		if(sum > 0.0f) {
+			for(float& p : message) {
+				p /= sum;
+			}
+		}
+	}
+
+	// Sum-product over all entries of the factor, the last node changes fastest
+	std::vector<float> result(cardinalities[target.slot], 0.0f);
+	std::vector<unsigned int> counter(slots.size(), 0);
+	for(unsigned int index = 0; index < factor.size(); index++) {
+		float weight = factor.getProbability(index);
+		for(unsigned int slot = 0; slot < slots.size(); slot++) {
+			if(!incoming[slot].empty()) {
+				weight *= incoming[slot][counter[slot]];
+			}
+		}
+		result[counter[target.slot]] += weight;
+		for(int slot = slots.size() - 1; slot >= 0; slot--) {
+			if(++counter[slot] < cardinalities[slot]) {
+				break;
+			}
+			counter[slot] = 0;
+		}
+	}
+	float sum = 0.0f;
+	for(float p : result) {
+		sum += p;
+	}
+	const auto& current = messages_[edge];
+	float residual = 0.0f;
+	for(unsigned int value = 0; value < result.size(); value++) {
+		float p = (sum > 0.0f) ? result[value] / sum : 1.0f / result.size();
+		result[value] = (1.0f - damping_) * p + damping_ * current[value];
+		residual = std::max(residual, std::fabs(result[value] - current[value]));
+	}
+	candidates_[edge] = std::move(result);
+	residuals_[edge] = residual;
+}
+
+void LoopyBeliefPropagation::computeCandidates(
+    const std::vector<unsigned int>& edges)
+{
+	ThreadPool& pool = ThreadPool::getGlobalPool();
+	// Small batches are not worth the synchronisation
+	unsigned int tasks = std::min<size_t>(pool.size(), edges.size() / 64);
+	if(tasks < 2) {
+		for(unsigned int edge : edges) {
+			computeCandidate(edge);
+		}
+		return;
+	}
+	std::atomic<unsigned int> finished(0);
+	for(unsigned int t = 0; t < tasks; t++) {
+		pool.submit([&, t]() {
+			for(size_t i = t; i < edges.size(); i += tasks) {
+				computeCandidate(edges[i]);
+			}
+			finished++;
+		});
+	}
+	pool.waitUntil([&]() { return finished == tasks; });
+}
+
+std::vector<std::vector<float>>
+LoopyBeliefPropagation::computePosteriors(const std::vector<int>& values)
+{
+	createFactorGraph(values);
+	updates_ = 0;
+	unsigned int batchSize =
+	    batchSize_ != 0 ? batchSize_ : ThreadPool::getGlobalPool().size();
+
+	std::vector<unsigned int> pending;
+	for(unsigned int edge = 0; edge < edges_.size(); edge++) {
+		if(factors_[edges_[edge].factor].getCardinalities()[edges_[edge].slot] > 1) {
+			pending.push_back(edge);
+		}
+	}
+	// Queue of residuals, outdated entries are skipped when they are popped
+	std::priority_queue<std::pair<float, unsigned int>> queue;
+	size_t maxUpdates = static_cast<size_t>(maxUpdates_) * pending.size();
+	std::vector<unsigned int> batch;
+	while(true) {
+		computeCandidates(pending);
+		for(unsigned int edge : pending) {
+			if(residuals_[edge] > threshold_) {
+				queue.push(std::make_pair(residuals_[edge], edge));
+			}
+		}
+		batch.clear();
+		while(!queue.empty() && batch.size() < batchSize) {
+			auto top = queue.top();
+			queue.pop();
+			if(top.first == residuals_[top.second] && top.first > threshold_ &&
+			   std::find(batch.begin(), batch.end(), top.second) == batch.end()) {
+				batch.push_back(top.second);
+			}
+		}
+		if(batch.empty() || updates_ >= maxUpdates) {
+			break;
+		}
+		// Commit the messages and collect the messages depending on them
+		std::set<unsigned int> affected;
+		for(unsigned int edge : batch) {
+			messages_[edge] = candidates_[edge];
+			residuals_[edge] = 0.0f;
+			updates_++;
+			// A damped message only moved part of the way towards its target
+			if(damping_ > 0.0f) {
+				affected.insert(edge);
+			}
+			for(unsigned int other : nodeEdges_[edges_[edge].node]) {
+				if(edges_[other].factor == edges_[edge].factor) {
+					continue;
+				}
+				for(unsigned int dependent : factorEdges_[edges_[other].factor]) {
+					if(dependent != other &&
+					   factors_[edges_[dependent].factor]
+					           .getCardinalities()[edges_[dependent].slot] > 1) {
+						affected.insert(dependent);
+					}
+				}
+			}
+		}
+		pending.assign(affected.begin(), affected.end());
+	}
+	converged_ = batch.empty();
+
+	// The belief of a node is the product of all incoming messages
+	std::vector<std::vector<float>> posteriors(network_.size());
+	for(const auto& n : network_.getNodes()) {
+		unsigned int id = n.getID();
+		auto& posterior = posteriors[id];
+		posterior.assign(n.getProbabilityMatrix().getColCount(), 0.0f);
+		if(values[id] != -1) {
+			posterior[values[id]] = 1.0f;
+			continue;
+		}
+		std::fill(posterior.begin(), posterior.end(), 1.0f);
+		for(unsigned int edge : nodeEdges_[id]) {
+			for(unsigned int value = 0; value < posterior.size(); value++) {
+				posterior[value] *= messages_[edge][value];
+			}
+		}
+		float sum = 0.0f;
+		for(float p : posterior) {
+			sum += p;
+		}
+		for(float& p : posterior) {
+			p = (sum > 0.0f) ? p / sum : 1.0f / posterior.size();
+		}
+	}
+	return posteriors;
+}
@@ -0,0 +1,130 @@
+#ifndef LOOPYBELIEFPROPAGATION_H
+#define LOOPYBELIEFPROPAGATION_H
+
+#include "Network.h"
+#include "Factor.h"
+
+/*
+ * Approximates the posteriors of all nodes with loopy belief propagation on
+ * the factor graph of the network, which contains one factor per CPT. The
+ * messages from factors to nodes are scheduled by their residual, i.e. by the
+ * change a recomputation would cause, hence messages in regions that have not
+ * converged are updated first. The messages with the largest residuals are
+ * committed in batches and the messages depending on them are recomputed in
+ * parallel on the global thread pool. For networks whose factor graph is a
+ * tree, the posteriors are exact.
+ */
+class LoopyBeliefPropagation{
+	public:
+	/**LoopyBeliefPropagation
+	 *
+	 * @param network, a const reference to the network
+	 *
+	 * @return a LoopyBeliefPropagation object without damping, a convergence
+	 * threshold of 1e-4 and at most 100 updates per message
+	 */
+	explicit LoopyBeliefPropagation(const Network& network);
+
+	LoopyBeliefPropagation& operator=(const LoopyBeliefPropagation&) = delete;
+	LoopyBeliefPropagation& operator=(LoopyBeliefPropagation&&) = delete;
+
+	/**setDamping
+	 *
+	 * @param damping, the weight of the old message in an update, in [0,1)
+	 */
+	void setDamping(float damping);
+
+	/**setConvergenceThreshold
+	 *
+	 * @param threshold, messages whose residual (maximal absolute change) is
+	 * below this value are not updated
+	 */
+	void setConvergenceThreshold(float threshold);
+
+	/**setMaxUpdates
+	 *
+	 * @param updates, the maximal number of updates per message on average
+	 */
+	void setMaxUpdates(unsigned int updates);
+
+	/**setBatchSize
+	 *
+	 * @param batchSize, the number of messages committed before their dependent
+	 * messages are recomputed, 0 for one message per worker of the global thread pool
+	 */
+	void setBatchSize(unsigned int batchSize);
+
+	/**computePosteriors
+	 *
+	 * @param values, vector containing the values of the evidence nodes, -1 for all other nodes
+	 *
+	 * @return for every node the approximate probability of each of its values
+	 * given the evidence. The index of the outer vector equals the node identifier.
+	 */
+	std::vector<std::vector<float>>
+	computePosteriors(const std::vector<int>& values);
+
+	/**hasConverged
+	 *
+	 * @return true if all residuals of the last run were below the threshold
+	 */
+	bool hasConverged() const;
+
+	/**getNumberOfUpdates
+	 *
+	 * @return the number of message updates of the last run
+	 */
+	size_t getNumberOfUpdates() const;
+
+	private:
+	// An edge between a factor and a node, the node is the slot-th node of the factor
+	struct Edge {
+		unsigned int factor;
+		unsigned int slot;
+		unsigned int node;
+	};
+
+	/**createFactorGraph
+	 *
+	 * @param values, the values of the evidence nodes
+	 *
+	 * Creates the evidence-reduced factors and the edges of the factor graph
+	 */
+	void createFactorGraph(const std::vector<int>& values);
+
+	/**computeCandidate
+	 *
+	 * @param edge, the edge whose factor-to-node message is recomputed
+	 *
+	 * Computes the damped new message and stores it as candidate
+	 */
+	void computeCandidate(unsigned int edge);
+
+	/**computeCandidates
+	 *
+	 * @param edges, the edges whose messages are recomputed
+	 *
+	 * Recomputes the candidates in parallel and updates their residuals
+	 */
+	void computeCandidates(const std::vector<unsigned int>& edges);
+
+	const Network& network_;
+	float damping_;
+	float threshold_;
+	unsigned int maxUpdates_;
+	unsigned int batchSize_;
+	bool converged_;
+	size_t updates_;
+
+	std::vector<Factor> factors_;
+	std::vector<Edge> edges_;
+	// Edges of every factor by slot and edges of every node
+	std::vector<std::vector<unsigned int>> factorEdges_;
+	std::vector<std::vector<unsigned int>> nodeEdges_;
+	// Current and recomputed factor-to-node messages per edge
+	std::vector<std::vector<float>> messages_;
+	std::vector<std::vector<float>> candidates_;
+	std::vector<float> residuals_;
+};
+
+#endif
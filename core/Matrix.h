@@ -129,6 +129,14 @@ template <typename T> class Matrix
 	 */
 	const T& getData(unsigned int col, unsigned int row) const;
 
+	/**getRawData
+	 *
+	 * @return Pointer to the values of the matrix, stored row by row
+	 *
+	 * Allows strided access to the matrix without bounds checks.
+	 */
+	const T* getRawData() const;
+
 	/**setRowNames
 	 *
 	 * @param names Vector containing row names
@@ -672,6 +680,12 @@ const T& Matrix<T>::getData(unsigned int col, unsigned int row) const
 }
 
 
+template <typename T>
+const T* Matrix<T>::getRawData() const
+{
+	return data_.data();
+}
+
 template <typename T>
 void Matrix<T>::setRowNames(const std::vector<std::string>& names)
 {
@@ -6,7 +6,9 @@
 #include <iostream>
 
 Network::Network()
-    : hypostart_(0)
+    : hypostart_(0),
+      queryPlans_(std::make_shared<QueryPlanCache>()),
+      modelVersion_(0)
 {
 	ExtensionToIndex_[".tgf"] = 1;
 	ExtensionToIndex_[".na"] = 2;
@@ -36,8 +38,9 @@ const std::vector<unsigned int> Network::getParents(unsigned int id) const
 {
 	std::vector<unsigned int> parentIDs;
 	unsigned int index = id;
-	for(unsigned int row = 0; row < AdjacencyMatrix_.getRowCount(); row++) {
-		if(AdjacencyMatrix_(index, row) == 1) {
+	const Matrix<unsigned int>& adjacency = AdjacencyMatrix_.get();
+	for(unsigned int row = 0; row < adjacency.getRowCount(); row++) {
+		if(adjacency(index, row) == 1) {
 			parentIDs.push_back(row);
 		}
 	}
@@ -62,6 +65,8 @@ const std::vector<Node>& Network::getNodes() const { return NodeList_; }
 void Network::cutParents(unsigned int id)
 {
 	getNode(id).cutParents();
+	priors_.reset();
+	modelVersion_++;
 }
 
 void Network::cutParents(const std::string& name)
@@ -69,10 +74,20 @@ void Network::cutParents(const std::string& name)
 	cutParents(getNode(name).getID());
 }
 
+void Network::setIntervention(unsigned int id, int value)
+{
+	getNode(id).setIntervention(value);
+	priors_.reset();
+	modelVersion_++;
+}
+
 void Network::addEdge(unsigned int id1, unsigned int id2)
 {
-	AdjacencyMatrix_.setData(1, id1, id2);
+	AdjacencyMatrix_.getMutable().setData(1, id1, id2);
 	getNode(id1).setParents(getParents(id1));
+	clearQueryPlans();
+	priors_.reset();
+	modelVersion_++;
 }
 
 void Network::addEdge(const std::string& name1, const std::string& name2)
@@ -83,8 +98,11 @@ void Network::addEdge(const std::string& name1, const std::string& name2)
 
 void Network::removeEdge(unsigned int id1, unsigned int id2)
 {
-	AdjacencyMatrix_.setData(0, id1, id2);
+	AdjacencyMatrix_.getMutable().setData(0, id1, id2);
 	getNode(id1).setParents(getParents(id1));
+	clearQueryPlans();
+	priors_.reset();
+	modelVersion_++;
 }
 
 void Network::removeEdge(const std::string& name1, const std::string& name2)
@@ -111,7 +129,7 @@ const Node& Network::getNode(const std::string& name) const
 
 std::ostream& operator<<(std::ostream& os, const Network& n)
 {
-	os << "Adjacency matrix:\n" << n.AdjacencyMatrix_ << "\n\n";
+	os << "Adjacency matrix:\n" << n.AdjacencyMatrix_.get() << "\n\n";
 	for(const Node& node : n.NodeList_) {
 		os << node << "\n";
 	}
@@ -120,6 +138,9 @@ std::ostream& operator<<(std::ostream& os, const Network& n)
 
 void Network::readNetwork(const std::string& filename)
 {
+	clearQueryPlans();
+	priors_.reset();
+	modelVersion_++;
 	auto idx = filename.find_last_of('.');
 
 	if(idx == std::string::npos) {
@@ -148,7 +169,7 @@ void Network::readNetwork(const std::string& filename)
 void Network::readTGF(const std::string& filename)
 {
 	NodeList_.clear();
-	AdjacencyMatrix_.clear();
+	AdjacencyMatrix_.getMutable().clear();
 	std::string line;
 	std::ifstream input(filename, std::ifstream::in);
 	if (! input.good()){
@@ -177,9 +198,9 @@ void Network::readTGF(const std::string& filename)
 		names.push_back(ids);
 		index++;
 	}
-	AdjacencyMatrix_.resize(NodeList_.size(), NodeList_.size(), 0);
-	AdjacencyMatrix_.setRowNames(names);
-	AdjacencyMatrix_.setColNames(names);
+	AdjacencyMatrix_.getMutable().resize(NodeList_.size(), NodeList_.size(), 0);
+	AdjacencyMatrix_.getMutable().setRowNames(names);
+	AdjacencyMatrix_.getMutable().setColNames(names);
 	std::sort(originalIDToDense_.begin(), originalIDToDense_.end(),Comp());
 	bool edges = false;
 	while(std::getline(input, line)) {
@@ -225,7 +246,7 @@ void Network::readSIF(const std::string& filename)
 void Network::readNA(const std::string& filename)
 {
 	NodeList_.clear();
-	AdjacencyMatrix_.clear();
+	AdjacencyMatrix_.getMutable().clear();
 	std::string line;
 	std::ifstream input(filename, std::ifstream::in);
 	if (! input.good()){
@@ -258,9 +279,9 @@ void Network::readNA(const std::string& filename)
 		name = "";
 	}
 	input.close();
-	AdjacencyMatrix_.resize(NodeList_.size(), NodeList_.size(), 0);
-	AdjacencyMatrix_.setRowNames(names);
-	AdjacencyMatrix_.setColNames(names);
+	AdjacencyMatrix_.getMutable().resize(NodeList_.size(), NodeList_.size(), 0);
+	AdjacencyMatrix_.getMutable().setRowNames(names);
+	AdjacencyMatrix_.getMutable().setColNames(names);
 	std::sort(originalIDToDense_.begin(), originalIDToDense_.end(),Comp());
 }
 
@@ -310,6 +331,95 @@ void Network::performDFS(unsigned int id,
 	}
 }
 
+std::vector<unsigned int>
+Network::getAncestralOrder(const std::vector<unsigned int>& ids) const
+{
+	std::vector<bool> visited(NodeList_.size(), false);
+	std::vector<unsigned int> order;
+	// Post-order DFS along the parents, the second entry is the next parent
+	std::vector<std::pair<unsigned int, unsigned int>> stack;
+	for(unsigned int id : ids) {
+		if(visited[id]) {
+			continue;
+		}
+		visited[id] = true;
+		stack.push_back(std::make_pair(id, 0u));
+		while(!stack.empty()) {
+			auto& top = stack.back();
+			const auto& parents = getNode(top.first).getParents();
+			if(top.second < parents.size()) {
+				unsigned int parent = parents[top.second++];
+				if(!visited[parent]) {
+					visited[parent] = true;
+					stack.push_back(std::make_pair(parent, 0u));
+				}
+			} else {
+				order.push_back(top.first);
+				stack.pop_back();
+			}
+		}
+	}
+	return order;
+}
+
+std::vector<unsigned int>
+Network::getRequisiteNodes(const std::vector<unsigned int>& queryNodes,
+                           const std::vector<unsigned int>& evidenceNodes) const
+{
+	std::vector<std::vector<unsigned int>> children(NodeList_.size());
+	for(const Node& n : NodeList_) {
+		for(auto& pid : n.getParents()) {
+			children[pid].push_back(n.getID());
+		}
+	}
+	std::vector<bool> evidence(NodeList_.size(), false);
+	for(auto& id : evidenceNodes) {
+		evidence[id] = true;
+	}
+	std::vector<bool> top(NodeList_.size(), false);
+	std::vector<bool> bottom(NodeList_.size(), false);
+	std::vector<unsigned int> requisite;
+	// Pairs of node identifier and whether the ball is passed from a child
+	std::vector<std::pair<unsigned int, bool>> schedule;
+	for(auto it = queryNodes.rbegin(); it != queryNodes.rend(); ++it) {
+		schedule.push_back(std::make_pair(*it, true));
+	}
+	while(!schedule.empty()) {
+		unsigned int id = schedule.back().first;
+		bool fromChild = schedule.back().second;
+		schedule.pop_back();
+		bool passToParents = false;
+		if(fromChild && !evidence[id]) {
+			if(!bottom[id]) {
+				bottom[id] = true;
+				for(auto& cid : children[id]) {
+					schedule.push_back(std::make_pair(cid, false));
+				}
+			}
+			passToParents = true;
+		} else if(!fromChild) {
+			if(evidence[id]) {
+				passToParents = true;
+			} else if(!bottom[id]) {
+				bottom[id] = true;
+				for(auto& cid : children[id]) {
+					schedule.push_back(std::make_pair(cid, false));
+				}
+			}
+		}
+		// Parents are scheduled last, hence they are visited first
+		if(passToParents && !top[id]) {
+			top[id] = true;
+			requisite.push_back(id);
+			const auto& parents = getNode(id).getParents();
+			for(auto it = parents.rbegin(); it != parents.rend(); ++it) {
+				schedule.push_back(std::make_pair(*it, true));
+			}
+		}
+	}
+	return requisite;
+}
+
 void Network::cycleCheck(unsigned int sourceID, unsigned int currentID, bool& result){
 	if (sourceID == currentID){
 		result = true;
@@ -437,22 +547,139 @@ void Network::saveParameters() const{
 	file.close();
 }
 
-void Network::clearDynProgMatrices(){
-	for (auto& n : NodeList_){
-		n.clearDynProgMatrix();
+std::shared_ptr<const std::vector<float>> Network::getPriors(unsigned int id) const
+{
+	auto priors = priors_.load();
+	if(priors == nullptr || priors->size() != NodeList_.size()) {
+		auto computed =
+		    std::make_shared<const std::vector<std::vector<float>>>(computePriors());
+		// Another query may have stored its result in the meantime, which is
+		// kept so that all queries share one result
+		if(priors_.compareExchange(priors, computed)) {
+			priors = computed;
+		}
 	}
+	// The returned pointer shares the ownership of all priors, hence
+	// clearPriors does not free the vector while the caller reads it
+	return std::shared_ptr<const std::vector<float>>(priors, &(*priors)[id]);
 }
 
+std::vector<std::vector<float>> Network::computePriors() const
+{
+	// Order the nodes topologically
+	std::vector<unsigned int> missingParents(NodeList_.size());
+	std::vector<std::vector<unsigned int>> children(NodeList_.size());
+	std::vector<unsigned int> order;
+	for(const auto& n : NodeList_) {
+		missingParents[n.getID()] = n.getNumberOfParents();
+		for(unsigned int p : n.getParents()) {
+			children[p].push_back(n.getID());
+		}
+		if(n.getNumberOfParents() == 0) {
+			order.push_back(n.getID());
+		}
+	}
+	for(unsigned int i = 0; i < order.size(); i++) {
+		for(unsigned int c : children[order[i]]) {
+			if(--missingParents[c] == 0) {
+				order.push_back(c);
+			}
+		}
+	}
+	if(order.size() != NodeList_.size()) {
+		throw std::invalid_argument(
+		    "The total probabilities can not be computed for a cyclic network");
+	}
+
+	// Weight every CPT row with the total probabilities of its parent values
+	std::vector<std::vector<float>> priors(NodeList_.size());
+	for(unsigned int id : order) {
+		const Node& n = NodeList_[id];
+		const auto& parents = n.getParents();
+		const auto& probMatrix = n.getProbabilityMatrix();
+		std::vector<float>& prior = priors[id];
+		prior.assign(probMatrix.getColCount(), 0.0f);
+		std::vector<unsigned int> parentValues(parents.size(), 0);
+		// Nodes without parents, e.g. after a do-intervention, use the first row
+		size_t rows = parents.empty() ? std::min<size_t>(1, probMatrix.getRowCount())
+		                              : probMatrix.getRowCount();
+		for(unsigned int row = 0; row < rows; row++) {
+			float weight = 1.0f;
+			for(unsigned int i = 0; i < parents.size(); i++) {
+				weight *= priors[parents[i]][parentValues[i]];
+			}
+			for(unsigned int col = 0; col < probMatrix.getColCount(); col++) {
+				prior[col] += weight * probMatrix(col, row);
+			}
+			// The last parent changes fastest, see computeFactor
+			for(int i = parents.size() - 1; i >= 0; i--) {
+				if(++parentValues[i] < priors[parents[i]].size()) {
+					break;
+				}
+				parentValues[i] = 0;
+			}
+		}
+	}
+	return priors;
+}
+
+void Network::clearPriors() { priors_.reset(); }
+
+QueryPlanCache& Network::getQueryPlanCache() const { return *queryPlans_; }
+
+void Network::clearQueryPlans()
+{
+	queryPlans_ = std::make_shared<QueryPlanCache>();
+}
+
+QueryResultCache& Network::getQueryResultCache() { return queryResults_; }
+
+TwinNetworkCache& Network::getTwinNetworkCache() { return twinNetworks_; }
+
+unsigned long Network::getModelVersion() const { return modelVersion_; }
+
+void Network::incrementModelVersion() { modelVersion_++; }
+
 void Network::removeHypoNodes(){
 	NodeList_.erase(NodeList_.begin()+hypostart_,NodeList_.end());
+	priors_.reset();
+	modelVersion_++;
 }
 
 void Network::createTwinNetwork(){
-	std::set<int> hypoNodes;
+	std::vector<unsigned int> nodes;
 	for (auto& n : NodeList_){
-		if (!n.getParents().empty()){
-			hypoNodes.insert(n.getID());
-		}	
+		nodes.push_back(n.getID());
+	}
+	createTwinNetwork(nodes, {});
+}
+
+void Network::createTwinNetwork(const std::vector<unsigned int>& nodes,
+                                const std::vector<unsigned int>& interventions){
+	std::set<int> hypoNodes;
+	std::vector<unsigned int> stack;
+	for (auto id : nodes){
+		if (!getNode(id).getParents().empty()){
+			stack.push_back(id);
+		}
+	}
+	for (auto id : interventions){
+		if (!getNode(id).getParents().empty()){
+			stack.push_back(id);
+		}
+	}
+	while (!stack.empty()){
+		unsigned int id = stack.back();
+		stack.pop_back();
+		if (!hypoNodes.insert(id).second ||
+		    std::find(interventions.begin(), interventions.end(), id) != interventions.end()){
+			continue;
+		}
+		for (auto p : getNode(id).getParents()){
+			if (!getNode(p).getParents().empty()){
+				stack.push_back(p);
+			}
+		}
 	}
 	size_t shift = NodeList_.size();
 	hypostart_ = shift;
@@ -478,11 +705,17 @@ void Network::createTwinNetwork(){
 			}
 		}
 		hypoNode.setParents(newParents);
+		for (unsigned int i = 0; i < newParents.size(); i++){
+			hypoNode.setFactor(getNode(id).getFactor(i), i);
+		}
 		IDToIndex_[hypoNode.getID()] = index;
 		NameToIndex_[hypoNode.getName()] = index;
 		index++;	
 		NodeList_.push_back(hypoNode);
 	}
+	clearQueryPlans();
+	priors_.reset();
+	modelVersion_++;
 }
 
 unsigned int Network::getHypoStart(){
@@ -497,4 +730,6 @@ void Network::reset(){
 	for (auto& node : NodeList_){
 		node.reset();
 	}
+	priors_.reset();
+	modelVersion_++;
 }
@@ -2,6 +2,10 @@
 #define NETWORK_H
 
 #include "Node.h"
+#include "AtomicSharedPtr.h"
+#include "QueryPlanCache.h"
+#include "QueryResultCache.h"
+#include "TwinNetworkCache.h"
 #include <map>
 
 class Network{
@@ -92,6 +96,32 @@ class Network{
 		 */
 		void performDFS(unsigned int id, std::vector<unsigned int>& visitedNodes);
 
+		/**getRequisiteNodes
+		 *
+		 * @param queryNodes Identifiers of the query nodes
+		 * @param evidenceNodes Identifiers of the observed nodes
+		 *
+		 * @return Identifiers of all nodes whose probability matrices are needed
+		 * to compute the distribution of the query nodes given the evidence
+		 *
+		 * Uses the Bayes-Ball algorithm. Nodes that are d-separated from the query
+		 * nodes by the evidence as well as barren nodes are not returned. Without
+		 * evidence, the result equals the DFS order of the ancestors of the query nodes.
+		 */
+		std::vector<unsigned int>
+		getRequisiteNodes(const std::vector<unsigned int>& queryNodes,
+		                  const std::vector<unsigned int>& evidenceNodes) const;
+
+		/**getAncestralOrder
+		 *
+		 * @param ids Identifiers of the nodes of interest
+		 *
+		 * @return Identifiers of the given nodes and all their ancestors, every
+		 * node is preceded by its parents
+		 */
+		std::vector<unsigned int>
+		getAncestralOrder(const std::vector<unsigned int>& ids) const;
+
 		/**cycleCheck 
 		 *
 		 * @param sourceID Identifier of the cycle start node
@@ -295,11 +325,80 @@ class Network{
 		 */
 		void saveParameters() const;
 
-		/**clearDynProgMatrices 
+		/**getPriors
+		 *
+		 * @param id Identifier of the node of interest
+		 *
+		 * @return The total probability of every value of the node, i.e. the CPT
+		 * of the node weighted by the total probabilities of its parents
+		 *
+		 * The total probabilities of all nodes are computed in a single pass
+		 * over the nodes in topological order, which takes time linear in the
+		 * size of all CPTs. The result is stored until clearPriors is called.
+		 * Concurrent queries may call this method, the first computed result
+		 * is kept. The returned priors stay valid after clearPriors.
+		 */
+		std::shared_ptr<const std::vector<float>> getPriors(unsigned int id) const;
+
+		/**clearPriors
+		 *
+		 * Removes the stored total probabilities. This is required whenever the
+		 * structure or the parameters of the network change.
+		 */
+		void clearPriors();
+
+		/**setIntervention
+		 *
+		 * @param id Identifier of the node
+		 * @param value Value of the node in the dense integer representation
+		 *
+		 * Performs a Do-Intervention on a node. The CPT of the node is replaced
+		 * instead of overwritten, hence copies of the network are not affected.
+		 */
+		void setIntervention(unsigned int id, int value);
+
+		/**getQueryPlanCache
+		 *
+		 * @return A reference to the cache storing the variable elimination plans
+		 * computed for this network. The cache may be used by concurrent queries.
+		 */
+		QueryPlanCache& getQueryPlanCache() const;
+
+		/**clearQueryPlans
+		 *
+		 * Removes all cached query plans. This is required whenever the structure
+		 * or the parameters of the network change. Copies of the network sharing
+		 * the plans keep them.
+		 */
+		void clearQueryPlans();
+
+		/**getQueryResultCache
+		 *
+		 * @return A reference to the cache storing the results of exact queries
+		 * computed for this network
+		 */
+		QueryResultCache& getQueryResultCache();
+
+		/**getTwinNetworkCache
+		 *
+		 * @return A reference to the cache storing the twin networks created
+		 * for counterfactual queries on this network
+		 */
+		TwinNetworkCache& getTwinNetworkCache();
+
+		/**getModelVersion
 		 *
-		 * Clear all entries in the matrices created for DynamicProgramming
+		 * @return A counter that is incremented whenever the structure or the
+		 * parameters of the network change. It never decreases, hence a version
+		 * identifies one state of the network.
 		 */
-		void clearDynProgMatrices();
+		unsigned long getModelVersion() const;
+
+		/**incrementModelVersion
+		 *
+		 * Marks the structure or the parameters of the network as changed
+		 */
+		void incrementModelVersion();
 
 		/**createTwinNetwork
 		 *
@@ -307,6 +406,20 @@ class Network{
 		 */
 		void createTwinNetwork();
 
+		/**createTwinNetwork
+		 *
+		 * @param nodes, Identifiers of the nodes whose hypothetical counterparts are queried
+		 * @param interventions, Identifiers of the nodes set by Do-Interventions
+		 *
+		 * Creates a pruned TwinNetwork Representation. Only the hypothetical
+		 * nodes of the given and the intervened nodes and their hypothetical
+		 * ancestors are created, the ancestors of intervened nodes are omitted
+		 * since the intervention cuts their parents. The CPTs are shared with
+		 * the real world nodes.
+		 */
+		void createTwinNetwork(const std::vector<unsigned int>& nodes,
+		                       const std::vector<unsigned int>& interventions);
+
 		/**removeHypoNodes
 	 	 *
 	 	 * Removes the Hypothetical Nodes from the nodelist
@@ -344,6 +457,15 @@ class Network{
 		void reset();
 
 	private:
+		/**computePriors
+		 *
+		 * @return The total probabilities of all nodes
+		 *
+		 * Computes the total probabilities of all nodes in topological order.
+		 * Throws an invalid_argument exception if the network contains a cycle.
+		 */
+		std::vector<std::vector<float>> computePriors() const;
+
 		/**getParents 
 		 *
 		 * @param id Identifier of the node of interest
@@ -424,9 +546,10 @@ class Network{
 		 */
 		void readNA(const std::string& filename);
 
-		//Matrices to store the network structure
-		Matrix<unsigned int> AdjacencyMatrix_;
-		Matrix<unsigned int> AdjacencyMatrixBackup_;
+		//Matrices to store the network structure, shared by copies of the
+		//network until one of them changes its edges
+		CopyOnWrite<Matrix<unsigned int>> AdjacencyMatrix_;
+		CopyOnWrite<Matrix<unsigned int>> AdjacencyMatrixBackup_;
 		//Maps the identifier of a node to its index in the NodeList_
 		std::unordered_map<unsigned int, unsigned int> IDToIndex_;
 		//Maps the name of a node to its index int the NodeList_
@@ -445,5 +568,17 @@ class Network{
 		unsigned int hypostart_;
 		//Mapes the original Node ID to the hypothetical node ID
 		std::vector<unsigned int> IDMap_;
+		//Stores the variable elimination plans by the structure of the query.
+		//Copies of the network share the plans until the structure changes.
+		std::shared_ptr<QueryPlanCache> queryPlans_;
+		//Stores the total probabilities of all node values, nullptr if outdated.
+		//Copies of the network share them until one of them changes.
+		mutable AtomicSharedPtr<const std::vector<std::vector<float>>> priors_;
+		//Stores the results of exact queries by their canonical form
+		QueryResultCache queryResults_;
+		//Stores the twin networks of counterfactual queries by their structure
+		TwinNetworkCache twinNetworks_;
+		//Incremented whenever the structure or the parameters change
+		unsigned long modelVersion_;
 };
 #endif
@@ -4,12 +4,18 @@
 #include "Discretiser.h"
 #include "DiscretisationSettings.h"
 #include "EM.h"
+#include <algorithm>
 #include <fstream>
 NetworkController::NetworkController()
     : observations_(0, 0, -1),
       eMRuns_(0),
+      eMRestarts_(0),
+      eMThreads_(0),
+      eMStrategy_(EMStrategy::Plain),
+      savedEMRuns_(0),
       finalDifference_(0),
       likelihoodOfTheData_(0.0f),
+      logLikelihood_(0.0),
       timeInMicroSeconds_(0)
 {
 }
@@ -31,6 +37,8 @@ void NetworkController::loadObservations(const std::string& datafile,
 {
 	Matrix<std::string> originalObservations(datafile, false, true);
 	Discretiser d(originalObservations,controlFile,observations_,network_);
+	patterns_ = SamplePatterns(observations_);
+	network_.incrementModelVersion();
 }
 
 void NetworkController::loadObservations(
@@ -39,6 +47,8 @@ void NetworkController::loadObservations(
 {
 	Matrix<std::string> originalObservations(datafile, false, true,samplesToDelete);
 	Discretiser d(originalObservations,controlFile,observations_,network_);
+	patterns_ = SamplePatterns(observations_);
+	network_.incrementModelVersion();
 }
 
 void NetworkController::loadObservations(
@@ -49,6 +59,8 @@ void NetworkController::loadObservations(
 	Discretiser d(originalObservations,observations_,network_);
 	d.setJsonTree(propertyTree);
 	d.discretise();
+	patterns_ = SamplePatterns(observations_);
+	network_.incrementModelVersion();
 }
 
 void NetworkController::loadObservations(
@@ -60,31 +72,83 @@ void NetworkController::loadObservations(
 	Discretiser d(originalObservations,observations_,network_);
 	d.setJsonTree(propertyTree);
 	d.discretise();
+	patterns_ = SamplePatterns(observations_);
+	network_.incrementModelVersion();
 }
 
 
 
 void NetworkController::trainNetwork(){
-	DataDistribution datadu(network_, observations_);
 	storeDiscretisedData("discretisedData.txt");
+	trainNetwork(network_);
+}
+
+void NetworkController::trainNetwork(Network& network){
+	DataDistribution datadu(network, patterns_);
 	datadu.assignObservationsToNodes();
 	datadu.distributeObservations();
-	EM em(network_, observations_, 0.001f, 100000);
-	eMRuns_ = em.getNumberOfRuns();
-	finalDifference_ = em.getDifference();
-	likelihoodOfTheData_ = em.calculateLikelihoodOfTheData();
-	timeInMicroSeconds_ = em.getTimeInMicroSeconds();
-	network_.clearDynProgMatrices();
+	EM em(network, patterns_, 0.001f, 100000, eMRestarts_, eMThreads_,
+	      eMStrategy_);
+	if(&network == &network_) {
+		eMRuns_ = em.getNumberOfRuns();
+		savedEMRuns_ = em.getEstimatedNumberOfSavedRuns();
+		finalDifference_ = em.getDifference();
+		likelihoodOfTheData_ = em.calculateLikelihoodOfTheData();
+		logLikelihood_ = em.getLogLikelihood();
+		timeInMicroSeconds_ = em.getTimeInMicroSeconds();
+	}
+	network.clearPriors();
+	network.clearQueryPlans();
+	network.incrementModelVersion();
+}
+
+void NetworkController::trainNetwork(Network& network,
+                                     const std::vector<unsigned int>& ids){
+	DataDistribution datadu(network, patterns_);
+	datadu.redistributeObservations(ids);
+	EM em(network, patterns_, ids, 0.001f, 100000, eMRestarts_, eMThreads_,
+	      eMStrategy_);
+	if(&network == &network_) {
+		eMRuns_ = em.getNumberOfRuns();
+		savedEMRuns_ = em.getEstimatedNumberOfSavedRuns();
+		finalDifference_ = em.getDifference();
+		likelihoodOfTheData_ = em.calculateLikelihoodOfTheData();
+		logLikelihood_ = em.getLogLikelihood();
+		timeInMicroSeconds_ = em.getTimeInMicroSeconds();
+	}
+	network.clearPriors();
+	network.clearQueryPlans();
+	network.incrementModelVersion();
 }
 
 float NetworkController::getLikelihoodOfTheData() const {
 	return likelihoodOfTheData_;
 }
 
+void NetworkController::setEMRestarts(unsigned int restarts) {
+	eMRestarts_ = restarts;
+}
+
+void NetworkController::setEMThreads(unsigned int threads) {
+	eMThreads_ = threads;
+}
+
+void NetworkController::setEMStrategy(EMStrategy strategy) {
+	eMStrategy_ = strategy;
+}
+
+double NetworkController::getLogLikelihood() const {
+	return logLikelihood_;
+}
+
 int NetworkController::getNumberOfEMRuns() const {
 	return eMRuns_;
 }
 
+int NetworkController::getEstimatedNumberOfSavedEMRuns() const {
+	return savedEMRuns_;
+}
+
 float NetworkController::getParameterDifference() const {
 	return finalDifference_;
 }
@@ -98,25 +162,38 @@ void NetworkController::saveParameters() const{
 }
 
 bool NetworkController::isEdgePossible(unsigned int sourceID, unsigned int targetID,
-                                       std::vector<std::pair<unsigned int, unsigned int>>& addedEdges,
-                                       std::vector<std::pair<unsigned int, unsigned int>>& removedEdges)
+                                       const std::vector<std::pair<unsigned int, unsigned int>>& addedEdges,
+                                       const std::vector<std::pair<unsigned int, unsigned int>>& removedEdges) const
 {
-	for (auto& pair : addedEdges){
-		network_.addEdge(pair.second,pair.first);
+	// The check works on a copy of the parents, modifying the network would
+	// invalidate the query results cached for its model version
+	std::vector<std::vector<unsigned int>> parents;
+	for (const Node& n : network_.getNodes()){
+		parents.push_back(n.getParents());
 	}
-	for (auto& pair : removedEdges){
-		network_.removeEdge(pair.second,pair.first);
+	for (auto& pair : addedEdges){
+		parents[pair.second].push_back(pair.first);
 	}
-	network_.addEdge(targetID,sourceID);
-	bool edgePossible = !network_.checkCycleExistence(sourceID);
-	network_.removeEdge(targetID,sourceID);
 	for (auto& pair : removedEdges){
-		network_.addEdge(pair.second,pair.first);
+		auto& p = parents[pair.second];
+		p.erase(std::remove(p.begin(), p.end(), pair.first), p.end());
 	}
-	for (auto& pair : addedEdges){
-		network_.removeEdge(pair.second,pair.first);
+	parents[targetID].push_back(sourceID);
+	// The edge induces a cycle if the source is its own ancestor
+	std::vector<bool> visited(parents.size(), false);
+	std::vector<unsigned int> stack(parents[sourceID]);
+	while (!stack.empty()){
+		unsigned int id = stack.back();
+		stack.pop_back();
+		if (id == sourceID){
+			return false;
+		}
+		if (!visited[id]){
+			visited[id] = true;
+			stack.insert(stack.end(), parents[id].begin(), parents[id].end());
+		}
 	}
-	return edgePossible;
+	return true;
 }
 
 void NetworkController::storeDiscretisedData(const std::string& filename) const{
@@ -3,6 +3,7 @@
 
 #include "Matrix.h"
 #include "Network.h"
+#include "EM.h"
 
 #include <string>
 #include <vector>
@@ -78,6 +79,27 @@ class NetworkController
 	 */
 	void trainNetwork();
 
+	/**
+	 * Trains the given network with the loaded observations using the EM
+	 * algorithm. The network must contain the nodes of the network of the
+	 * controller, e.g. a copy with changed edges. The training statistics are
+	 * only stored for the network of the controller.
+	 *
+	 * @param network the network to train
+	 */
+	void trainNetwork(Network& network);
+
+	/**
+	 * Retrains the given nodes of a network after their parents changed, e.g.
+	 * by edge additions or removals. Only the observations of these nodes are
+	 * recounted. If the data is complete, only their CPTs are estimated,
+	 * otherwise EM is run for the whole network.
+	 *
+	 * @param network the network to train, initialised by trainNetwork before
+	 * @param ids the identifiers of the nodes whose parents changed
+	 */
+	void trainNetwork(Network& network, const std::vector<unsigned int>& ids);
+
 	/**
 	 * @return the log-likelihood of the data
 	 */
@@ -93,11 +115,45 @@ class NetworkController
 	 */
 	const Network& getNetwork() const;
 
+	/**
+	 * Sets the number of random initialisations EM fits in addition to the
+	 * uniform and the data based one
+	 *
+	 * @param restarts number of random initialisations
+	 */
+	void setEMRestarts(unsigned int restarts);
+
+	/**
+	 * Sets the number of threads used by EM, 0 uses the global thread pool
+	 *
+	 * @param threads number of threads
+	 */
+	void setEMThreads(unsigned int threads);
+
+	/**
+	 * Sets the strategy EM uses to iterate E- and M-Phase
+	 *
+	 * @param strategy the EM strategy
+	 */
+	void setEMStrategy(EMStrategy strategy);
+
+	/**
+	 * @return the log-likelihood of all samples, including the incomplete
+	 * ones, given the trained parameters
+	 */
+	double getLogLikelihood() const;
+
 	/**
 	 * @return the number of executed EM iterations
 	 */
 	int getNumberOfEMRuns() const;
 
+	/**
+	 * @return a rough estimate of the number of EM iterations saved by the EM
+	 * strategy, see EM::getEstimatedNumberOfSavedRuns
+	 */
+	int getEstimatedNumberOfSavedEMRuns() const;
+
 	/**
 	 * @return the final Parameter difference in EM
 	 */ 
@@ -123,10 +179,12 @@ class NetworkController
 	 * @param removedEdges Edges that have been removed as part of a query.
 	 *
 	 * @return true, if the edge does not induce a cycle, false otherwise
+	 *
+	 * The network is not modified.
 	 */
 	bool isEdgePossible(unsigned int sourceID, unsigned int targetID,
-	                    std::vector<std::pair<unsigned int, unsigned int>>& addedEdges,
-	                    std::vector<std::pair<unsigned int, unsigned int>>& removedEdges);
+	                    const std::vector<std::pair<unsigned int, unsigned int>>& addedEdges,
+	                    const std::vector<std::pair<unsigned int, unsigned int>>& removedEdges) const;
 
 	/**storeDiscretisedData
 	 *
@@ -141,15 +199,33 @@ class NetworkController
 	//Matrix containing the discretised observations
 	Matrix<int> observations_;
 
+	//The unique discretised observations with their weights
+	SamplePatterns patterns_;
+
 	//Number of EM runs
 	int eMRuns_;
 
+	//Number of random EM initialisations
+	unsigned int eMRestarts_;
+
+	//Number of threads used by EM, 0 for the global thread pool
+	unsigned int eMThreads_;
+
+	//Strategy used by EM
+	EMStrategy eMStrategy_;
+
+	//Estimated number of EM runs saved by the strategy
+	int savedEMRuns_;
+
 	//Final EM parameter difference
 	float finalDifference_;
 
 	//Log Likelihood of the data
 	float likelihoodOfTheData_;
 
+	//Log-likelihood of all samples, including the incomplete ones
+	double logLikelihood_;
+
 	//Time in microseconds to perform EM
 	int timeInMicroSeconds_;
 };
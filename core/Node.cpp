@@ -4,7 +4,6 @@ Node::Node(unsigned int index, unsigned int id, const std::string& name)
 	: index_(index),
 	  id_(id),
 	  name_(name),
-	  DynProgMatrix_(0, 0, -1.0f),
 	  observationRow_(-1),
 	  parentCombinations_(0)
 {
@@ -12,48 +11,48 @@ Node::Node(unsigned int index, unsigned int id, const std::string& name)
 
 float Node::getProbability(unsigned int nv, unsigned int pv) const
 {
-	return ProbabilityMatrix_(nv, pv);
+	return ProbabilityMatrix_.get()(nv, pv);
 }
 
 void Node::setProbability(float value, unsigned int nv, unsigned int pv)
 {
-	ProbabilityMatrix_.setData(value, nv, pv);
+	ProbabilityMatrix_.getMutable().setData(value, nv, pv);
 }
 
 float Node::getProbability(const std::string& nv, const std::string& pv)
     const
 {
-	return ProbabilityMatrix_.getValueByNames(nv, pv);
+	return ProbabilityMatrix_.get().getValueByNames(nv, pv);
 }
 
 void Node::setProbability(float value, const std::string& nv,
                           const std::string& pv)
 {
-	ProbabilityMatrix_.setData(value, ProbabilityMatrix_.findCol(nv),
-	                           ProbabilityMatrix_.findRow(pv));
+	Matrix<float>& m = ProbabilityMatrix_.getMutable();
+	m.setData(value, m.findCol(nv), m.findRow(pv));
 }
 
 unsigned int Node::getObservations(unsigned int nv, unsigned int pv) const
 {
-	return ObservationMatrix_(nv, pv);
+	return ObservationMatrix_.get()(nv, pv);
 }
 
 void Node::setObservations(int value, unsigned int nv, unsigned int pv)
 {
-	ObservationMatrix_.setData(value, nv, pv);
+	ObservationMatrix_.getMutable().setData(value, nv, pv);
 }
 
 unsigned int Node::getObservations(const std::string& nv,
                                          const std::string& pv) const
 {
-	return ObservationMatrix_.getValueByNames(nv, pv);
+	return ObservationMatrix_.get().getValueByNames(nv, pv);
 }
 
 void Node::setObservations(int value, const std::string& nv,
                            const std::string& pv)
 {
-	ObservationMatrix_.setData(value, ObservationMatrix_.findCol(nv),
-	                           ObservationMatrix_.findRow(pv));
+	Matrix<int>& m = ObservationMatrix_.getMutable();
+	m.setData(value, m.findCol(nv), m.findRow(pv));
 }
 void Node::setProbability(const Matrix<float>& m) { ProbabilityMatrix_ = m; }
 
@@ -72,23 +71,34 @@ const unsigned int& Node::getID() const { return id_; }
 
 bool Node::hasValue(const std::string& v) const
 {
-	return ObservationMatrix_.findCol(v) > -1;
+	return ObservationMatrix_.get().findCol(v) > -1;
 }
 
-Matrix<float>& Node::getProbabilityMatrix() { return ProbabilityMatrix_; }
+Matrix<float>& Node::getProbabilityMatrix()
+{
+	return ProbabilityMatrix_.getMutable();
+}
 
 const Matrix<float>& Node::getProbabilityMatrix() const
 {
-	return ProbabilityMatrix_;
+	return ProbabilityMatrix_.get();
+}
+
+Matrix<int>& Node::getObservationMatrix()
+{
+	return ObservationMatrix_.getMutable();
 }
 
-Matrix<int>& Node::getObservationMatrix() { return ObservationMatrix_; }
+const Matrix<int>& Node::getObservationMatrix() const
+{
+	return ObservationMatrix_.get();
+}
 
 std::ostream& operator<<(std::ostream& os, const Node& n)
 {
 	os << "Node name: " << n.name_ << "\nNode id: " << n.id_
-	   << "\nObservation matrix:\n" << n.ObservationMatrix_
-	   << "\n\nProbability matrix:\n" << n.ProbabilityMatrix_ << std::endl;
+	   << "\nObservation matrix:\n" << n.ObservationMatrix_.get()
+	   << "\n\nProbability matrix:\n" << n.ProbabilityMatrix_.get() << std::endl;
 
 	return os;
 }
@@ -234,35 +244,38 @@ void Node::loadBackupDoIntervention()
 
 void Node::setProbabilityTo1(const std::string& value)
 {
-	for(unsigned int col = 0; col < ProbabilityMatrix_.getColCount(); col++) {
-		for(unsigned int row = 0; row < ProbabilityMatrix_.getRowCount();
-		    row++) {
-			ProbabilityMatrix_.setData(0.0f, col, row);
-		}
-	}
-	unsigned int col = ProbabilityMatrix_.findCol(value);
-	for(unsigned int row = 0; row < ProbabilityMatrix_.getRowCount(); row++) {
-		ProbabilityMatrix_.setData(1.0f, col, row);
-
-	}
+	setProbabilityTo1(ProbabilityMatrix_.get().findCol(value));
 }
 
 void Node::setProbabilityTo1(int value)
 {
-	for(unsigned int col = 0; col < ProbabilityMatrix_.getColCount(); col++) {
-		for(unsigned int row = 0; row < ProbabilityMatrix_.getRowCount();
-		    row++) {
-			ProbabilityMatrix_.setData(0.0f, col, row);
+	Matrix<float>& m = ProbabilityMatrix_.getMutable();
+	for(unsigned int col = 0; col < m.getColCount(); col++) {
+		for(unsigned int row = 0; row < m.getRowCount(); row++) {
+			m.setData(0.0f, col, row);
 		}
 	}
-	for(unsigned int row = 0; row < ProbabilityMatrix_.getRowCount(); row++) {
-		ProbabilityMatrix_.setData(1.0f, value, row);
+	for(unsigned int row = 0; row < m.getRowCount(); row++) {
+		m.setData(1.0f, value, row);
 	}
 }
 
+void Node::setIntervention(int value)
+{
+	const Matrix<float>& cpt = ProbabilityMatrix_.get();
+	if(value < 0 || static_cast<size_t>(value) >= cpt.getColCount()) {
+		throw std::invalid_argument("In Node::setIntervention, the value is "
+		                            "out of range");
+	}
+	Matrix<float> intervention(cpt.getColCount(), 1, 0.0f, cpt.getColNames());
+	intervention(value, 0) = 1.0f;
+	ProbabilityMatrix_ = intervention;
+	cutParents();
+}
+
 int Node::getIndex(const std::string& value) const
 {
-	return ProbabilityMatrix_.findCol(value);
+	return ProbabilityMatrix_.get().findCol(value);
 }
 
 void Node::clearNameVectors()
@@ -275,22 +288,6 @@ void Node::clearNameVectors()
 	uniqueValuesExcludingNA_.clear();
 }
 
-bool Node::isCalculated(unsigned int index, unsigned int row) const {
-	return (DynProgMatrix_(index,row) != -1.0f); 
-}
-
-void Node::setCalculatedValue(float value, unsigned int index, unsigned int row){
-	DynProgMatrix_.setData(value,index,row);
-}
-
-float Node::getCalculatedValue(unsigned int index, unsigned int row) const{
-	return DynProgMatrix_(index,row);
-}
-
-void Node::clearDynProgMatrix(){
-	DynProgMatrix_ = Matrix<float>(valueNamesProb_,parentValueNames_,-1.0f);
-}
-
 void Node::setParentValues(std::vector<std::vector<int>>& pValues){
 	parentValues_ = pValues;
 }
@@ -312,7 +309,6 @@ void Node::reset(){
 	ProbabilityMatrixBackup_ = Matrix<float>(0, 0, 0.0f);
     ObservationMatrix_ = Matrix<int>(0, 0, 0);
     ObservationBackup_ = Matrix<int>(0, 0, 0);
-	DynProgMatrix_ =Matrix<float>(0, 0, -1.0f);
 }
 
 void Node::setFactor(unsigned int factor, unsigned int id){
@@ -336,5 +332,5 @@ void Node::initialiseRevFactor(){
 	empty.clear();
 	empty.resize(getParents().size(),0);	
 	revFactor_.clear();
-	revFactor_.resize(ProbabilityMatrix_.getRowCount(),empty);
+	revFactor_.resize(ProbabilityMatrix_.get().getRowCount(),empty);
 }
@@ -1,6 +1,7 @@
 #ifndef NODE_H
 #define NODE_H
 #include "Matrix.h"
+#include "CopyOnWrite.h"
 
 class Node {
 	public:
@@ -126,6 +127,16 @@ class Node {
 	 * value are set to 1.0, all others to 0.0 * 
 	 */
 	void setProbabilityTo1(int value);
+
+	/**setIntervention
+	 *
+	 * @param value, node value in the dense integer representation
+	 *
+	 * Performs a "Do-Intervention" without modifying the CPT, which might be
+	 * shared with other copies of the node. The parents are cut and the CPT is
+	 * replaced by a single row in which the given value has probability 1.0.
+	 */
+	void setIntervention(int value);
 	
 	/**createBackupDoIntervention
 	 *
@@ -400,7 +411,8 @@ class Node {
 
 	/**getProbabilitiyMatrix
 	 *
-	 * @return A reference to the probability matrix
+	 * @return A reference to the probability matrix, which is copied first if
+	 * it is shared with a copy of the node
  	 *
 	 */
 	Matrix<float>& getProbabilityMatrix();
@@ -414,7 +426,8 @@ class Node {
 
 	/**getObservationMatrix
 	 *
-	 * @return A reference to the observation matrix
+	 * @return A reference to the observation matrix, which is copied first if
+	 * it is shared with a copy of the node
 	 *
 	 */
 	Matrix<int>& getObservationMatrix();
@@ -426,44 +439,6 @@ class Node {
 	 */
 	const Matrix<int>& getObservationMatrix() const;
 
-	/**isCalculated
-	 *
-	 * @param index, column in the CPT
-	 * @param row, row in the CPT
-	 *
-	 * @return True, if the Dynamic Programming Matrix contains an entry at the specified position,
-	 * False otherwise
-	 *
- 	 * Checks wheter the value at the specified position is already calculated
-	 */
-	bool isCalculated(unsigned int index, unsigned int row) const;
-
-	/**setCalculatedValue
-	 *
-	 * @param value, value to be stored
-	 * @param index, column in the CPT
-	 * @param row, row in the CPT
-	 *
- 	 * Sets the given value in the Dynamic Programming Matrix
-	 */
-	void setCalculatedValue(float value, unsigned int index, unsigned int row);
-
-	/**getCalculatedValue
-	 *
-	 * @param index, column of the CPT
-	 * @param row, row of the CPT
-	 *
-	 * @return entry of the Dynamic Programming Matrix at the specified position
-	 *
-	 */
-	float getCalculatedValue(unsigned int index, unsigned int row) const;
-
-	/**clearDynProgMatrix
-	 *
- 	 * Resets the Dynamic Programming Matrix
-	 */
-	void clearDynProgMatrix();
-
 	/**createBackup
 	 *
  	 * Creates a backup of the node
@@ -577,14 +552,13 @@ class Node {
 	//The name of the Node
 	std::string name_;
 	//Matrices storing the CPTs for a node, including a backup to restore
-	//the original state when interventions are reversed
-	Matrix<float> ProbabilityMatrix_;
-	Matrix<float> ProbabilityMatrixBackup_;
+	//the original state when interventions are reversed. Copies of a node
+	//share the matrices until one of them is modified.
+	CopyOnWrite<Matrix<float>> ProbabilityMatrix_;
+	CopyOnWrite<Matrix<float>> ProbabilityMatrixBackup_;
 	//Matrices storing the observation counts
-	Matrix<int> ObservationMatrix_;
-	Matrix<int> ObservationBackup_;
-	//Matrix to store results during dynamic programming to calculat total probabilities
-	Matrix<float> DynProgMatrix_;
+	CopyOnWrite<Matrix<int>> ObservationMatrix_;
+	CopyOnWrite<Matrix<int>> ObservationBackup_;
 	//Vector containing the integer representation of all unique values of this node
 	std::vector<int> uniqueValues_;
 	//Vector containing the names for all possible values (including NAs) of this node
@@ -1,7 +1,32 @@
 #include "ProbabilityHandler.h"
-#include "Combinations.h"
+#include "JunctionTree.h"
+#include "ThreadPool.h"
 
-ProbabilityHandler::ProbabilityHandler(Network& network) : network_(network) {}
+#include <set>
+
+ProbabilityHandler::ProbabilityHandler(const Network& network)
+    : network_(network),
+      heuristic_(EliminationHeuristic::WeightedMinFill),
+      parallel_(true),
+      parallelMinimalCost_(65536.0)
+{
+}
+
+void ProbabilityHandler::setParallelElimination(bool parallel, double minimalCost)
+{
+	parallel_ = parallel;
+	parallelMinimalCost_ = minimalCost;
+}
+
+void ProbabilityHandler::setEliminationHeuristic(EliminationHeuristic heuristic)
+{
+	heuristic_ = heuristic;
+}
+
+EliminationHeuristic ProbabilityHandler::getEliminationHeuristic() const
+{
+	return heuristic_;
+}
 
 float ProbabilityHandler::computeTotalProbabilityNormalized(int nodeID,
                                                             int index)
@@ -10,44 +35,12 @@ float ProbabilityHandler::computeTotalProbabilityNormalized(int nodeID,
 		throw std::invalid_argument(
 		    "The current node does contain the query value");
 	}
-
-	// Get Parents
-	Node& node = network_.getNode(nodeID);
-	const auto& parentIDs = node.getParents();
-	const auto& probMatrix = node.getProbabilityMatrix();
-
-	// Check Existens
-	if(node.getNumberOfParents() != 0) {
-		// Yes -> Call recursively for all parent values
-		float queryResult = 0.0f;
-
-		for(unsigned int row = 0; row < probMatrix.getRowCount(); row++) {
-			if(node.isCalculated(index, row)) {
-				queryResult += node.getCalculatedValue(index, row);
-			} else {
-				float temp = 1.0f;
-				for(unsigned int index2 = 0; index2 < node.getNumberOfParents();
-				    index2++) {
-					temp *= computeTotalProbability(
-					    parentIDs[index2],
-					    network_.reverseFactor(node,index2,row));
-				}
-				queryResult += (temp * probMatrix(index, row));
-			}
-		}
-		float norm = 0.0f;
-		unsigned int queryCol = index;
-		for(unsigned int col = 0; col < probMatrix.getColCount(); col++) {
-			if(col != queryCol) {
-				norm += computeTotalProbability(nodeID, col);
-			} else {
-				norm += queryResult;
-			}
-		}
-		return queryResult / norm;
+	auto priors = network_.getPriors(nodeID);
+	float norm = 0.0f;
+	for(float prior : *priors) {
+		norm += prior;
 	}
-	// No -> return value
-	return probMatrix(index, 0);
+	return (*priors)[index] / norm;
 }
 
 float ProbabilityHandler::computeTotalProbability(int nodeID, int index)
@@ -56,73 +49,14 @@ float ProbabilityHandler::computeTotalProbability(int nodeID, int index)
 		throw std::invalid_argument(
 		    "The current node does not contain the query value");
 	}
-
-	
-	// Get Parents
-	Node& node = network_.getNode(nodeID);
-	const auto& parentIDs = node.getParents();
-	const auto& probMatrix = node.getProbabilityMatrix();
-
-	// Check Existens
-	if(node.getNumberOfParents() != 0) {
-		// Yes -> Call recursively for all parent values
-		float result = 0.0f;
-		for(unsigned int row = 0; row < probMatrix.getRowCount(); row++) {
-			if(node.isCalculated(index, row)) {
-				result += node.getCalculatedValue(index, row);
-			} else {
-				float temp = 1.0f;
-				for(unsigned int index2 = 0; index2 < node.getNumberOfParents();
-				    index2++) {
-					temp *= computeTotalProbability(
-					    parentIDs[index2],
-					    network_.reverseFactor(node, index2, row));
-				}
-				float tempResult = temp * probMatrix(index, row);
-				node.setCalculatedValue(tempResult, index, row);
-				result += tempResult;
-			}
-		}
-		return result;
-	}
-	// No -> return value
-	return probMatrix(index, 0);
+	return (*network_.getPriors(nodeID))[index];
 }
 
 std::vector<unsigned int> ProbabilityHandler::createFactorisation(
-    const std::vector<unsigned int>& queryNodes)
-{
-	std::vector<unsigned int> visitedNodes;
-	network_.setAllUnvisited();
-	for(auto& id : queryNodes) {
-		network_.performDFS(id, visitedNodes);
-	}
-	return visitedNodes;
-}
-
-std::vector<std::vector<int>>
-ProbabilityHandler::assignValues(const std::vector<unsigned int>& factorisation,
-                                 const std::vector<int>& values)
-{
-	std::vector<std::vector<int>> possibleValueMap(values.size(), {-1});
-	for(unsigned int id : factorisation) {
-		if(values[id] != -1) {
-			possibleValueMap[id] = {values[id]};
-		} else {
-			possibleValueMap[id] =
-			    network_.getNode(id).getUniqueValuesExcludingNA();
-		}
-	}
-	return possibleValueMap;
-}
-
-std::vector<std::vector<int>> ProbabilityHandler::enumerate(
-    const std::vector<unsigned int>& factorisation,
-    const std::vector<std::vector<int>>& valueAssignment)
+    const std::vector<unsigned int>& queryNodes,
+    const std::vector<unsigned int>& conditionNodes) const
 {
-	Combinations<int> com(factorisation, valueAssignment);
-	com.createCombinations(0);
-	return com.getResult();
+	return network_.getRequisiteNodes(queryNodes, conditionNodes);
 }
 
 int ProbabilityHandler::getParentValues(const Node& n, const Matrix<int>& obs,
@@ -143,12 +77,19 @@ int ProbabilityHandler::getParentValues(const Node& n, const Matrix<int>& obs,
 float ProbabilityHandler::calculateLikelihoodOfTheData(const Matrix<int>& obs)
     const
 {
-	if (obs.getColCount() > 0){
+	return calculateLikelihoodOfTheData(SamplePatterns(obs));
+}
+
+float ProbabilityHandler::calculateLikelihoodOfTheData(
+    const SamplePatterns& patterns) const
+{
+	if (patterns.size() > 0){
+		const Matrix<int>& obs = patterns.getPatterns();
 		float prob = 0.0f;
 		for(unsigned int sample = 0; sample < obs.getColCount(); sample++) {
 	
 			if(!obs.containsElement(0, sample, -1)) {
-				float intermediateResult = 1.0f;
+				float intermediateResult = patterns.getWeights()[sample];
 	
 				for(const Node& n : network_.getNodes()) {
 					int row = getParentValues(n, obs, sample);
@@ -180,72 +121,268 @@ std::vector<Factor> ProbabilityHandler::createFactorList(
 
 std::vector<unsigned int>
 ProbabilityHandler::getOrdering(const std::vector<unsigned int>& factorisation,
-                                const std::vector<unsigned int>& queryNodes)
-    const
+                                const std::vector<unsigned int>& queryNodes,
+                                const std::vector<int>& values) const
 {
 	auto temp = queryNodes;
+	std::vector<unsigned int> hidden;
 	for(auto& id : factorisation) {
 		if(std::find(queryNodes.begin(), queryNodes.end(), id) ==
 		   queryNodes.end()) {
-			temp.push_back(id);
+			hidden.push_back(id);
 		}
 	}
+	EliminationOrdering ordering(network_, factorisation, values);
+	hidden = ordering.getOrdering(hidden, heuristic_);
+	temp.insert(temp.end(), hidden.begin(), hidden.end());
 	return temp;
 }
 
 std::vector<unsigned int> ProbabilityHandler::getOrdering(
     const std::vector<unsigned int>& factorisation,
     const std::vector<unsigned int>& conditionNodes,
-    const std::vector<unsigned int>& nonInterventionNodes) const
+    const std::vector<unsigned int>& nonInterventionNodes,
+    const std::vector<int>& values) const
 {
 	auto temp = conditionNodes;
+	std::vector<unsigned int> hidden;
 	for(auto& id : factorisation) {
 		if((std::find(conditionNodes.begin(), conditionNodes.end(), id) ==
 		   conditionNodes.end()) && (std::find(nonInterventionNodes.begin(), nonInterventionNodes.end(), id) == nonInterventionNodes.end())) {
-			temp.push_back(id);
+			hidden.push_back(id);
 		}
 	}
+	EliminationOrdering ordering(network_, factorisation, values);
+	hidden = ordering.getOrdering(hidden, heuristic_);
+	temp.insert(temp.end(), hidden.begin(), hidden.end());
 	for(auto& id : nonInterventionNodes) {
 		temp.push_back(id);
 	}
 	return temp;
 }
 
-void ProbabilityHandler::eliminate(const unsigned int id,
-                                   std::vector<Factor>& factorlist,
-                                   const std::vector<int>& values,
-									const std::vector<int>& nonInterventionValues = {})
+QueryPlanKey ProbabilityHandler::createPlanKey(
+    const std::vector<unsigned int>& queryNodes,
+    const std::vector<unsigned int>& conditionNodes,
+    const std::vector<int>& values,
+    const std::vector<int>& nonInterventionValues) const
 {
-	std::vector<unsigned int> neededFactors;
-	std::vector<std::vector<unsigned int>> neededFactorsIDs;
-	for(unsigned int i = 0; i < factorlist.size(); i++) {
-		Factor& f = factorlist[i];
-		if(std::find(f.getIDs().begin(), f.getIDs().end(), id) !=
-		   f.getIDs().end()) {
-			neededFactors.push_back(i);
-			neededFactorsIDs.push_back(f.getIDs());
+	QueryPlanKey key;
+	key.queryNodes = queryNodes;
+	key.conditionNodes = conditionNodes;
+	key.heuristic = heuristic_;
+	key.nodeStates.reserve(network_.size());
+	for(const Node& n : network_.getNodes()) {
+		int state = n.getNumberOfParents() << 2;
+		if(values[n.getID()] != -1) {
+			state |= 1;
+		}
+		if(!nonInterventionValues.empty() &&
+		   nonInterventionValues[n.getID()] != -1) {
+			state |= 2;
+		}
+		key.nodeStates.push_back(state);
+	}
+	return key;
+}
+
+QueryPlan ProbabilityHandler::createPlan(
+    const std::vector<unsigned int>& queryNodes,
+    const std::vector<unsigned int>& conditionNodes,
+    const std::vector<int>& values,
+    const std::vector<int>& nonInterventionValues)
+{
+	QueryPlan plan;
+	if(conditionNodes.empty()) {
+		plan.factorisation = createFactorisation(queryNodes);
+		plan.ordering = getOrdering(plan.factorisation, queryNodes, values);
+	} else {
+		plan.factorisation = createFactorisation(queryNodes, conditionNodes);
+		plan.ordering = getOrdering(plan.factorisation, conditionNodes,
+		                            queryNodes, values);
+	}
+	for(auto& id : plan.factorisation) {
+		const Node& n = network_.getNode(id);
+		std::vector<unsigned int> scope{id};
+		scope.insert(scope.end(), n.getParents().begin(), n.getParents().end());
+		plan.scopes.push_back(scope);
+	}
+	// Simulate the elimination on the scopes of the factors
+	std::vector<bool> alive(plan.scopes.size(), true);
+	// The step that wrote each factor last, -1 for factors created from the CPTs
+	std::vector<int> writer(plan.scopes.size(), -1);
+	plan.cost = 0.0;
+	for(auto& id : plan.ordering) {
+		EliminationStep step;
+		step.id = id;
+		step.observed = values[id] != -1;
+		step.sumOut = nonInterventionValues.empty() ||
+		              nonInterventionValues[id] == -1;
+		step.result = -1;
+		step.cost = 0.0;
+		step.dependencies = 0;
+		unsigned int index = plan.steps.size();
+		for(unsigned int i = 0; i < plan.scopes.size(); i++) {
+			const auto& scope = plan.scopes[i];
+			if(alive[i] && std::find(scope.begin(), scope.end(), id) != scope.end()) {
+				step.factors.push_back(i);
+			}
+		}
+		std::set<unsigned int> predecessors;
+		for(auto& i : step.factors) {
+			if(writer[i] != -1) {
+				predecessors.insert(writer[i]);
+			}
+		}
+		for(auto& predecessor : predecessors) {
+			plan.steps[predecessor].successors.push_back(index);
 		}
+		step.dependencies = predecessors.size();
+		if(step.observed) {
+			for(auto& i : step.factors) {
+				auto& scope = plan.scopes[i];
+				scope.erase(std::find(scope.begin(), scope.end(), id));
+				writer[i] = index;
+			}
+		} else if(!step.factors.empty()) {
+			std::vector<unsigned int> scope;
+			for(auto& i : step.factors) {
+				for(auto& other : plan.scopes[i]) {
+					if(std::find(scope.begin(), scope.end(), other) == scope.end()) {
+						scope.push_back(other);
+					}
+				}
+				alive[i] = false;
+			}
+			step.cost = 1.0;
+			for(auto& other : scope) {
+				if(values[other] == -1) {
+					step.cost *= network_.getNode(other)
+					                 .getNumberOfUniqueValuesExcludingNA();
+				}
+			}
+			step.cost *= step.factors.size();
+			if(step.sumOut) {
+				scope.erase(std::find(scope.begin(), scope.end(), id));
+			}
+			step.result = plan.scopes.size();
+			plan.scopes.push_back(scope);
+			alive.push_back(true);
+			writer.push_back(index);
+		}
+		plan.cost += step.cost;
+		plan.steps.push_back(step);
+	}
+	for(unsigned int i = 0; i < alive.size(); i++) {
+		if(alive[i]) {
+			plan.results.push_back(i);
+		}
+	}
+	return plan;
+}
+
+std::shared_ptr<const QueryPlan> ProbabilityHandler::getPlan(
+    const std::vector<unsigned int>& queryNodes,
+    const std::vector<unsigned int>& conditionNodes,
+    const std::vector<int>& values,
+    const std::vector<int>& nonInterventionValues)
+{
+	QueryPlanCache& cache = network_.getQueryPlanCache();
+	QueryPlanKey key =
+	    createPlanKey(queryNodes, conditionNodes, values, nonInterventionValues);
+	auto plan = cache.find(key);
+	if(plan != nullptr) {
+		return plan;
 	}
-	Factor tempFactor = factorlist[neededFactors[0]];
-	if(neededFactors.size() > 1) {
-		for(unsigned int i = 1; i < neededFactors.size(); i++) {
-			tempFactor = tempFactor.product(factorlist[neededFactors[i]],network_,values);
+	return cache.insert(key, createPlan(queryNodes, conditionNodes, values,
+	                                    nonInterventionValues));
+}
+
+void ProbabilityHandler::executeStep(const EliminationStep& step,
+                                     std::vector<Factor>& factorlist) const
+{
+	if(step.observed) {
+		for(auto& i : step.factors) {
+			factorlist[i] = factorlist[i].sumOut(step.id);
 		}
+	} else if(!step.factors.empty()) {
+		std::vector<unsigned int> none;
+		Factor tempFactor = std::move(factorlist[step.factors[0]]);
+		for(unsigned int i = 1; i < step.factors.size(); i++) {
+			tempFactor = tempFactor.product(factorlist[step.factors[i]]);
+			factorlist[step.factors[i]] = Factor(none, none);
+		}
+		if(step.sumOut) {
+			tempFactor = tempFactor.sumOut(step.id);
+		}
+		factorlist[step.result] = std::move(tempFactor);
 	}
-	if (nonInterventionValues.empty() || values[id] != -1 || (values[id] == -1 && nonInterventionValues[id] == -1)) {
-		tempFactor = tempFactor.sumOut(id, network_, values);
+}
+
+void ProbabilityHandler::executeStepsInParallel(const QueryPlan& plan,
+                                                std::vector<Factor>& factorlist) const
+{
+	ThreadPool& pool = ThreadPool::getGlobalPool();
+	std::unique_ptr<std::atomic<unsigned int>[]> dependencies(
+	    new std::atomic<unsigned int>[plan.steps.size()]);
+	for(unsigned int i = 0; i < plan.steps.size(); i++) {
+		dependencies[i] = plan.steps[i].dependencies;
 	}
-	for(auto& neededFactorID : neededFactorsIDs) {
-		auto it = factorlist.begin();
-		for(; it != factorlist.end();) {
-			if(it->getIDs() == neededFactorID) {
-				it = factorlist.erase(it);
-			} else {
-				++it;
+	std::atomic<unsigned int> unfinished(plan.steps.size());
+	std::exception_ptr error;
+	std::mutex errorMutex;
+	// The workers allocate their factors from the arena of the calling thread
+	QueryArena* arena = QueryArena::getCurrent();
+	// A finished step starts all successors whose factors are complete
+	std::function<void(unsigned int)> run = [&](unsigned int index) {
+		QueryArena::Scope scope(arena);
+		try {
+			executeStep(plan.steps[index], factorlist);
+		} catch(...) {
+			std::lock_guard<std::mutex> lock(errorMutex);
+			if(!error) {
+				error = std::current_exception();
+			}
+		}
+		for(auto& successor : plan.steps[index].successors) {
+			if(--dependencies[successor] == 0) {
+				pool.submit([&run, successor] { run(successor); });
 			}
 		}
+		unfinished--;
+	};
+	for(unsigned int i = 0; i < plan.steps.size(); i++) {
+		if(plan.steps[i].dependencies == 0) {
+			pool.submit([&run, i] { run(i); });
+		}
+	}
+	pool.waitUntil([&unfinished] { return unfinished == 0; });
+	if(error) {
+		std::rethrow_exception(error);
+	}
+}
+
+std::vector<Factor> ProbabilityHandler::executePlan(const QueryPlan& plan,
+                                                    const std::vector<int>& values)
+    const
+{
+	std::vector<unsigned int> none;
+	auto factorlist = createFactorList(plan.factorisation, values);
+	factorlist.resize(plan.scopes.size(), Factor(none, none));
+	// The calling thread helps the workers, so even a single worker pays off
+	if(parallel_ && plan.cost >= parallelMinimalCost_) {
+		executeStepsInParallel(plan, factorlist);
+	} else {
+		for(auto& step : plan.steps) {
+			executeStep(step, factorlist);
+		}
+	}
+	std::vector<Factor> result;
+	result.reserve(plan.results.size());
+	for(auto& i : plan.results) {
+		result.push_back(std::move(factorlist[i]));
 	}
-	factorlist.push_back(tempFactor);
+	return result;
 }
 
 float ProbabilityHandler::getResult(std::vector<Factor>& factorlist)
@@ -275,12 +412,8 @@ float ProbabilityHandler::getResult(std::vector<Factor>& factorlist, const std::
 float ProbabilityHandler::computeJointProbabilityUsingVariableElimination(
     const std::vector<unsigned int>& queryNodes, const std::vector<int>& values)
 {
-	auto factorisation = createFactorisation(queryNodes);
-	auto factorlist = createFactorList(factorisation, values);
-	auto ordering = getOrdering(factorisation, queryNodes);
-	for(auto& id : ordering) {
-		eliminate(id, factorlist, values);
-	}
+	auto plan = getPlan(queryNodes, {}, values, {});
+	auto factorlist = executePlan(*plan, values);
 	return getResult(factorlist);
 }
 
@@ -289,77 +422,156 @@ float ProbabilityHandler::computeConditionalProbability(
     const std::vector<unsigned int>& nodesCondition,
     const std::vector<int>& valuesNonIntervention,
     const std::vector<int>& valuesCondition)
-{	
-	auto allNodes = nodesNonIntervention;
-	allNodes.insert(allNodes.end(), nodesCondition.begin(), nodesCondition.end());
-	auto factorisation = createFactorisation(allNodes);
-	auto factorlist = createFactorList(factorisation, valuesCondition);
-	auto ordering = getOrdering(factorisation, nodesCondition, nodesNonIntervention);
-	for (auto& id : ordering) {
-		eliminate(id, factorlist, valuesCondition, valuesNonIntervention);
-	}
+{
+	auto plan = getPlan(nodesNonIntervention, nodesCondition, valuesCondition,
+	                    valuesNonIntervention);
+	auto factorlist = executePlan(*plan, valuesCondition);
 	return getResult(factorlist,valuesNonIntervention);
 }
 
+std::vector<std::vector<float>>
+ProbabilityHandler::computePosteriors(const std::vector<int>& values)
+{
+	JunctionTree tree(network_, heuristic_);
+	tree.calibrate(values);
+	std::vector<std::vector<float>> posteriors;
+	posteriors.reserve(network_.size());
+	for(const Node& n : network_.getNodes()) {
+		std::vector<float> posterior(n.getNumberOfUniqueValuesExcludingNA(), 0.0f);
+		if(values[n.getID()] != -1) {
+			posterior[values[n.getID()]] = 1.0f;
+		} else {
+			Factor marginal = tree.getMarginal({n.getID()});
+			for(unsigned int value = 0; value < posterior.size(); value++) {
+				posterior[value] = marginal.getProbability(value);
+			}
+		}
+		posteriors.push_back(posterior);
+	}
+	return posteriors;
+}
+
+std::vector<float> ProbabilityHandler::computeProbabilities(
+    const std::vector<std::vector<unsigned int>>& queryNodes,
+    const std::vector<std::vector<int>>& queryValues,
+    const std::vector<unsigned int>& conditionNodes,
+    const std::vector<int>& conditionValues)
+{
+	if(queryNodes.size() != queryValues.size()) {
+		throw std::invalid_argument("In computeProbabilities, the number of "
+		                            "query nodes and query values differ");
+	}
+	JunctionTree tree(network_, heuristic_);
+	tree.calibrate(conditionValues);
+	std::vector<float> probabilities;
+	probabilities.reserve(queryNodes.size());
+	for(unsigned int i = 0; i < queryNodes.size(); i++) {
+		if(tree.findClique(queryNodes[i]) != -1) {
+			probabilities.push_back(
+			    tree.getProbability(queryNodes[i], queryValues[i]));
+		} else if(conditionNodes.empty()) {
+			probabilities.push_back(computeJointProbabilityUsingVariableElimination(
+			    queryNodes[i], queryValues[i]));
+		} else {
+			probabilities.push_back(computeConditionalProbability(
+			    queryNodes[i], conditionNodes, queryValues[i], conditionValues));
+		}
+	}
+	return probabilities;
+}
+
+Factor ProbabilityHandler::collectFactors(unsigned int id,
+                                          std::vector<Factor>& factorlist) const
+{
+	std::vector<unsigned int> none;
+	Factor product(none, none);
+	product.setProbability(1.0f, 0);
+	std::vector<Factor> remaining;
+	remaining.reserve(factorlist.size());
+	for(auto& f : factorlist) {
+		const auto& ids = f.getIDs();
+		if(std::find(ids.begin(), ids.end(), id) != ids.end()) {
+			product = product.product(f);
+		} else {
+			remaining.push_back(std::move(f));
+		}
+	}
+	factorlist = std::move(remaining);
+	return product;
+}
+
 std::pair<float, std::vector<std::string>>
 ProbabilityHandler::maxSearch(const std::vector<unsigned int>& queryNodes,
                               const std::vector<unsigned int>& conditionNodes = {},
                               const std::vector<int>& conditionValues = {})
 {
-	std::vector<int> emptyValues(network_.size(), -1);
-	std::vector<std::vector<int>> queryAssignment =
-	    assignValues(queryNodes, emptyValues);
-	std::vector<std::vector<int>> combinations =
-	    enumerate(queryNodes, queryAssignment);
-
-	int index = 0;
-	int maxIndex = 0;
-	float maxprob = 0.0f;
-
-	if(queryNodes.size() > 1) {
-		for(auto& com : combinations) {
-			float prob = 0.0f;
-			for(auto& id : queryNodes) {
-				emptyValues[id] = com[id];
-			}
-			if (conditionNodes.empty()) {
-				prob = computeJointProbabilityUsingVariableElimination(
-				    queryNodes, emptyValues);
-			} else {
-				prob = computeConditionalProbability(
-				    queryNodes, conditionNodes, emptyValues, conditionValues);
-			}
-			if(prob > maxprob) {
-				maxprob = prob;
-				maxIndex = index;
+	std::vector<int> values = conditionValues;
+	values.resize(network_.size(), -1);
+	auto factorisation = createFactorisation(queryNodes, conditionNodes);
+	auto factorlist = createFactorList(factorisation, values);
+	for(auto& f : factorlist) {
+		auto ids = f.getIDs();
+		for(auto& id : ids) {
+			if(values[id] != -1) {
+				f = f.sumOut(id);
 			}
-			index++;
 		}
-	} else {
-		for(auto& com : combinations) {
-			float prob = 0.0f;
-			if(conditionNodes.empty()) {
-				prob =
-				    computeTotalProbabilityNormalized(queryNodes[0], com[queryNodes[0]]);
-			} else {
-				emptyValues[queryNodes[0]]=com[queryNodes[0]];
-				prob = computeConditionalProbability(
-				    {queryNodes[0]}, conditionNodes, emptyValues,
-				    conditionValues);
-			}
-			if(prob > maxprob) {
-				maxprob = prob;
-				maxIndex = index;
+	}
+	std::vector<unsigned int> hidden;
+	std::vector<unsigned int> maxNodes;
+	for(auto& id : factorisation) {
+		if(values[id] == -1 && std::find(queryNodes.begin(), queryNodes.end(),
+		                                 id) == queryNodes.end()) {
+			hidden.push_back(id);
+		}
+	}
+	for(auto& id : queryNodes) {
+		if(values[id] == -1) {
+			maxNodes.push_back(id);
+		}
+	}
+
+	// Hidden nodes are summed out before the query nodes are maximised out
+	EliminationOrdering ordering(network_, factorisation, values);
+	for(auto& id : ordering.getOrdering(hidden, heuristic_)) {
+		factorlist.push_back(collectFactors(id, factorlist).sumOut(id));
+	}
+	auto maxOrdering = ordering.getOrdering(maxNodes, heuristic_);
+	// Pruned factors are only proportional to the distribution given the evidence
+	auto normalisation = factorlist;
+	for(auto& id : maxOrdering) {
+		normalisation.push_back(collectFactors(id, normalisation).sumOut(id));
+	}
+	std::vector<Factor> traceback;
+	traceback.reserve(maxOrdering.size());
+	for(auto& id : maxOrdering) {
+		traceback.push_back(collectFactors(id, factorlist));
+		factorlist.push_back(traceback.back().maxOut(id));
+	}
+	float maxprob = getResult(factorlist) / getResult(normalisation);
+
+	// The maximising value of a node only depends on nodes maximised out later
+	for(int i = maxOrdering.size() - 1; i >= 0; i--) {
+		unsigned int id = maxOrdering[i];
+		unsigned int cardinality =
+		    network_.getNode(id).getNumberOfUniqueValuesExcludingNA();
+		int maxValue = 0;
+		float maxValueProb = -1.0f;
+		for(unsigned int value = 0; value < cardinality; value++) {
+			values[id] = value;
+			float prob = traceback[i].getProbability(values);
+			if(prob > maxValueProb) {
+				maxValueProb = prob;
+				maxValue = value;
 			}
-			index++;
 		}
+		values[id] = maxValue;
 	}
-	std::vector<std::string> resultNames;
 
+	std::vector<std::string> resultNames;
 	for(auto& id : queryNodes) {
-		int value = combinations[maxIndex][id];
 		const Node& node = network_.getNode(id);
-		resultNames.push_back(node.getValueNamesProb()[value]);
+		resultNames.push_back(node.getValueNamesProb()[values[id]]);
 	}
 	return std::make_pair(maxprob, resultNames);
 }
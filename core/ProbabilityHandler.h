@@ -3,6 +3,8 @@
 
 #include "Network.h"
 #include "Factor.h"
+#include "EliminationOrdering.h"
+#include "SamplePatterns.h"
 
 class ProbabilityHandler
 {
@@ -23,16 +25,60 @@ class ProbabilityHandler
 	 *
 	 * This objects performs various kinds of probability calculations
 	 */
-	explicit ProbabilityHandler(Network& network);
+	explicit ProbabilityHandler(const Network& network);
 
 	ProbabilityHandler(const ProbabilityHandler& o)
-		: network_(o.network_)
+		: network_(o.network_),
+		  heuristic_(o.heuristic_),
+		  parallel_(o.parallel_),
+		  parallelMinimalCost_(o.parallelMinimalCost_)
+	{
+	}
+
+	/**ProbabilityHandler
+	 *
+	 * @param o, the ProbabilityHandler whose settings are copied
+	 * @param network, a reference to the network the new handler works on
+	 *
+	 * @return ProbabilityHandler object
+	 */
+	ProbabilityHandler(const ProbabilityHandler& o, const Network& network)
+		: network_(network),
+		  heuristic_(o.heuristic_),
+		  parallel_(o.parallel_),
+		  parallelMinimalCost_(o.parallelMinimalCost_)
 	{
 	}
 
 	ProbabilityHandler& operator=(const ProbabilityHandler&) = delete;
 	ProbabilityHandler& operator=(ProbabilityHandler&&) = delete;
 
+	/**setEliminationHeuristic
+	 *
+	 * @param heuristic, the heuristic used to order the nodes during variable elimination
+	 *
+	 * Selects the elimination ordering heuristic, the default is WeightedMinFill
+	 */
+	void setEliminationHeuristic(EliminationHeuristic heuristic);
+
+	/**getEliminationHeuristic
+	 *
+	 * @return the heuristic used to order the nodes during variable elimination
+	 */
+	EliminationHeuristic getEliminationHeuristic() const;
+
+	/**setParallelElimination
+	 *
+	 * @param parallel, true if independent subtrees of the elimination tree should be
+	 * eliminated in parallel
+	 * @param minimalCost, minimal number of factor entries computed by a query to
+	 * use the global thread pool (default is 65536)
+	 *
+	 * Parallel elimination is enabled by default. The results do not depend on
+	 * this setting.
+	 */
+	void setParallelElimination(bool parallel, double minimalCost = 65536.0);
+
 	/**computeTotalProbability
 	 *
 	 * @param nodeID, identifier of the node in focus
@@ -40,6 +86,8 @@ class ProbabilityHandler
 	 *
 	 * @return total probability that the given value can be observerd in the given node
 	 *
+	 * The value is looked up in the total probabilities stored by the network,
+	 * see Network::getPriors
 	 */
 	float computeTotalProbability(int nodeID, int value);
 	
@@ -81,6 +129,37 @@ class ProbabilityHandler
 	    const std::vector<int>& valuesNonIntervention,
 	    const std::vector<int>& valuesCondition);
 
+	/**computePosteriors
+	 *
+	 * @param values, vector containing the values of the evidence nodes, -1 for all other nodes
+	 *
+	 * @return for every node the probability of each of its values given the evidence.
+	 * The index of the outer vector equals the node identifier.
+	 *
+	 * The posteriors of all nodes are computed using a single calibration of a junction tree
+	 */
+	std::vector<std::vector<float>>
+	computePosteriors(const std::vector<int>& values);
+
+	/**computeProbabilities
+	 *
+	 * @param queryNodes, for every query a vector containing the identifiers of its query nodes
+	 * @param queryValues, for every query a vector containing the values for its query nodes
+	 * @param conditionNodes, vector containing the identifiers of the evidence nodes shared by all queries
+	 * @param conditionValues, vector containing the evidence values shared by all queries
+	 *
+	 * @return for every query the probability of its values given the evidence
+	 *
+	 * The evidence is entered once into a junction tree, afterwards every query
+	 * whose nodes are contained in a single clique is answered from the calibrated
+	 * tree. All other queries are computed using variable elimination.
+	 */
+	std::vector<float>
+	computeProbabilities(const std::vector<std::vector<unsigned int>>& queryNodes,
+	                     const std::vector<std::vector<int>>& queryValues,
+	                     const std::vector<unsigned int>& conditionNodes,
+	                     const std::vector<int>& conditionValues);
+
 	/**maxSearch
 	 *
 	 * @param queryNodes, vector containing the identifiers of the query nodes
@@ -89,6 +168,9 @@ class ProbabilityHandler
 	 *
 	 * @return a pair of the MAP assignment for the query nodes, and the corresponding probability
 	 *
+	 * All other nodes are summed out first, afterwards the query nodes are maximised
+	 * out. The MAP assignment is recovered by tracing back the maximising values
+	 * in reverse elimination order, hence a single elimination pass is required.
 	 */
 	std::pair<float, std::vector<std::string>>
 	maxSearch(const std::vector<unsigned int>& queryNodes,
@@ -104,45 +186,31 @@ class ProbabilityHandler
 	 */
 	float calculateLikelihoodOfTheData(const Matrix<int>& obs) const;
 
-	private:
-
-	/**createFactorisation
+	/**calculateLikelihoodOfTheData
 	 *
-	 * @param queryNodes, vector of all node identifiers in the query
+	 * @param patterns, the unique discretised samples with their weights
 	 *
-	 * @return list of all node identifiers which have to be considered for calculating the user query
+	 * @return the log likelihood of the data
 	 *
-	 * The procedure performs DFS for all query nodes to generate the factorisation
 	 */
-	std::vector<unsigned int>
-	createFactorisation(const std::vector<unsigned int>& queryNodes);
+	float calculateLikelihoodOfTheData(const SamplePatterns& patterns) const;
 
-	/**assignValues
-	 *
-	 * @param factorisation, factorisation of the query nodes
-	 * @param values, vector containing known node values
-	 *
-	 * @return A vector of vector containing possible node value. The index of the outer vector
-	 * equals the node identifier for whom the inner vector reflects the possible values
-	 *
-	 */
-	std::vector<std::vector<int>>
-	assignValues(const std::vector<unsigned int>& factorisation,
-	             const std::vector<int>& values);
+	private:
 
-	/**enumerate
-	 *
-	 * @param factorisation, factorisation of the query nodes
-	 * @param valueAssignment, value assignment produced by the procedure assignValues
+	/**createFactorisation
 	 *
-	 * @return An enumeration of all possible value combinations for the nodes
-	 * in the factorisation. This uses the class Combinations.
+	 * @param queryNodes, vector of all node identifiers in the query
+	 * @param conditionNodes, vector of the evidence node identifiers (optional)
 	 *
+	 * @return list of all node identifiers which have to be considered for calculating the user query
 	 *
+	 * Nodes that are irrelevant for the query given the evidence are pruned
+	 * using the Bayes-Ball algorithm. Without evidence, the factorisation
+	 * contains all ancestors of the query nodes.
 	 */
-	std::vector<std::vector<int>>
-	enumerate(const std::vector<unsigned int>& factorisation,
-	          const std::vector<std::vector<int>>& valueAssignment);
+	std::vector<unsigned int>
+	createFactorisation(const std::vector<unsigned int>& queryNodes,
+	                    const std::vector<unsigned int>& conditionNodes = {}) const;
 
 	/**getParentValues
 	 *
@@ -179,6 +247,15 @@ class ProbabilityHandler
 	float getResult(std::vector<Factor>& factorlist,
 	                const std::vector<int>& values);
 
+	/**collectFactors
+	 *
+	 * @param id, identifier of the node to eliminate
+	 * @param factorlist, vector of factors
+	 *
+	 * @return the product of all factors containing the node, which are removed from the list
+	 */
+	Factor collectFactors(unsigned int id, std::vector<Factor>& factorlist) const;
+
 	/**createFactorList
 	 *
 	 * @param factorisation, factorisation produced for the query nodes
@@ -196,19 +273,22 @@ class ProbabilityHandler
 	 *
 	 * @param factorisation, factorisation produced for the query nodes
 	 * @param queryNodes, vector containing identifiers of the query nodes
+	 * @param values, vector containing the known values
 	 *
 	 * @return a elimination ordering (for joint probabilities)
 	 *
 	 */
 	std::vector<unsigned int>
 	getOrdering(const std::vector<unsigned int>& factorisation,
-	            const std::vector<unsigned int>& queryNodes) const;
+	            const std::vector<unsigned int>& queryNodes,
+	            const std::vector<int>& values) const;
 
 	/**getOrdering
 	 *
 	 * @param factorisation, factorisation produced for the query nodes
 	 * @param conditionNodes, vector containing the identifiers of the evidence nodes
 	 * @param nonInternventionNodes, vector containing the identifiers of the none evidence nodes
+	 * @param values, vector containing the values of the evidence nodes
 	 *
 	 * @return a elimination ordering (for conditional probabilities)
 	 *
@@ -216,23 +296,95 @@ class ProbabilityHandler
 	std::vector<unsigned int>
 	getOrdering(const std::vector<unsigned int>& factorisation,
 	            const std::vector<unsigned int>& conditionNodes,
-	            const std::vector<unsigned int>& nonInterventionNodes) const;
+	            const std::vector<unsigned int>& nonInterventionNodes,
+	            const std::vector<int>& values) const;
 
-	/**eliminate
+	/**createPlanKey
 	 *
-	 * @param factorlist, vector of factors
-	 * @param values, vector of known values
-	 * @param nonInterventionValues, vector of values for non evidence nodes
+	 * @param queryNodes, vector containing the identifiers of the query nodes
+	 * @param conditionNodes, vector containing the identifiers of the evidence nodes
+	 * @param values, vector containing the known values
+	 * @param nonInterventionValues, vector of values for non evidence nodes (empty for joint probabilities)
+	 *
+	 * @return the key describing the structure of the query, independent of its values
+	 */
+	QueryPlanKey createPlanKey(const std::vector<unsigned int>& queryNodes,
+	                           const std::vector<unsigned int>& conditionNodes,
+	                           const std::vector<int>& values,
+	                           const std::vector<int>& nonInterventionValues) const;
+
+	/**createPlan
+	 *
+	 * @param queryNodes, vector containing the identifiers of the query nodes
+	 * @param conditionNodes, vector containing the identifiers of the evidence nodes
+	 * @param values, vector containing the known values
+	 * @param nonInterventionValues, vector of values for non evidence nodes (empty for joint probabilities)
 	 *
-	 * Performs the elimination operation using the product and sumOut
-	 * methods in the class Factor
+	 * @return a plan containing the factorisation, the elimination ordering and
+	 * the factors used in every elimination step. Observed nodes are removed from
+	 * every factor separately, as they do not need to be multiplied.
 	 */
-	void eliminate(const unsigned int id, std::vector<Factor>& factorlist,
-	               const std::vector<int>& values,
-	               const std::vector<int>& nonInterventionValues);
+	QueryPlan createPlan(const std::vector<unsigned int>& queryNodes,
+	                     const std::vector<unsigned int>& conditionNodes,
+	                     const std::vector<int>& values,
+	                     const std::vector<int>& nonInterventionValues);
+
+	/**getPlan
+	 *
+	 * @param queryNodes, vector containing the identifiers of the query nodes
+	 * @param conditionNodes, vector containing the identifiers of the evidence nodes
+	 * @param values, vector containing the known values
+	 * @param nonInterventionValues, vector of values for non evidence nodes (empty for joint probabilities)
+	 *
+	 * @return the plan for the query, taken from the plan cache of the network if
+	 * a query with the same structure has been computed before
+	 */
+	std::shared_ptr<const QueryPlan>
+	getPlan(const std::vector<unsigned int>& queryNodes,
+	        const std::vector<unsigned int>& conditionNodes,
+	        const std::vector<int>& values,
+	        const std::vector<int>& nonInterventionValues);
+
+	/**executeStep
+	 *
+	 * @param step, the elimination step to perform
+	 * @param factorlist, vector of factors, containing an entry for every factor of the plan
+	 *
+	 * Performs the elimination step using the product and sumOut methods in the class Factor
+	 */
+	void executeStep(const EliminationStep& step,
+	                 std::vector<Factor>& factorlist) const;
+
+	/**executeStepsInParallel
+	 *
+	 * @param plan, the plan of the query
+	 * @param factorlist, vector of factors, containing an entry for every factor of the plan
+	 *
+	 * Performs all elimination steps on the global thread pool. A step is started
+	 * as soon as all steps writing its factors are finished.
+	 */
+	void executeStepsInParallel(const QueryPlan& plan,
+	                            std::vector<Factor>& factorlist) const;
+
+	/**executePlan
+	 *
+	 * @param plan, the plan of the query
+	 * @param values, vector containing the known values
+	 *
+	 * @return the factors left after performing all elimination steps of the plan
+	 */
+	std::vector<Factor> executePlan(const QueryPlan& plan,
+	                                const std::vector<int>& values) const;
 
 	//A reference to the network
-	Network& network_;
+	const Network& network_;
+
+	//The heuristic used to compute elimination orderings
+	EliminationHeuristic heuristic_;
+
+	//Parallel elimination settings
+	bool parallel_;
+	double parallelMinimalCost_;
 };
 
 #endif
@@ -0,0 +1,50 @@
+#include "QueryArena.h"
+
+#include <algorithm>
+
+thread_local QueryArena* QueryArena::current_ = nullptr;
+
+QueryArena::QueryArena(size_t blockSize)
+    : blockSize_(blockSize), used_(0), allocated_(0)
+{
+}
+
+void* QueryArena::allocate(size_t bytes, size_t alignment)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	size_t offset = (used_ + alignment - 1) & ~(alignment - 1);
+	if(blocks_.empty() || offset + bytes > blocks_.back().size) {
+		// Large requests get a block of their own
+		size_t size = std::max(blockSize_, bytes + alignment);
+		Block block;
+		block.memory.reset(new char[size]);
+		block.size = size;
+		blocks_.push_back(std::move(block));
+		size_t address = reinterpret_cast<size_t>(blocks_.back().memory.get());
+		offset = ((address + alignment - 1) & ~(alignment - 1)) - address;
+	}
+	used_ = offset + bytes;
+	allocated_ += bytes;
+	return blocks_.back().memory.get() + offset;
+}
+
+size_t QueryArena::getAllocatedBytes() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return allocated_;
+}
+
+size_t QueryArena::getNumberOfBlocks() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return blocks_.size();
+}
+
+QueryArena* QueryArena::getCurrent() { return current_; }
+
+QueryArena::Scope::Scope(QueryArena* arena) : previous_(current_)
+{
+	current_ = arena;
+}
+
+QueryArena::Scope::~Scope() { current_ = previous_; }
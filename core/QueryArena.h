@@ -0,0 +1,150 @@
+#ifndef QUERYARENA_H
+#define QUERYARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+/*
+ * A bump allocator for the factors and temporaries of a single query. Memory
+ * is taken from large blocks and is never freed individually, all blocks are
+ * released at once when the arena is destroyed. An arena can be made the
+ * current arena of a thread using a QueryArena::Scope, containers using the
+ * ArenaAllocator then allocate from it. Allocations are thread-safe, hence
+ * tasks of other threads may allocate from the arena as well.
+ */
+class QueryArena{
+	public:
+	/**QueryArena
+	 *
+	 * @param blockSize, the size of the memory blocks in bytes
+	 *
+	 * @return a QueryArena object, the first block is allocated on demand
+	 */
+	explicit QueryArena(size_t blockSize = 1 << 20);
+
+	QueryArena(const QueryArena&) = delete;
+	QueryArena& operator=(const QueryArena&) = delete;
+
+	/**allocate
+	 *
+	 * @param bytes, the number of bytes
+	 * @param alignment, the alignment of the memory, a power of two
+	 *
+	 * @return a pointer to uninitialised memory that stays valid until the
+	 * arena is destroyed
+	 */
+	void* allocate(size_t bytes, size_t alignment);
+
+	/**getAllocatedBytes
+	 *
+	 * @return the number of bytes handed out by the arena
+	 */
+	size_t getAllocatedBytes() const;
+
+	/**getNumberOfBlocks
+	 *
+	 * @return the number of memory blocks requested from the heap
+	 */
+	size_t getNumberOfBlocks() const;
+
+	/**getCurrent
+	 *
+	 * @return the current arena of the calling thread, nullptr if there is none
+	 */
+	static QueryArena* getCurrent();
+
+	/*
+	 * Makes an arena the current arena of the calling thread for the lifetime
+	 * of the Scope object and restores the previous arena afterwards.
+	 */
+	class Scope{
+		public:
+		explicit Scope(QueryArena* arena);
+		~Scope();
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+		private:
+		QueryArena* previous_;
+	};
+
+	private:
+	struct Block {
+		std::unique_ptr<char[]> memory;
+		size_t size;
+	};
+
+	mutable std::mutex mutex_;
+	std::vector<Block> blocks_;
+	size_t blockSize_;
+	// Position of the next free byte in the last block
+	size_t used_;
+	size_t allocated_;
+
+	static thread_local QueryArena* current_;
+};
+
+/*
+ * Allocator for standard containers. A default constructed allocator uses
+ * the current arena of the constructing thread, or the heap if there is none.
+ * Deallocating arena memory is a no-op. Copies of a container use the current
+ * arena of the copying thread, moves keep the allocator of the source.
+ */
+template <typename T> class ArenaAllocator{
+	public:
+	using value_type = T;
+	using propagate_on_container_copy_assignment = std::true_type;
+	using propagate_on_container_move_assignment = std::true_type;
+	using propagate_on_container_swap = std::true_type;
+
+	ArenaAllocator() : arena_(QueryArena::getCurrent()) {}
+
+	template <typename U>
+	ArenaAllocator(const ArenaAllocator<U>& o) : arena_(o.getArena()) {}
+
+	T* allocate(size_t n)
+	{
+		if(arena_ == nullptr) {
+			return static_cast<T*>(::operator new(n * sizeof(T)));
+		}
+		return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+	}
+
+	void deallocate(T* p, size_t)
+	{
+		if(arena_ == nullptr) {
+			::operator delete(p);
+		}
+	}
+
+	ArenaAllocator select_on_container_copy_construction() const
+	{
+		return ArenaAllocator();
+	}
+
+	QueryArena* getArena() const { return arena_; }
+
+	private:
+	QueryArena* arena_;
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+	return a.getArena() == b.getArena();
+}
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+	return !(a == b);
+}
+
+template <typename T> using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+#endif
@@ -1,9 +1,19 @@
 #include "QueryExecuter.h"
 
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+
 QueryExecuter::QueryExecuter(NetworkController& c)
     : networkController_(c),
       probHandler_(c.getNetwork()),
-      interventions_(c)
+      samplingHandler_(c.getNetwork()),
+      gibbsSampler_(c.getNetwork()),
+      method_(InferenceMethod::Exact),
+      standardError_(0.0f),
+      useResultCache_(true)
 {
 	size_t size = c.getNetwork().size();
 	nonInterventionValues_.resize(size, -1);
@@ -36,25 +46,20 @@ bool QueryExecuter::isCounterfactual()
 	return false;
 }
 
-void QueryExecuter::adaptNodeIdentifiers()
+void QueryExecuter::adaptNodeIdentifiers(const Network& twin)
 {
-	size_t size = networkController_.getNetwork().size();
+	size_t size = twin.size();
 	nonInterventionValues_.resize(size, -1);
 	conditionValues_.resize(size, -1);
 	doInterventionValues_.resize(size, -1);
 	for(unsigned int i = 0; i < nonInterventionNodeID_.size(); i++) {
 		auto id = nonInterventionNodeID_[i];
-		if(!networkController_.getNetwork()
-		           .getNode(id)
-		           .getParents()
-		           .empty()) {
-			nonInterventionNodeID_[i] =
-			    networkController_.getNetwork().getHypoID(id);
-			nonInterventionValues_[networkController_.getNetwork().getHypoID(
-			    id)] = nonInterventionValues_[id];
+		if(!twin.getNode(id).getParents().empty()) {
+			nonInterventionNodeID_[i] = twin.getHypoID(id);
+			nonInterventionValues_[twin.getHypoID(id)] =
+			    nonInterventionValues_[id];
 			nonInterventionValues_[id] = -1;
 		} else if(conditionValues_[id] != -1) {
-			networkController_.getNetwork().removeHypoNodes();
 			throw std::invalid_argument("It is not possible to infer and "
 			                            "condition on exogenous variables "
 			                            "simultaneously!");
@@ -62,18 +67,12 @@ void QueryExecuter::adaptNodeIdentifiers()
 	}
 	for(unsigned int j = 0; j < doInterventionNodeID_.size(); j++) {
 		auto id = doInterventionNodeID_[j];
-		if(!networkController_.getNetwork()
-		           .getNode(id)
-		           .getParents()
-		           .empty()) {
-			doInterventionNodeID_[j] =
-			    networkController_.getNetwork().getHypoID(id);
-			doInterventionValues_[networkController_.getNetwork().getHypoID(
-			    id)] = doInterventionValues_[id];
+		if(!twin.getNode(id).getParents().empty()) {
+			doInterventionNodeID_[j] = twin.getHypoID(id);
+			doInterventionValues_[twin.getHypoID(id)] = doInterventionValues_[id];
 			doInterventionValues_[id] = -1;
 		}
 		else if(conditionValues_[id] != -1){
-			networkController_.getNetwork().removeHypoNodes();
 			throw std::invalid_argument("It is not possible to set and "
 										"condition on exogenous variables "
 										"simultaneously!");	
@@ -81,156 +80,349 @@ void QueryExecuter::adaptNodeIdentifiers()
 	}
 }
 
-std::pair<float, std::vector<std::string>> QueryExecuter::execute()
+void QueryExecuter::checkQuery() const
 {
 	if (nonInterventionNodeID_.empty() && argmaxNodeIDs_.empty()) {
 		throw std::invalid_argument("A query can not be composed of interventions and conditions only!");
 	}
-	std::pair<float, std::vector<std::string>> probability;
-	bool cf = false;
-	if(isCounterfactual()) {
-		if(!addEdgeNodeIDs_.empty() || !removeEdgeNodeIDs_.empty()) {
-			throw std::invalid_argument("Edge additions and removals are not "
-			                            "defined for counterfactuals");
-		}
-		networkController_.getNetwork().createTwinNetwork();
-		cf = true;
-		adaptNodeIdentifiers();
-	}
-	if(hasInterventions()) {
-		executeInterventions();
-	}
-	probability = computeProbability();
-	if(hasInterventions()) {
-		reverseInterventions();
-	}
-	if(cf) {
-		networkController_.getNetwork().removeHypoNodes();
-	}
-	return probability;
 }
 
-std::pair<float, std::vector<std::string>> QueryExecuter::computeProbability()
+/**sortedAssignment
+ *
+ * @param ids, node identifiers
+ * @param values, values indexed by node identifier
+ *
+ * @return the pairs of node identifier and value sorted by identifier
+ */
+static std::vector<std::pair<unsigned int, int>>
+sortedAssignment(const std::vector<unsigned int>& ids,
+                 const std::vector<int>& values)
 {
-	std::vector<std::string> temp;
-	if(!argmaxNodeIDs_.empty()) {
-		return executeArgMax();
-	} else if(!conditionNodeID_.empty()) {
-		return std::make_pair(executeCondition(), temp);
-	} else {
-		return std::make_pair(executeProbability(), temp);
+	std::vector<std::pair<unsigned int, int>> assignment;
+	for(auto& id : ids) {
+		assignment.push_back(std::make_pair(id, values[id]));
 	}
+	std::sort(assignment.begin(), assignment.end());
+	return assignment;
 }
 
-void QueryExecuter::executeInterventions()
+/**sortedEdges
+ *
+ * @param edges, pairs of node identifiers
+ *
+ * @return the given pairs in sorted order
+ */
+static std::vector<std::pair<unsigned int, unsigned int>>
+sortedEdges(std::vector<std::pair<unsigned int, unsigned int>> edges)
 {
-	networkController_.getNetwork().clearDynProgMatrices();
-	interventions_.createBackupOfNetworkStructure();
-	bool topologyChange = false;
-	if(!removeEdgeNodeIDs_.empty()) {
-		executeEdgeDeletions();
-		topologyChange = true;
-	}
-	if(!addEdgeNodeIDs_.empty()) {
-		executeEdgeAdditions();
-		topologyChange = true;
-	}
-	if(topologyChange) {
-		networkController_.trainNetwork();
-	}
-	if(!doInterventionValues_.empty()) {
-		executeDoInterventions();
-	}
+	std::sort(edges.begin(), edges.end());
+	return edges;
 }
 
-void QueryExecuter::reverseInterventions()
+bool QueryExecuter::hasSameSetting(const QueryExecuter& o) const
 {
-	networkController_.getNetwork().clearDynProgMatrices();
-	interventions_.loadBackupOfNetworkStructure();
-	if(!doInterventionValues_.empty()) {
-		executeReverseDoInterventions();
-	}
-	bool topologyChange = false;
-	if(!addEdgeNodeIDs_.empty()) {
-		executeEdgeAdditionsReverse();
-		topologyChange = true;
-	}
-	if(!removeEdgeNodeIDs_.empty()) {
-		executeEdgeDeletionsReverse();
-		topologyChange = true;
-	}
-	if(topologyChange) {
-		networkController_.trainNetwork();
-	}
+	return &networkController_ == &o.networkController_ &&
+	       sortedAssignment(conditionNodeID_, conditionValues_) ==
+	           sortedAssignment(o.conditionNodeID_, o.conditionValues_) &&
+	       sortedAssignment(doInterventionNodeID_, doInterventionValues_) ==
+	           sortedAssignment(o.doInterventionNodeID_,
+	                            o.doInterventionValues_) &&
+	       sortedEdges(addEdgeNodeIDs_) == sortedEdges(o.addEdgeNodeIDs_) &&
+	       sortedEdges(removeEdgeNodeIDs_) == sortedEdges(o.removeEdgeNodeIDs_);
 }
 
-void QueryExecuter::executeDoInterventions()
+QueryResultKey QueryExecuter::getResultKey() const
 {
-	for(auto& id : doInterventionNodeID_) {
-		interventions_.doIntervention(id, doInterventionValues_[id]);
-	}
+	QueryResultKey key;
+	key.nonInterventions =
+	    sortedAssignment(nonInterventionNodeID_, nonInterventionValues_);
+	key.conditions = sortedAssignment(conditionNodeID_, conditionValues_);
+	key.doInterventions =
+	    sortedAssignment(doInterventionNodeID_, doInterventionValues_);
+	key.addedEdges = sortedEdges(addEdgeNodeIDs_);
+	key.removedEdges = sortedEdges(removeEdgeNodeIDs_);
+	key.argmaxNodes = argmaxNodeIDs_;
+	std::sort(key.argmaxNodes.begin(), key.argmaxNodes.end());
+	return key;
 }
 
-void QueryExecuter::executeReverseDoInterventions()
+bool QueryExecuter::isCacheable() const
 {
-	for(auto& id : doInterventionNodeID_) {
-		interventions_.reverseDoIntervention(id);
+	// Sampling results depend on the settings of the samplers
+	return useResultCache_ &&
+	       (method_ == InferenceMethod::Exact || !argmaxNodeIDs_.empty());
+}
+
+std::pair<float, std::vector<std::string>> QueryExecuter::execute()
+{
+	checkQuery();
+	Network& network = networkController_.getNetwork();
+	unsigned long version = network.getModelVersion();
+	QueryResultKey key;
+	if(isCacheable()) {
+		key = getResultKey();
+		auto cached = network.getQueryResultCache().find(key, version);
+		if(cached != nullptr) {
+			standardError_ = 0.0f;
+			return *cached;
+		}
+	}
+	// All factors of the query are released at once with the arena
+	QueryArena arena;
+	QueryArena::Scope scope(&arena);
+	std::pair<float, std::vector<std::string>> probability;
+	if(hasInterventions() || isCounterfactual()) {
+		probability = executeOnOverlay();
+	} else {
+		probability = computeProbability(network);
+	}
+	if(isCacheable()) {
+		network.getQueryResultCache().insert(key, version, probability);
 	}
+	return probability;
 }
 
-void QueryExecuter::executeEdgeAdditions()
+std::pair<float, std::vector<std::string>> QueryExecuter::executeOnOverlay()
 {
-	for(auto& p : addEdgeNodeIDs_) {
-		interventions_.addEdge(p.first, p.second);
-		if(networkController_.getNetwork().checkCycleExistence(p.first)) {
-			interventions_.removeEdge(p.first, p.second);
-			throw std::invalid_argument("This edge induces a cycle");
+	if(isCounterfactual()) {
+		if(!addEdgeNodeIDs_.empty() || !removeEdgeNodeIDs_.empty()) {
+			throw std::invalid_argument("Edge additions and removals are not "
+			                            "defined for counterfactuals");
+		}
+		auto network = getTwinNetwork();
+		// The identifiers of the query are mapped to the twin network on a
+		// copy, hence the query can be executed again
+		QueryExecuter twin(*this);
+		twin.adaptNodeIdentifiers(*network);
+		auto probability = twin.computeProbability(*network);
+		standardError_ = twin.standardError_;
+		return probability;
+	}
+	// The copy shares the CPTs and the structure with the network of the
+	// controller, only the nodes and edges changed by the query are replaced
+	Network overlay(networkController_.getNetwork());
+	applyInterventions(overlay);
+	return computeProbability(overlay);
+}
+
+std::shared_ptr<const Network> QueryExecuter::getTwinNetwork() const
+{
+	Network& network = networkController_.getNetwork();
+	const unsigned long version = network.getModelVersion();
+	TwinNetworkKey key;
+	key.nodes = nonInterventionNodeID_;
+	std::sort(key.nodes.begin(), key.nodes.end());
+	for(auto& id : doInterventionNodeID_) {
+		key.interventions.push_back(std::make_pair(id, doInterventionValues_[id]));
+	}
+	std::sort(key.interventions.begin(), key.interventions.end());
+	auto cached = network.getTwinNetworkCache().find(key, version);
+	if(cached != nullptr) {
+		return cached;
+	}
+	auto twin = std::make_shared<Network>(network);
+	twin->createTwinNetwork(nonInterventionNodeID_, doInterventionNodeID_);
+	QueryExecuter adapted(*this);
+	adapted.adaptNodeIdentifiers(*twin);
+	adapted.applyInterventions(*twin);
+	network.getTwinNetworkCache().insert(key, version, twin);
+	return twin;
+}
+
+std::vector<std::pair<float, std::vector<std::string>>>
+QueryExecuter::executeBatch(std::vector<QueryExecuter>& queries)
+{
+	for(const auto& qe : queries) {
+		qe.checkQuery();
+	}
+	std::vector<std::pair<float, std::vector<std::string>>> results(
+	    queries.size());
+	std::vector<bool> done(queries.size(), false);
+	if(queries.empty()) {
+		return results;
+	}
+	Network& network = queries[0].networkController_.getNetwork();
+	const unsigned long version = network.getModelVersion();
+	QueryResultCache& cache = network.getQueryResultCache();
+	std::vector<QueryResultKey> keys(queries.size());
+	for(unsigned int i = 0; i < queries.size(); i++) {
+		if(queries[i].isCacheable()) {
+			keys[i] = queries[i].getResultKey();
+			auto cached = cache.find(keys[i], version);
+			if(cached != nullptr) {
+				results[i] = *cached;
+				queries[i].standardError_ = 0.0f;
+				done[i] = true;
+			}
+		}
+	}
+	std::vector<bool> cached = done;
+	for(unsigned int i = 0; i < queries.size(); i++) {
+		if(done[i]) {
+			continue;
+		}
+		QueryExecuter& first = queries[i];
+		done[i] = true;
+		if(first.isCounterfactual()) {
+			results[i] = first.execute();
+			continue;
+		}
+		std::vector<unsigned int> group{i};
+		for(unsigned int j = i + 1; j < queries.size(); j++) {
+			if(!done[j] && !queries[j].isCounterfactual() &&
+			   first.hasSameSetting(queries[j])) {
+				group.push_back(j);
+				done[j] = true;
+			}
+		}
+		QueryArena arena;
+		QueryArena::Scope scope(&arena);
+		// The interventions of the group are applied to one shared copy
+		std::unique_ptr<Network> overlay;
+		if(first.hasInterventions()) {
+			overlay.reset(new Network(network));
+			first.applyInterventions(*overlay);
+		}
+		Network& target = overlay ? *overlay : network;
+		// MAP queries and single queries are computed as usual
+		std::vector<unsigned int> shared;
+		std::vector<std::vector<unsigned int>> queryNodes;
+		std::vector<std::vector<int>> queryValues;
+		for(auto& index : group) {
+			QueryExecuter& qe = queries[index];
+			if(group.size() == 1 || !qe.argmaxNodeIDs_.empty() ||
+			   qe.method_ != InferenceMethod::Exact) {
+				results[index] = qe.computeProbability(target);
+			} else {
+				shared.push_back(index);
+				queryNodes.push_back(qe.nonInterventionNodeID_);
+				queryValues.push_back(qe.nonInterventionValues_);
+			}
+		}
+		if(!shared.empty()) {
+			ProbabilityHandler probHandler(first.probHandler_, target);
+			auto probabilities = probHandler.computeProbabilities(
+			    queryNodes, queryValues, first.conditionNodeID_,
+			    first.conditionValues_);
+			for(unsigned int k = 0; k < shared.size(); k++) {
+				results[shared[k]] =
+				    std::make_pair(probabilities[k], std::vector<std::string>());
+			}
 		}
 	}
+	for(unsigned int i = 0; i < queries.size(); i++) {
+		if(!cached[i] && queries[i].isCacheable()) {
+			cache.insert(keys[i], version, results[i]);
+		}
+	}
+	return results;
 }
 
-void QueryExecuter::executeEdgeDeletions()
+std::vector<std::pair<float, std::vector<std::string>>>
+QueryExecuter::executeConcurrently(std::vector<QueryExecuter>& queries,
+                                   ThreadPool& pool)
 {
-	for(auto& p : removeEdgeNodeIDs_) {
-		interventions_.removeEdge(p.first, p.second);
+	for(const auto& qe : queries) {
+		qe.checkQuery();
+	}
+	std::vector<std::pair<float, std::vector<std::string>>> results(
+	    queries.size());
+	std::atomic<unsigned int> unfinished(queries.size());
+	std::exception_ptr error;
+	std::mutex errorMutex;
+	for(unsigned int i = 0; i < queries.size(); i++) {
+		pool.submit([&, i] {
+			try {
+				results[i] = queries[i].execute();
+			} catch(...) {
+				std::lock_guard<std::mutex> lock(errorMutex);
+				if(!error) {
+					error = std::current_exception();
+				}
+			}
+			unfinished--;
+		});
+	}
+	pool.waitUntil([&unfinished] { return unfinished == 0; });
+	if(error) {
+		std::rethrow_exception(error);
 	}
+	return results;
 }
 
-void QueryExecuter::executeEdgeAdditionsReverse()
+std::pair<float, std::vector<std::string>>
+QueryExecuter::computeProbability(const Network& network)
 {
-	for(auto& p : addEdgeNodeIDs_) {
-		interventions_.removeEdge(p.first, p.second);
+	std::vector<std::string> temp;
+	standardError_ = 0.0f;
+	ProbabilityHandler probHandler(probHandler_, network);
+	if(!argmaxNodeIDs_.empty()) {
+		return executeArgMax(probHandler);
+	} else if(method_ != InferenceMethod::Exact) {
+		SamplingEstimate estimate =
+		    method_ == InferenceMethod::Gibbs
+		        ? GibbsSampler(gibbsSampler_, network).computeProbability(
+		              nonInterventionNodeID_, conditionNodeID_,
+		              nonInterventionValues_, conditionValues_)
+		        : SamplingHandler(samplingHandler_, network).computeProbability(
+		              nonInterventionNodeID_, conditionNodeID_,
+		              nonInterventionValues_, conditionValues_);
+		standardError_ = estimate.standardError;
+		return std::make_pair(estimate.probability, temp);
+	} else if(!conditionNodeID_.empty()) {
+		return std::make_pair(executeCondition(probHandler), temp);
+	} else {
+		return std::make_pair(executeProbability(probHandler), temp);
 	}
 }
 
-void QueryExecuter::executeEdgeDeletionsReverse()
+void QueryExecuter::applyInterventions(Network& overlay) const
 {
+	// Only the targets of the edges get new parents
+	std::vector<unsigned int> changed;
 	for(auto& p : removeEdgeNodeIDs_) {
-		interventions_.addEdge(p.first, p.second);
+		overlay.removeEdge(p.second, p.first);
+		changed.push_back(p.second);
+	}
+	for(auto& p : addEdgeNodeIDs_) {
+		overlay.addEdge(p.second, p.first);
+		if(overlay.checkCycleExistence(p.first)) {
+			throw std::invalid_argument("This edge induces a cycle");
+		}
+		changed.push_back(p.second);
+	}
+	if(!changed.empty()) {
+		std::sort(changed.begin(), changed.end());
+		changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+		networkController_.trainNetwork(overlay, changed);
+	}
+	for(auto& id : doInterventionNodeID_) {
+		overlay.setIntervention(id, doInterventionValues_[id]);
 	}
 }
 
-std::pair<float, std::vector<std::string>> QueryExecuter::executeArgMax()
+std::pair<float, std::vector<std::string>>
+QueryExecuter::executeArgMax(ProbabilityHandler& probHandler)
 {
-	return probHandler_.maxSearch(argmaxNodeIDs_, conditionNodeID_,
+	return probHandler.maxSearch(argmaxNodeIDs_, conditionNodeID_,
 	                              conditionValues_);
 }
 
-float QueryExecuter::executeCondition()
+float QueryExecuter::executeCondition(ProbabilityHandler& probHandler)
 {
-	return probHandler_.computeConditionalProbability(
+	return probHandler.computeConditionalProbability(
 	    nonInterventionNodeID_, conditionNodeID_, nonInterventionValues_,
 	    conditionValues_);
 }
 
-float QueryExecuter::executeProbability()
+float QueryExecuter::executeProbability(ProbabilityHandler& probHandler)
 {
 	if(nonInterventionNodeID_.size() == 1) {
-		return probHandler_.computeTotalProbabilityNormalized(
+		return probHandler.computeTotalProbabilityNormalized(
 		    nonInterventionNodeID_[0],
 		    nonInterventionValues_[(nonInterventionNodeID_[0])]);
 	} else {
-		return probHandler_.computeJointProbabilityUsingVariableElimination(
+		return probHandler.computeJointProbabilityUsingVariableElimination(
 		    nonInterventionNodeID_, nonInterventionValues_);
 	}
 }
@@ -279,6 +471,30 @@ void QueryExecuter::setArgMax(const unsigned int nodeID)
 	argmaxNodeIDs_.push_back(nodeID);
 }
 
+void QueryExecuter::setEliminationHeuristic(EliminationHeuristic heuristic)
+{
+	probHandler_.setEliminationHeuristic(heuristic);
+}
+
+void QueryExecuter::setInferenceMethod(InferenceMethod method)
+{
+	method_ = method;
+}
+
+void QueryExecuter::setResultCaching(bool enabled)
+{
+	useResultCache_ = enabled;
+}
+
+SamplingHandler& QueryExecuter::getSamplingHandler()
+{
+	return samplingHandler_;
+}
+
+GibbsSampler& QueryExecuter::getGibbsSampler() { return gibbsSampler_; }
+
+float QueryExecuter::getStandardError() const { return standardError_; }
+
 const std::vector< unsigned int >& QueryExecuter::getNonInterventionIds() const
 {
 	return nonInterventionNodeID_;
@@ -1,8 +1,17 @@
 #ifndef QUERYEXECUTER
 #define QUERYEXECUTER
 #include "ProbabilityHandler.h"
-#include "Interventions.h"
+#include "SamplingHandler.h"
+#include "GibbsSampler.h"
 #include "NetworkController.h"
+#include "ThreadPool.h"
+
+/*
+ * Exact computes all probabilities with variable elimination,
+ * LikelihoodWeighting and Gibbs approximate them by sampling. MAP queries are
+ * always computed exactly.
+ */
+enum class InferenceMethod { Exact, LikelihoodWeighting, Gibbs };
 
 class QueryExecuter{
 
@@ -15,7 +24,11 @@ class QueryExecuter{
 	QueryExecuter(const QueryExecuter& o)
 		: networkController_(o.networkController_),
 		  probHandler_(o.probHandler_),
-		  interventions_(o.interventions_),
+		  samplingHandler_(o.samplingHandler_),
+		  gibbsSampler_(o.gibbsSampler_),
+		  method_(o.method_),
+		  standardError_(o.standardError_),
+		  useResultCache_(o.useResultCache_),
 		  nonInterventionNodeID_(o.nonInterventionNodeID_),
 		  nonInterventionValues_(o.nonInterventionValues_),
 		  conditionNodeID_(o.conditionNodeID_),
@@ -37,9 +50,46 @@ class QueryExecuter{
 	 * (1) probability 
 	 * (2) value assignments (only for MAP queries)
 	 *
+	 * The factors of the query are allocated from an arena that is released
+	 * when the query is finished. Results of exact queries are stored in the
+	 * result cache of the network and reused until the model changes.
 	 */
 	std::pair<float,std::vector<std::string>> execute();
 
+	/**executeBatch
+	 *
+	 * @param queries, the queries to execute, all of them referring to the same NetworkController
+	 *
+	 * @return for every query a pair of
+	 * (1) probability
+	 * (2) value assignments (only for MAP queries)
+	 *
+	 * Queries sharing the same interventions and conditions are grouped. For every
+	 * group, the interventions are applied to a single copy of the network and the
+	 * probabilities are computed from a single junction tree calibrated with the
+	 * conditions. Counterfactual queries are executed separately.
+	 */
+	static std::vector<std::pair<float, std::vector<std::string>>>
+	executeBatch(std::vector<QueryExecuter>& queries);
+
+	/**executeConcurrently
+	 *
+	 * @param queries, the queries to execute, all of them referring to the same NetworkController
+	 * @param pool, the thread pool executing the queries
+	 *
+	 * @return for every query a pair of
+	 * (1) probability
+	 * (2) value assignments (only for MAP queries)
+	 *
+	 * Every query is executed by its own task. The queries only read the model,
+	 * interventions are applied to copies of the network, hence the network must
+	 * not be modified until all queries are finished. The first exception thrown
+	 * by a query is rethrown after all queries are finished.
+	 */
+	static std::vector<std::pair<float, std::vector<std::string>>>
+	executeConcurrently(std::vector<QueryExecuter>& queries,
+	                    ThreadPool& pool = ThreadPool::getGlobalPool());
+
 	/**
 	 * Stores a pair of nodeID and value reflecting a nonIntervention
 	 *
@@ -92,6 +142,44 @@ class QueryExecuter{
 	 */
 	void setArgMax(const unsigned int nodeID);
 
+	/**setEliminationHeuristic
+	 *
+	 * @param heuristic, the heuristic used to order the nodes during variable elimination
+	 */
+	void setEliminationHeuristic(EliminationHeuristic heuristic);
+
+	/**setInferenceMethod
+	 *
+	 * @param method, the method used to compute probabilities, the default is Exact
+	 */
+	void setInferenceMethod(InferenceMethod method);
+
+	/**setResultCaching
+	 *
+	 * @param enabled, false to neither read from nor write to the result cache
+	 * of the network, the default is true
+	 */
+	void setResultCaching(bool enabled);
+
+	/**getSamplingHandler
+	 *
+	 * @return a reference to the SamplingHandler, e.g. to set the sample budget
+	 */
+	SamplingHandler& getSamplingHandler();
+
+	/**getGibbsSampler
+	 *
+	 * @return a reference to the GibbsSampler, e.g. to set the number of chains
+	 */
+	GibbsSampler& getGibbsSampler();
+
+	/**getStandardError
+	 *
+	 * @return the standard error of the last computed probability, 0 if it was
+	 * computed exactly
+	 */
+	float getStandardError() const;
+
 	const std::vector<unsigned int>& getNonInterventionIds() const;
 	const std::vector<int>& getNonInterventionValues() const;
 
@@ -117,6 +205,33 @@ class QueryExecuter{
 
 	private:
 
+	/**checkQuery
+	 *
+	 * Throws an invalid_argument exception if the query does not contain any query nodes
+	 */
+	void checkQuery() const;
+
+	/**hasSameSetting
+	 *
+	 * @param o, const reference to another QueryExecuter
+	 *
+	 * @return true if both queries refer to the same network and contain the same
+	 * interventions and conditions, false otherwise
+	 */
+	bool hasSameSetting(const QueryExecuter& o) const;
+
+	/**getResultKey
+	 *
+	 * @return the canonical form of the query used by the result cache
+	 */
+	QueryResultKey getResultKey() const;
+
+	/**isCacheable
+	 *
+	 * @return true if the result of the query can be stored in the result cache
+	 */
+	bool isCacheable() const;
+
 	/**isCOunterfactual
 	 *
 	 * @return true if the given query represents a counterfactual, false otherwise
@@ -125,10 +240,12 @@ class QueryExecuter{
 
 
 	/**adaptNodeIdentifiers
+	 *
+	 * @param twin, the twin network the query is executed on
 	 *
 	 *Adapts the node identifiers to the hypothetical Nodes of the Twin Network
 	 */
-	void adaptNodeIdentifiers();
+	void adaptNodeIdentifiers(const Network& twin);
 
 	/**hasInterventions
 	 * 
@@ -137,69 +254,48 @@ class QueryExecuter{
 	 */
 	bool hasInterventions();
 
-	/**executeInterventions
-	 * 
-	 * Depending on the typ of intervention, the suitable
-	 * specialised methods are called to execute them 
+	/**executeOnOverlay
+	 *
+	 * @return a pair of the resulting probability and optinal value assignments (for MAP queries)
+	 *
+	 * Executes the query on a copy of the network that shares the CPTs and the
+	 * structure with the network of the controller. The interventions only
+	 * replace the affected nodes of the copy, the model itself is never modified.
 	 */
-	void executeInterventions();
+	std::pair<float,std::vector<std::string>> executeOnOverlay();
 
-	/**reverseInterventions
-	 * 
-	 * Depending on the typ of intervention, the suitable
-	 * specialised methods are called to reverse them
+	/**getTwinNetwork
+	 *
+	 * @return the twin network of the counterfactual query with all
+	 * Do-Interventions applied
+	 *
+	 * The twin network is pruned to the hypothetical nodes required by the
+	 * query and stored in the twin network cache of the network, hence it is
+	 * reused by all counterfactual queries of the same structure until the
+	 * model changes.
 	 */
-	void reverseInterventions();
+	std::shared_ptr<const Network> getTwinNetwork() const;
+
+	/**applyInterventions
+	 *
+	 * @param overlay, the copy of the network the interventions are applied to
+	 *
+	 * Removes and adds the specified edges, retrains the targets of the changed edges
+	 * and sets the do-intervention nodes to their values.
+	 */
+	void applyInterventions(Network& overlay) const;
 
 	/**computeProbability
 	 * 
+	 * @param network, the network the query is computed on
+	 *
 	 * @return a pair of the resulting probability and optinal value assignments (for MAP queries)
 	 *
 	 * Depending on the typ of probability that is to comput, this method calls
 	 * the suitable specialised methods. The second member of the pair is a empty string vector,
 	 * except for MAP queries.
 	 */
-	std::pair<float,std::vector<std::string>> computeProbability();
-
-	/**executeDoInterventions
-	 * 
-	 * Calls the appropriate methods in the Intervention object
-	 * to perform all Do-Interventions
-	 */
-	void executeDoInterventions();
-
-	/**executeReverseDoInterventions
-	 * 
-	 * Calls the appropriate methods in the Intervention object
-	 * to reverse all do interventions
-	 */
-	void executeReverseDoInterventions();
-
-	/**executeEdgeAdditions
-	 * 
-	 * Calls the appropriate methods in the Intervention object
-	 * to add all specified edges
-	 */
-	void executeEdgeAdditions();
-
-	/**executeEdgeDeletions
-	 * 
-	 * Calls the appropriate methods in the Intervention object 
-	 * to remove all specified edges
-	 */
-	void executeEdgeDeletions();
-
-	/**executeEdgeAddditionsReverse
-	 * 
-	 * Reverses all edge additions
-	 */
-	void executeEdgeAdditionsReverse();
-
-	/**executeEdgeDeletionsReverse
-	 * 
-	 * Reverses all edge deletions
-	 */
-	void executeEdgeDeletionsReverse();	
+	std::pair<float,std::vector<std::string>> computeProbability(const Network& network);
 
 	/**executeArgMax
 	 * 
@@ -207,7 +303,7 @@ class QueryExecuter{
 	 *
 	 * Uses the ProbabilityHandler to compute a MAP query
 	 */
-	std::pair<float,std::vector<std::string>> executeArgMax();
+	std::pair<float,std::vector<std::string>> executeArgMax(ProbabilityHandler& probHandler);
 
 	/**executeCondition
 	 * 
@@ -215,7 +311,7 @@ class QueryExecuter{
 	 *
 	 * Uses the ProbabilityHandler to compute a conditional probability
 	 */
-	float executeCondition();
+	float executeCondition(ProbabilityHandler& probHandler);
 
 	/**executeProbability
 	 *
@@ -223,14 +319,19 @@ class QueryExecuter{
 	 *
 	 * Uses the ProbabilityHandler to compute a total-/ or joint probability
 	 */
-	float executeProbability();
+	float executeProbability(ProbabilityHandler& probHandler);
 
 	//Reference to the network controller
 	NetworkController& networkController_;	
 	//Instance of a ProbabilityHandler class to calculate the requested probabilities
 	ProbabilityHandler probHandler_;
-	//Instance of a Interventions class to perform the interventions
-	Interventions interventions_;
+	//Instance of a SamplingHandler class to approximate the requested probabilities
+	SamplingHandler samplingHandler_;
+	//Instance of a GibbsSampler class to approximate the requested probabilities
+	GibbsSampler gibbsSampler_;
+	InferenceMethod method_;
+	float standardError_;
+	bool useResultCache_;
 	//vectors to store node identifiers and values in the category related to their occurence in the user query
 	std::vector<unsigned int> nonInterventionNodeID_;
 	std::vector<int> nonInterventionValues_;
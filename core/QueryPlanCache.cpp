@@ -0,0 +1,47 @@
+#include "QueryPlanCache.h"
+#include "EliminationOrdering.h"
+
+#include <tuple>
+
+bool QueryPlanKey::operator<(const QueryPlanKey& o) const
+{
+	return std::tie(queryNodes, conditionNodes, nodeStates, heuristic) <
+	       std::tie(o.queryNodes, o.conditionNodes, o.nodeStates, o.heuristic);
+}
+
+QueryPlanCache::QueryPlanCache(size_t capacity) : capacity_(capacity) {}
+
+std::shared_ptr<const QueryPlan>
+QueryPlanCache::find(const QueryPlanKey& key) const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	auto it = plans_.find(key);
+	if(it == plans_.end()) {
+		return nullptr;
+	}
+	return it->second;
+}
+
+std::shared_ptr<const QueryPlan>
+QueryPlanCache::insert(const QueryPlanKey& key, const QueryPlan& plan)
+{
+	auto stored = std::make_shared<const QueryPlan>(plan);
+	std::lock_guard<std::mutex> lock(mutex_);
+	if(plans_.size() >= capacity_) {
+		plans_.clear();
+	}
+	plans_[key] = stored;
+	return stored;
+}
+
+void QueryPlanCache::clear()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	plans_.clear();
+}
+
+size_t QueryPlanCache::size() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return plans_.size();
+}
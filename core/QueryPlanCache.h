@@ -0,0 +1,131 @@
+#ifndef QUERYPLANCACHE_H
+#define QUERYPLANCACHE_H
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+enum class EliminationHeuristic;
+
+/*
+ * A single step of variable elimination. Factors are referenced by their
+ * position in the factor list, products are appended to the end of the list.
+ * The dependencies between the steps form the elimination tree, steps in
+ * independent subtrees can be executed in parallel.
+ */
+struct EliminationStep {
+	//Identifier of the node to eliminate
+	unsigned int id;
+	//Positions of the factors containing the node
+	std::vector<unsigned int> factors;
+	//True if the node is observed and removed from every factor separately
+	bool observed;
+	//True if the node is summed out after the factors have been multiplied
+	bool sumOut;
+	//Position of the product in the factor list, -1 for observed nodes
+	int result;
+	//Number of entries of the product, i.e. the work required for the step
+	double cost;
+	//Number of steps that have to be finished before this step can start
+	unsigned int dependencies;
+	//Steps depending on the factors written by this step
+	std::vector<unsigned int> successors;
+};
+
+/*
+ * A QueryPlan contains all parts of a variable elimination run that do not
+ * depend on the values of the query, i.e. the relevant nodes, the elimination
+ * ordering and the scopes of all factors created during the elimination.
+ */
+struct QueryPlan {
+	//Nodes whose factors are needed, in the order of the factor list
+	std::vector<unsigned int> factorisation;
+	//The elimination ordering
+	std::vector<unsigned int> ordering;
+	//The elimination steps, one per node in the ordering
+	std::vector<EliminationStep> steps;
+	//Scopes of the initial factors followed by the scopes of all products
+	std::vector<std::vector<unsigned int>> scopes;
+	//Positions of the factors left after the elimination
+	std::vector<unsigned int> results;
+	//Sum of the costs of all steps
+	double cost;
+};
+
+/*
+ * The structure of a query. Two queries with the same key only differ
+ * in the values of their nodes.
+ */
+struct QueryPlanKey {
+	//Identifiers of the query nodes in the order of the query
+	std::vector<unsigned int> queryNodes;
+	//Identifiers of the evidence nodes in the order of the query
+	std::vector<unsigned int> conditionNodes;
+	//Per node: whether it is observed, whether it is kept in the result and
+	//its current number of parents (changed by Do-Interventions)
+	std::vector<int> nodeStates;
+	//The heuristic used to compute the elimination ordering
+	EliminationHeuristic heuristic;
+
+	bool operator<(const QueryPlanKey& o) const;
+};
+
+/*
+ * Stores query plans by the structure of their query. The cache has to be
+ * cleared whenever the network topology or the parameters are changed.
+ * All methods may be called concurrently, plans that are handed out stay
+ * valid even if the cache is cleared in the meantime.
+ */
+class QueryPlanCache{
+	public:
+	/**QueryPlanCache
+	 *
+	 * @param capacity, maximal number of stored plans (default is 1024)
+	 *
+	 * @return an empty QueryPlanCache object
+	 */
+	explicit QueryPlanCache(size_t capacity = 1024);
+
+	/**find
+	 *
+	 * @param key, the structure of the query
+	 *
+	 * @return a pointer to the stored plan, nullptr if there is none
+	 */
+	std::shared_ptr<const QueryPlan> find(const QueryPlanKey& key) const;
+
+	/**insert
+	 *
+	 * @param key, the structure of the query
+	 * @param plan, the plan to store
+	 *
+	 * @return a pointer to the stored plan
+	 *
+	 * If the cache is full, all plans are removed before the new one is stored
+	 */
+	std::shared_ptr<const QueryPlan> insert(const QueryPlanKey& key,
+	                                        const QueryPlan& plan);
+
+	/**clear
+	 *
+	 * Removes all stored plans
+	 */
+	void clear();
+
+	/**size
+	 *
+	 * @return the number of stored plans
+	 */
+	size_t size() const;
+
+	private:
+	//Maximal number of stored plans
+	size_t capacity_;
+	//The stored plans
+	std::map<QueryPlanKey, std::shared_ptr<const QueryPlan>> plans_;
+	mutable std::mutex mutex_;
+};
+
+#endif
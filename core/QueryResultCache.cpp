@@ -0,0 +1,138 @@
+#include "QueryResultCache.h"
+
+#include <tuple>
+
+bool QueryResultKey::operator<(const QueryResultKey& o) const
+{
+	return std::tie(nonInterventions, conditions, doInterventions, addedEdges,
+	                removedEdges, argmaxNodes) <
+	       std::tie(o.nonInterventions, o.conditions, o.doInterventions,
+	                o.addedEdges, o.removedEdges, o.argmaxNodes);
+}
+
+size_t QueryResultKey::getMemoryUsage() const
+{
+	return sizeof(QueryResultKey) +
+	       (nonInterventions.size() + conditions.size() +
+	        doInterventions.size()) *
+	           sizeof(std::pair<unsigned int, int>) +
+	       (addedEdges.size() + removedEdges.size()) *
+	           sizeof(std::pair<unsigned int, unsigned int>) +
+	       argmaxNodes.size() * sizeof(unsigned int);
+}
+
+QueryResultCache::QueryResultCache(size_t capacity)
+    : capacity_(capacity), memoryUsage_(0), version_(0)
+{
+}
+
+QueryResultCache::QueryResultCache(const QueryResultCache& o)
+    : capacity_(0), memoryUsage_(0), version_(0)
+{
+	std::lock_guard<std::mutex> lock(o.mutex_);
+	capacity_ = o.capacity_;
+}
+
+QueryResultCache& QueryResultCache::operator=(const QueryResultCache& o)
+{
+	if(this == &o) {
+		return *this;
+	}
+	size_t capacity;
+	{
+		std::lock_guard<std::mutex> lock(o.mutex_);
+		capacity = o.capacity_;
+	}
+	std::lock_guard<std::mutex> lock(mutex_);
+	clearEntries();
+	capacity_ = capacity;
+	version_ = 0;
+	return *this;
+}
+
+std::shared_ptr<const QueryResultCache::Result>
+QueryResultCache::find(const QueryResultKey& key, unsigned long version)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	if(version != version_) {
+		clearEntries();
+		version_ = version;
+		return nullptr;
+	}
+	auto it = index_.find(key);
+	if(it == index_.end()) {
+		return nullptr;
+	}
+	entries_.splice(entries_.begin(), entries_, it->second);
+	return it->second->result;
+}
+
+void QueryResultCache::insert(const QueryResultKey& key, unsigned long version,
+                              const Result& result)
+{
+	// The key is stored twice, once in the entry and once in the index
+	size_t bytes = 2 * key.getMemoryUsage() + sizeof(Entry) + sizeof(Result) + 64;
+	for(const auto& s : result.second) {
+		bytes += sizeof(std::string) + s.capacity();
+	}
+	auto stored = std::make_shared<const Result>(result);
+	std::lock_guard<std::mutex> lock(mutex_);
+	if(version != version_) {
+		clearEntries();
+		version_ = version;
+	}
+	auto it = index_.find(key);
+	if(it != index_.end()) {
+		memoryUsage_ -= it->second->bytes;
+		entries_.erase(it->second);
+		index_.erase(it);
+	}
+	if(bytes > capacity_) {
+		return;
+	}
+	evict(capacity_ - bytes);
+	entries_.push_front(Entry{key, stored, bytes});
+	index_.emplace(key, entries_.begin());
+	memoryUsage_ += bytes;
+}
+
+void QueryResultCache::setCapacity(size_t capacity)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	capacity_ = capacity;
+	evict(capacity_);
+}
+
+void QueryResultCache::evict(size_t capacity)
+{
+	while(memoryUsage_ > capacity && !entries_.empty()) {
+		memoryUsage_ -= entries_.back().bytes;
+		index_.erase(entries_.back().key);
+		entries_.pop_back();
+	}
+}
+
+void QueryResultCache::clear()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	clearEntries();
+}
+
+void QueryResultCache::clearEntries()
+{
+	entries_.clear();
+	index_.clear();
+	memoryUsage_ = 0;
+}
+
+size_t QueryResultCache::size() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return entries_.size();
+}
+
+size_t QueryResultCache::getMemoryUsage() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return memoryUsage_;
+}
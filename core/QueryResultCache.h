@@ -0,0 +1,137 @@
+#ifndef QUERYRESULTCACHE_H
+#define QUERYRESULTCACHE_H
+
+#include <cstddef>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+ * A canonical representation of a query. All node value pairs and edges are
+ * sorted, hence queries that only differ in the order in which their parts
+ * were specified have the same key.
+ */
+struct QueryResultKey {
+	std::vector<std::pair<unsigned int, int>> nonInterventions;
+	std::vector<std::pair<unsigned int, int>> conditions;
+	std::vector<std::pair<unsigned int, int>> doInterventions;
+	std::vector<std::pair<unsigned int, unsigned int>> addedEdges;
+	std::vector<std::pair<unsigned int, unsigned int>> removedEdges;
+	std::vector<unsigned int> argmaxNodes;
+
+	bool operator<(const QueryResultKey& o) const;
+
+	/**getMemoryUsage
+	 *
+	 * @return the approximate number of bytes used by the key
+	 */
+	size_t getMemoryUsage() const;
+};
+
+/*
+ * Stores the results of exact queries in least recently used order. The
+ * cache is bounded by the approximate memory used by its keys and results.
+ * Every result belongs to a model version of the network, a lookup with a
+ * newer version removes all stored results. Copies of a cache are empty,
+ * since the versions of copied networks evolve independently. All methods
+ * may be called concurrently.
+ */
+class QueryResultCache{
+	public:
+	typedef std::pair<float, std::vector<std::string>> Result;
+
+	/**QueryResultCache
+	 *
+	 * @param capacity, the maximal memory used by the cache in bytes (default is 16 MiB)
+	 *
+	 * @return an empty QueryResultCache object
+	 */
+	explicit QueryResultCache(size_t capacity = 16u << 20);
+
+	QueryResultCache(const QueryResultCache& o);
+	QueryResultCache& operator=(const QueryResultCache& o);
+
+	/**find
+	 *
+	 * @param key, the canonical query
+	 * @param version, the current model version of the network
+	 *
+	 * @return a pointer to the stored result, nullptr if there is none. The
+	 * result becomes the most recently used one and stays valid if it is
+	 * removed from the cache.
+	 */
+	std::shared_ptr<const Result> find(const QueryResultKey& key,
+	                                   unsigned long version);
+
+	/**insert
+	 *
+	 * @param key, the canonical query
+	 * @param version, the model version the result was computed with
+	 * @param result, the result to store
+	 *
+	 * Least recently used results are removed until the new result fits
+	 */
+	void insert(const QueryResultKey& key, unsigned long version,
+	            const Result& result);
+
+	/**setCapacity
+	 *
+	 * @param capacity, the maximal memory used by the cache in bytes
+	 */
+	void setCapacity(size_t capacity);
+
+	/**clear
+	 *
+	 * Removes all stored results
+	 */
+	void clear();
+
+	/**size
+	 *
+	 * @return the number of stored results
+	 */
+	size_t size() const;
+
+	/**getMemoryUsage
+	 *
+	 * @return the approximate number of bytes used by the stored results
+	 */
+	size_t getMemoryUsage() const;
+
+	private:
+	struct Entry {
+		QueryResultKey key;
+		std::shared_ptr<const Result> result;
+		size_t bytes;
+	};
+
+	/**evict
+	 *
+	 * @param capacity, the memory the cache may use afterwards
+	 *
+	 * Removes least recently used results until the memory usage is below the
+	 * capacity, the caller has to hold the lock
+	 */
+	void evict(size_t capacity);
+
+	/**clearEntries
+	 *
+	 * Removes all stored results, the caller has to hold the lock
+	 */
+	void clearEntries();
+
+	size_t capacity_;
+	size_t memoryUsage_;
+	//Model version of the stored results
+	unsigned long version_;
+	//The entries, most recently used first
+	std::list<Entry> entries_;
+	std::map<QueryResultKey, std::list<Entry>::iterator> index_;
+	mutable std::mutex mutex_;
+};
+
+#endif
@@ -0,0 +1,39 @@
+#include "SamplePatterns.h"
+
+#include <map>
+
+SamplePatterns::SamplePatterns() : patterns_(0, 0, -1) {}
+
+SamplePatterns::SamplePatterns(const Matrix<int>& observations)
+{
+	std::map<std::vector<int>, unsigned int> counts;
+	std::vector<int> sample(observations.getRowCount());
+	for(unsigned int col = 0; col < observations.getColCount(); col++) {
+		for(unsigned int row = 0; row < observations.getRowCount(); row++) {
+			sample[row] = observations(col, row);
+		}
+		counts[sample]++;
+	}
+	patterns_ = Matrix<int>(counts.size(), observations.getRowCount(), -1,
+	                        {"NA"}, observations.getRowNames());
+	weights_.reserve(counts.size());
+	unsigned int col = 0;
+	for(const auto& pattern : counts) {
+		for(unsigned int row = 0; row < pattern.first.size(); row++) {
+			patterns_(col, row) = pattern.first[row];
+		}
+		weights_.push_back(pattern.second);
+		col++;
+	}
+}
+
+Matrix<int>& SamplePatterns::getPatterns() { return patterns_; }
+
+const Matrix<int>& SamplePatterns::getPatterns() const { return patterns_; }
+
+const std::vector<unsigned int>& SamplePatterns::getWeights() const
+{
+	return weights_;
+}
+
+size_t SamplePatterns::size() const { return weights_.size(); }
@@ -0,0 +1,61 @@
+#ifndef SAMPLEPATTERNS_H
+#define SAMPLEPATTERNS_H
+
+#include "Matrix.h"
+
+#include <vector>
+
+/*
+ * The discretised observations with identical samples collapsed into a single
+ * pattern. Every pattern is weighted by the number of samples it represents.
+ * The patterns keep the row names of the observations and are sorted
+ * lexicographically, missing values are kept as -1.
+ */
+class SamplePatterns{
+	public:
+	/**SamplePatterns
+	 *
+	 * @return SamplePatterns object without any pattern
+	 */
+	SamplePatterns();
+
+	/**SamplePatterns
+	 *
+	 * @param observations, A Matrix of type int containing the discretised observations
+	 *
+	 * @return SamplePatterns object containing the unique samples of the observations
+	 */
+	explicit SamplePatterns(const Matrix<int>& observations);
+
+	/**getPatterns
+	 *
+	 * @return A Matrix containing one unique sample per column
+	 */
+	Matrix<int>& getPatterns();
+
+	/**getPatterns const
+	 *
+	 * @return A Matrix containing one unique sample per column
+	 */
+	const Matrix<int>& getPatterns() const;
+
+	/**getWeights
+	 *
+	 * @return The number of samples represented by each pattern
+	 */
+	const std::vector<unsigned int>& getWeights() const;
+
+	/**size
+	 *
+	 * @return The number of unique patterns
+	 */
+	size_t size() const;
+
+	private:
+	//The unique samples, one per column
+	Matrix<int> patterns_;
+	//Number of samples represented by each pattern
+	std::vector<unsigned int> weights_;
+};
+
+#endif
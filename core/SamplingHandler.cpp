@@ -0,0 +1,323 @@
+#include "SamplingHandler.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+namespace {
+
+struct SampledNode {
+	unsigned int id;
+	std::vector<unsigned int> parents;
+	std::vector<unsigned int> factors;
+	unsigned int cardinality;
+	size_t rows;
+	// Position of the first CPT entry in the flat tables
+	size_t offset;
+	// Value of a condition node, -1 for sampled nodes
+	int value;
+};
+
+struct SamplingModel {
+	// The sampled nodes in topological order
+	std::vector<SampledNode> nodes;
+	// The CPT entries of all sampled nodes, row by row
+	std::vector<float> probabilities;
+	// The sampling distributions, every row sums up to one
+	std::vector<float> importance;
+	std::vector<std::pair<unsigned int, int>> query;
+	size_t networkSize;
+};
+
+struct Accumulator {
+	double weights = 0.0;
+	double hits = 0.0;
+	double squaredWeights = 0.0;
+	double squaredHits = 0.0;
+	size_t samples = 0;
+	// Weighted counts of the sampled CPT entries, only used for learning
+	std::vector<double> counts;
+};
+
+SamplingModel createModel(const Network& network,
+                          const std::vector<unsigned int>& queryNodes,
+                          const std::vector<unsigned int>& conditionNodes,
+                          const std::vector<int>& queryValues,
+                          const std::vector<int>& conditionValues)
+{
+	SamplingModel model;
+	model.networkSize = network.size();
+	std::vector<bool> observed(network.size(), false);
+	for(unsigned int id : conditionNodes) {
+		observed[id] = true;
+	}
+	for(unsigned int id : queryNodes) {
+		if(queryValues[id] == -1) {
+			throw std::invalid_argument(
+			    "The current node does not contain the query value");
+		}
+		model.query.push_back(std::make_pair(id, queryValues[id]));
+	}
+	std::vector<unsigned int> nodes(conditionNodes);
+	nodes.insert(nodes.end(), queryNodes.begin(), queryNodes.end());
+
+	for(unsigned int id : network.getAncestralOrder(nodes)) {
+		const Node& n = network.getNode(id);
+		const auto& probMatrix = n.getProbabilityMatrix();
+		SampledNode node;
+		node.id = id;
+		node.parents = n.getParents();
+		for(unsigned int i = 0; i < node.parents.size(); i++) {
+			node.factors.push_back(n.getFactor(i));
+		}
+		node.cardinality = probMatrix.getColCount();
+		node.offset = model.probabilities.size();
+		node.value = observed[id] ? conditionValues[id] : -1;
+		// Nodes without parents, e.g. after a do-intervention, use the first row
+		node.rows = node.parents.empty() ? 1 : probMatrix.getRowCount();
+		for(size_t row = 0; row < node.rows; row++) {
+			float rowSum = 0.0f;
+			for(unsigned int col = 0; col < node.cardinality; col++) {
+				model.probabilities.push_back(probMatrix(col, row));
+				rowSum += probMatrix(col, row);
+			}
+			for(unsigned int col = 0; col < node.cardinality; col++) {
+				model.importance.push_back(rowSum > 0.0f
+				                               ? probMatrix(col, row) / rowSum
+				                               : 1.0f / node.cardinality);
+			}
+		}
+		model.nodes.push_back(node);
+	}
+	return model;
+}
+
+/**drawSample
+ *
+ * Samples all nodes of the model, stores the values and the index of the
+ * chosen CPT entry of every node and returns the weight of the sample.
+ */
+double drawSample(const SamplingModel& model, std::mt19937_64& rng,
+                  std::vector<int>& values, std::vector<size_t>& entries)
+{
+	std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+	double weight = 1.0;
+	for(unsigned int i = 0; i < model.nodes.size(); i++) {
+		const SampledNode& node = model.nodes[i];
+		size_t row = 0;
+		for(unsigned int p = 0; p < node.parents.size(); p++) {
+			row += node.factors[p] * values[node.parents[p]];
+		}
+		size_t base = node.offset + row * node.cardinality;
+		if(node.value != -1) {
+			values[node.id] = node.value;
+			entries[i] = base + node.value;
+			weight *= model.probabilities[entries[i]];
+		} else {
+			float u = uniform(rng);
+			unsigned int col = 0;
+			for(; col + 1 < node.cardinality; col++) {
+				u -= model.importance[base + col];
+				if(u < 0.0f) {
+					break;
+				}
+			}
+			values[node.id] = col;
+			entries[i] = base + col;
+			float q = model.importance[entries[i]];
+			weight *= q > 0.0f ? model.probabilities[entries[i]] / q : 0.0f;
+		}
+	}
+	return weight;
+}
+
+/**runTasks
+ *
+ * Draws samples in parallel on the global thread pool. Every task uses its
+ * own random number stream, derived from the seed, the round and the task
+ * index, and its own accumulator.
+ */
+std::vector<Accumulator>
+runTasks(const SamplingModel& model, unsigned int tasks, size_t samples,
+         std::chrono::milliseconds time, uint64_t seed, unsigned int round,
+         bool learning)
+{
+	auto deadline = std::chrono::steady_clock::now() + time;
+	std::vector<Accumulator> accumulators(tasks);
+	std::atomic<unsigned int> finished(0);
+	ThreadPool& pool = ThreadPool::getGlobalPool();
+	for(unsigned int t = 0; t < tasks; t++) {
+		pool.submit([&, t]() {
+			std::seed_seq sequence{static_cast<uint32_t>(seed),
+			                       static_cast<uint32_t>(seed >> 32), round, t};
+			std::mt19937_64 rng(sequence);
+			Accumulator& acc = accumulators[t];
+			if(learning) {
+				acc.counts.assign(model.probabilities.size(), 0.0);
+			}
+			std::vector<int> values(model.networkSize, -1);
+			std::vector<size_t> entries(model.nodes.size());
+			size_t limit = samples / tasks + (t < samples % tasks ? 1 : 0);
+			for(size_t i = 0; samples == 0 || i < limit; i++) {
+				if(time.count() > 0 && i % 256 == 0 &&
+				   std::chrono::steady_clock::now() >= deadline) {
+					break;
+				}
+				double weight = drawSample(model, rng, values, entries);
+				bool hit = true;
+				for(const auto& q : model.query) {
+					hit = hit && values[q.first] == q.second;
+				}
+				acc.samples++;
+				acc.weights += weight;
+				acc.squaredWeights += weight * weight;
+				if(hit) {
+					acc.hits += weight;
+					acc.squaredHits += weight * weight;
+				}
+				if(learning) {
+					for(unsigned int n = 0; n < model.nodes.size(); n++) {
+						if(model.nodes[n].value == -1) {
+							acc.counts[entries[n]] += weight;
+						}
+					}
+				}
+			}
+			finished++;
+		});
+	}
+	pool.waitUntil([&]() { return finished == tasks; });
+	return accumulators;
+}
+
+/**updateImportance
+ *
+ * Moves the sampling distributions of the sampled nodes towards the weighted
+ * frequencies observed during a learning round. Rows keep summing up to one
+ * and entries with a non-zero probability stay positive.
+ */
+void updateImportance(SamplingModel& model,
+                      const std::vector<Accumulator>& accumulators,
+                      double rate)
+{
+	std::vector<double> counts(model.probabilities.size(), 0.0);
+	for(const auto& acc : accumulators) {
+		for(size_t i = 0; i < counts.size(); i++) {
+			counts[i] += acc.counts[i];
+		}
+	}
+	for(const auto& node : model.nodes) {
+		if(node.value != -1) {
+			continue;
+		}
+		size_t end = node.offset + node.rows * node.cardinality;
+		for(size_t base = node.offset; base < end; base += node.cardinality) {
+			double total = 0.0;
+			for(unsigned int col = 0; col < node.cardinality; col++) {
+				total += counts[base + col];
+			}
+			if(total <= 0.0) {
+				continue;
+			}
+			for(unsigned int col = 0; col < node.cardinality; col++) {
+				model.importance[base + col] = static_cast<float>(
+				    (1.0 - rate) * model.importance[base + col] +
+				    rate * counts[base + col] / total);
+			}
+		}
+	}
+}
+
+}
+
+SamplingHandler::SamplingHandler(const Network& network)
+    : network_(network),
+      samples_(100000),
+      time_(0),
+      tasks_(0),
+      seed_(5489u),
+      adaptive_(false),
+      learningSamples_(10000),
+      learningRounds_(5)
+{
+}
+
+void SamplingHandler::setSampleBudget(size_t samples) { samples_ = samples; }
+
+void SamplingHandler::setTimeBudget(std::chrono::milliseconds time)
+{
+	time_ = time;
+}
+
+void SamplingHandler::setNumberOfTasks(unsigned int tasks) { tasks_ = tasks; }
+
+void SamplingHandler::setSeed(uint64_t seed) { seed_ = seed; }
+
+void SamplingHandler::setAdaptiveImportanceSampling(bool adaptive,
+                                                    size_t learningSamples,
+                                                    unsigned int learningRounds)
+{
+	if(adaptive && (learningRounds == 0 || learningSamples < learningRounds)) {
+		throw std::invalid_argument(
+		    "Every learning round requires at least one sample");
+	}
+	adaptive_ = adaptive;
+	learningSamples_ = learningSamples;
+	learningRounds_ = learningRounds;
+}
+
+SamplingEstimate SamplingHandler::computeProbability(
+    const std::vector<unsigned int>& queryNodes,
+    const std::vector<unsigned int>& conditionNodes,
+    const std::vector<int>& queryValues,
+    const std::vector<int>& conditionValues) const
+{
+	if(samples_ == 0 && time_.count() <= 0) {
+		throw std::invalid_argument(
+		    "Either a sample or a time budget is required for sampling");
+	}
+	SamplingModel model = createModel(network_, queryNodes, conditionNodes,
+	                                  queryValues, conditionValues);
+	unsigned int tasks =
+	    tasks_ != 0 ? tasks_ : ThreadPool::getGlobalPool().size();
+
+	if(adaptive_ && !conditionNodes.empty()) {
+		// Learning rate schedule of AIS-BN, decreasing from 0.4 to 0.14
+		for(unsigned int round = 0; round < learningRounds_; round++) {
+			double rate =
+			    0.4 * std::pow(0.14 / 0.4, static_cast<double>(round) /
+			                                   std::max(1u, learningRounds_ - 1));
+			auto accumulators =
+			    runTasks(model, tasks, learningSamples_ / learningRounds_,
+			             std::chrono::milliseconds(0), seed_, round + 1, true);
+			updateImportance(model, accumulators, rate);
+		}
+	}
+
+	Accumulator total;
+	for(const auto& acc : runTasks(model, tasks, samples_, time_, seed_, 0, false)) {
+		total.weights += acc.weights;
+		total.hits += acc.hits;
+		total.squaredWeights += acc.squaredWeights;
+		total.squaredHits += acc.squaredHits;
+		total.samples += acc.samples;
+	}
+	if(total.weights <= 0.0) {
+		throw std::invalid_argument(
+		    "None of the samples is consistent with the conditions");
+	}
+	// Standard error of the ratio estimator (delta method)
+	double p = total.hits / total.weights;
+	double variance =
+	    total.squaredHits * (1.0 - 2.0 * p) + p * p * total.squaredWeights;
+	SamplingEstimate estimate;
+	estimate.probability = static_cast<float>(p);
+	estimate.standardError =
+	    static_cast<float>(std::sqrt(std::max(0.0, variance)) / total.weights);
+	estimate.samples = total.samples;
+	estimate.rHat = 1.0f;
+	return estimate;
+}
@@ -0,0 +1,147 @@
+#ifndef SAMPLINGHANDLER_H
+#define SAMPLINGHANDLER_H
+
+#include "Network.h"
+
+#include <chrono>
+#include <cstdint>
+
+/*
+ * Result of an approximate query, the estimated probability together with its
+ * standard error and the number of samples the estimate is based on. For
+ * Markov chain estimates, rHat is the potential scale reduction factor of the
+ * chains, it is 1 for independent samples.
+ */
+struct SamplingEstimate {
+	float probability;
+	float standardError;
+	size_t samples;
+	float rHat;
+};
+
+/*
+ * Approximates probabilities by forward sampling with likelihood weighting.
+ * Only the ancestors of the query and condition nodes are sampled, condition
+ * nodes are clamped to their values and weight the sample by their
+ * likelihood. Optionally, the sampling distributions are first adapted to the
+ * posterior distribution (adaptive importance sampling, AIS-BN). The samples
+ * are drawn in parallel, every task uses its own random number stream and
+ * accumulates its own weighted counts, which are merged at the end.
+ */
+class SamplingHandler
+{
+	public:
+	/**SamplingHandler
+	 *
+	 * @param network, a reference to the network
+	 *
+	 * @return SamplingHandler object using 100000 samples, no time budget and
+	 * one sampling task per worker of the global thread pool
+	 */
+	explicit SamplingHandler(const Network& network);
+
+	SamplingHandler(const SamplingHandler& o)
+		: network_(o.network_),
+		  samples_(o.samples_),
+		  time_(o.time_),
+		  tasks_(o.tasks_),
+		  seed_(o.seed_),
+		  adaptive_(o.adaptive_),
+		  learningSamples_(o.learningSamples_),
+		  learningRounds_(o.learningRounds_)
+	{
+	}
+
+	/**SamplingHandler
+	 *
+	 * @param o, the SamplingHandler whose settings are copied
+	 * @param network, a reference to the network the new handler works on
+	 *
+	 * @return a SamplingHandler object
+	 */
+	SamplingHandler(const SamplingHandler& o, const Network& network)
+		: network_(network),
+		  samples_(o.samples_),
+		  time_(o.time_),
+		  tasks_(o.tasks_),
+		  seed_(o.seed_),
+		  adaptive_(o.adaptive_),
+		  learningSamples_(o.learningSamples_),
+		  learningRounds_(o.learningRounds_)
+	{
+	}
+
+	SamplingHandler& operator=(const SamplingHandler&) = delete;
+	SamplingHandler& operator=(SamplingHandler&&) = delete;
+
+	/**setSampleBudget
+	 *
+	 * @param samples, the number of samples per query, 0 for no limit
+	 */
+	void setSampleBudget(size_t samples);
+
+	/**setTimeBudget
+	 *
+	 * @param time, the time available for sampling per query, 0 for no limit
+	 *
+	 * Sampling stops as soon as either the sample or the time budget is spent.
+	 */
+	void setTimeBudget(std::chrono::milliseconds time);
+
+	/**setNumberOfTasks
+	 *
+	 * @param tasks, the number of parallel sampling tasks, 0 for one task per
+	 * worker of the global thread pool
+	 *
+	 * Every task draws samples from its own random number stream. For a fixed
+	 * seed, sample budget and number of tasks the estimates are reproducible.
+	 */
+	void setNumberOfTasks(unsigned int tasks);
+
+	/**setSeed
+	 *
+	 * @param seed, the seed of the random number streams
+	 */
+	void setSeed(uint64_t seed);
+
+	/**setAdaptiveImportanceSampling
+	 *
+	 * @param adaptive, true to adapt the sampling distributions before estimating
+	 * @param learningSamples, the number of samples used to adapt the distributions
+	 * @param learningRounds, the number of updates of the distributions
+	 *
+	 * The learning samples are not part of the estimate.
+	 */
+	void setAdaptiveImportanceSampling(bool adaptive,
+	                                   size_t learningSamples = 10000,
+	                                   unsigned int learningRounds = 5);
+
+	/**computeProbability
+	 *
+	 * @param queryNodes, identifiers of the query nodes
+	 * @param conditionNodes, identifiers of the condition nodes
+	 * @param queryValues, values of the query nodes, indexed by node identifier
+	 * @param conditionValues, values of the condition nodes, indexed by node identifier
+	 *
+	 * @return the estimated probability of the query values given the condition
+	 * values. Throws an invalid_argument exception if no budget is set or if no
+	 * sample has a non-zero weight.
+	 */
+	SamplingEstimate computeProbability(
+	    const std::vector<unsigned int>& queryNodes,
+	    const std::vector<unsigned int>& conditionNodes,
+	    const std::vector<int>& queryValues,
+	    const std::vector<int>& conditionValues) const;
+
+	private:
+	const Network& network_;
+	size_t samples_;
+	std::chrono::milliseconds time_;
+	unsigned int tasks_;
+	uint64_t seed_;
+	bool adaptive_;
+	size_t learningSamples_;
+	unsigned int learningRounds_;
+};
+
+#endif
@@ -0,0 +1,138 @@
+#include "ThreadPool.h"
+#include "QueryArena.h"
+
+#include <algorithm>
+
+thread_local ThreadPool* ThreadPool::currentPool_ = nullptr;
+thread_local unsigned int ThreadPool::currentQueue_ = 0;
+
+ThreadPool::ThreadPool(unsigned int threads)
+    : pending_(0), completed_(0), waiters_(0), stop_(false)
+{
+	threads = std::max(1u, threads);
+	for(unsigned int i = 0; i <= threads; i++) {
+		queues_.push_back(std::unique_ptr<Queue>(new Queue()));
+	}
+	for(unsigned int i = 0; i < threads; i++) {
+		threads_.push_back(std::thread(&ThreadPool::work, this, i));
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+	}
+	condition_.notify_all();
+	for(auto& thread : threads_) {
+		thread.join();
+	}
+}
+
+ThreadPool& ThreadPool::getGlobalPool()
+{
+	static ThreadPool pool(std::thread::hardware_concurrency());
+	return pool;
+}
+
+unsigned int ThreadPool::size() const { return threads_.size(); }
+
+void ThreadPool::submit(std::function<void()> task)
+{
+	unsigned int index = (currentPool_ == this) ? currentQueue_ : threads_.size();
+	{
+		std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+		queues_[index]->tasks.push_back(std::move(task));
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		pending_++;
+	}
+	condition_.notify_one();
+	if(waiters_ > 0) {
+		waiting_.notify_all();
+	}
+}
+
+bool ThreadPool::popTask(unsigned int index, std::function<void()>& task)
+{
+	{
+		Queue& own = *queues_[index];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if(!own.tasks.empty()) {
+			task = std::move(own.tasks.back());
+			own.tasks.pop_back();
+			pending_--;
+			return true;
+		}
+	}
+	for(unsigned int i = 1; i < queues_.size(); i++) {
+		Queue& other = *queues_[(index + i) % queues_.size()];
+		std::lock_guard<std::mutex> lock(other.mutex);
+		if(!other.tasks.empty()) {
+			task = std::move(other.tasks.front());
+			other.tasks.pop_front();
+			pending_--;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool ThreadPool::runPendingTask()
+{
+	unsigned int index = (currentPool_ == this) ? currentQueue_ : threads_.size();
+	std::function<void()> task;
+	if(!popTask(index, task)) {
+		return false;
+	}
+	runTask(task);
+	return true;
+}
+
+void ThreadPool::runTask(const std::function<void()>& task)
+{
+	{
+		// A helping thread may have the arena of its own query installed
+		QueryArena::Scope scope(nullptr);
+		task();
+	}
+	completed_++;
+	if(waiters_ > 0) {
+		// The lock orders the notification after the check of a waiter
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+		}
+		waiting_.notify_all();
+	}
+}
+
+void ThreadPool::waitForChange(unsigned long completed)
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	waiters_++;
+	waiting_.wait(lock, [this, completed] {
+		return pending_ > 0 || completed_ != completed;
+	});
+	waiters_--;
+}
+
+void ThreadPool::work(unsigned int index)
+{
+	currentPool_ = this;
+	currentQueue_ = index;
+	std::function<void()> task;
+	while(true) {
+		if(popTask(index, task)) {
+			runTask(task);
+			task = nullptr;
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(mutex_);
+		condition_.wait(lock, [this] { return stop_ || pending_ > 0; });
+		if(stop_ && pending_ == 0) {
+			return;
+		}
+	}
+}
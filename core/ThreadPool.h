@@ -0,0 +1,146 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * A work-stealing thread pool. Every worker owns a task queue. Tasks that are
+ * submitted by a worker are pushed to its own queue and processed in LIFO
+ * order, idle workers steal the oldest tasks from other queues. Tasks
+ * submitted by other threads are placed in a shared queue. Threads waiting
+ * for results help processing pending tasks, hence tasks may wait for tasks
+ * they submitted without risking a deadlock.
+ */
+class ThreadPool{
+	public:
+	/**ThreadPool
+	 *
+	 * @param threads, the number of worker threads (at least one)
+	 *
+	 * @return a ThreadPool object with running worker threads
+	 */
+	explicit ThreadPool(unsigned int threads);
+
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	/**getGlobalPool
+	 *
+	 * @return a pool shared by the whole process with one worker per hardware thread
+	 */
+	static ThreadPool& getGlobalPool();
+
+	/**size
+	 *
+	 * @return the number of worker threads
+	 */
+	unsigned int size() const;
+
+	/**submit
+	 *
+	 * @param task, the task to execute
+	 *
+	 * Queues the task for execution by one of the worker threads. The task is
+	 * executed without a current QueryArena.
+	 */
+	void submit(std::function<void()> task);
+
+	/**runPendingTask
+	 *
+	 * @return true if a pending task was executed by the calling thread, false
+	 * if there was no pending task
+	 */
+	bool runPendingTask();
+
+	/**waitUntil
+	 *
+	 * @param done, a predicate signalling that the awaited work is finished
+	 *
+	 * Processes pending tasks until the predicate returns true. Without
+	 * pending tasks the calling thread sleeps until a task is submitted or
+	 * completed, hence the predicate must only change through tasks of this pool.
+	 */
+	template<class Predicate> void waitUntil(Predicate done)
+	{
+		while(true) {
+			unsigned long completed = completed_;
+			if(done()) {
+				return;
+			}
+			if(!runPendingTask()) {
+				waitForChange(completed);
+			}
+		}
+	}
+
+	private:
+	/**work
+	 *
+	 * @param index, the index of the queue owned by the worker
+	 *
+	 * Main loop of a worker thread
+	 */
+	void work(unsigned int index);
+
+	/**popTask
+	 *
+	 * @param index, the queue to start with
+	 * @param task, receives the task
+	 *
+	 * @return true if a task was found, false otherwise
+	 *
+	 * Takes the newest task from the given queue or steals the oldest one
+	 * from any other queue
+	 */
+	bool popTask(unsigned int index, std::function<void()>& task);
+
+	/**runTask
+	 *
+	 * @param task, the task to execute
+	 *
+	 * Executes the task without a current QueryArena, tasks that allocate
+	 * from the arena of a query have to install it themselves
+	 */
+	void runTask(const std::function<void()>& task);
+
+	/**waitForChange
+	 *
+	 * @param completed, the number of completed tasks seen by the caller
+	 *
+	 * Blocks until a task is pending or more tasks have been completed
+	 */
+	void waitForChange(unsigned long completed);
+
+	struct Queue {
+		std::mutex mutex;
+		std::deque<std::function<void()>> tasks;
+	};
+
+	//One queue per worker followed by the shared queue
+	std::vector<std::unique_ptr<Queue>> queues_;
+	std::vector<std::thread> threads_;
+	//Number of queued tasks, used to put idle workers to sleep
+	std::atomic<unsigned int> pending_;
+	//Number of completed tasks and of threads sleeping in waitUntil
+	std::atomic<unsigned long> completed_;
+	std::atomic<unsigned int> waiters_;
+	std::mutex mutex_;
+	std::condition_variable condition_;
+	std::condition_variable waiting_;
+	bool stop_;
+
+	//The pool and queue index of the current worker thread
+	static thread_local ThreadPool* currentPool_;
+	static thread_local unsigned int currentQueue_;
+};
+
+#endif
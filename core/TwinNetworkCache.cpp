@@ -0,0 +1,77 @@
+#include "TwinNetworkCache.h"
+#include "Network.h"
+
+#include <tuple>
+
+bool TwinNetworkKey::operator<(const TwinNetworkKey& o) const
+{
+	return std::tie(nodes, interventions) < std::tie(o.nodes, o.interventions);
+}
+
+TwinNetworkCache::TwinNetworkCache(size_t capacity)
+    : capacity_(capacity), version_(0)
+{
+}
+
+TwinNetworkCache::TwinNetworkCache(const TwinNetworkCache& o)
+    : capacity_(0), version_(0)
+{
+	std::lock_guard<std::mutex> lock(o.mutex_);
+	capacity_ = o.capacity_;
+}
+
+TwinNetworkCache& TwinNetworkCache::operator=(const TwinNetworkCache& o)
+{
+	if(this == &o) {
+		return *this;
+	}
+	size_t capacity;
+	{
+		std::lock_guard<std::mutex> lock(o.mutex_);
+		capacity = o.capacity_;
+	}
+	std::lock_guard<std::mutex> lock(mutex_);
+	twins_.clear();
+	capacity_ = capacity;
+	version_ = 0;
+	return *this;
+}
+
+std::shared_ptr<const Network>
+TwinNetworkCache::find(const TwinNetworkKey& key, unsigned long version)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	if(version != version_) {
+		twins_.clear();
+		version_ = version;
+		return nullptr;
+	}
+	auto it = twins_.find(key);
+	if(it == twins_.end()) {
+		return nullptr;
+	}
+	return it->second;
+}
+
+void TwinNetworkCache::insert(const TwinNetworkKey& key, unsigned long version,
+                              std::shared_ptr<const Network> twin)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	if(version != version_ || twins_.size() >= capacity_) {
+		twins_.clear();
+		version_ = version;
+	}
+	twins_[key] = std::move(twin);
+}
+
+void TwinNetworkCache::clear()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	twins_.clear();
+}
+
+size_t TwinNetworkCache::size() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return twins_.size();
+}
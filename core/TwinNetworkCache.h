@@ -0,0 +1,88 @@
+#ifndef TWINNETWORKCACHE_H
+#define TWINNETWORKCACHE_H
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+class Network;
+
+/*
+ * The structure of a counterfactual query that determines its twin network,
+ * i.e. the query nodes and the Do-Interventions with their values. Both are
+ * sorted, hence the order in which they were specified does not matter.
+ */
+struct TwinNetworkKey {
+	std::vector<unsigned int> nodes;
+	std::vector<std::pair<unsigned int, int>> interventions;
+
+	bool operator<(const TwinNetworkKey& o) const;
+};
+
+/*
+ * Stores twin networks with their interventions applied, such that
+ * counterfactual queries of the same structure share a single twin network.
+ * Every twin network belongs to a model version of the network it was created
+ * from, a lookup with a newer version removes all stored networks. Copies of a
+ * cache are empty. All methods may be called concurrently.
+ */
+class TwinNetworkCache{
+	public:
+	/**TwinNetworkCache
+	 *
+	 * @param capacity, maximal number of stored twin networks (default is 32)
+	 *
+	 * @return an empty TwinNetworkCache object
+	 */
+	explicit TwinNetworkCache(size_t capacity = 32);
+
+	TwinNetworkCache(const TwinNetworkCache& o);
+	TwinNetworkCache& operator=(const TwinNetworkCache& o);
+
+	/**find
+	 *
+	 * @param key, the structure of the counterfactual query
+	 * @param version, the current model version of the network
+	 *
+	 * @return a pointer to the stored twin network, nullptr if there is none
+	 */
+	std::shared_ptr<const Network> find(const TwinNetworkKey& key,
+	                                    unsigned long version);
+
+	/**insert
+	 *
+	 * @param key, the structure of the counterfactual query
+	 * @param version, the model version the twin network was created from
+	 * @param twin, the twin network to store
+	 *
+	 * If the cache is full, all twin networks are removed before the new one
+	 * is stored
+	 */
+	void insert(const TwinNetworkKey& key, unsigned long version,
+	            std::shared_ptr<const Network> twin);
+
+	/**clear
+	 *
+	 * Removes all stored twin networks
+	 */
+	void clear();
+
+	/**size
+	 *
+	 * @return the number of stored twin networks
+	 */
+	size_t size() const;
+
+	private:
+	//Maximal number of stored twin networks
+	size_t capacity_;
+	//Model version of the stored twin networks
+	unsigned long version_;
+	std::map<TwinNetworkKey, std::shared_ptr<const Network>> twins_;
+	mutable std::mutex mutex_;
+};
+
+#endif
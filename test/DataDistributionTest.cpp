@@ -278,3 +278,32 @@ TEST_F(DataDistributionTest, distributeObservationsTestStudentInComplet){
 	ASSERT_EQ(2875u , Letter.getObservations(2,1));
 	ASSERT_EQ(51u, Letter.getObservations(2,2));
 }
+
+TEST_F(DataDistributionTest, distributeObservationsSamplePatterns){
+	Network n;
+	n.readNetwork(TEST_DATA_PATH("Student.na"));
+	n.readNetwork(TEST_DATA_PATH("Student.sif"));
+	Matrix<std::string> originalObservations (TEST_DATA_PATH("dataStudent60.txt"),false,true);
+	Matrix<int> observations (0,0,-1);
+	Discretiser disc(originalObservations,TEST_DATA_PATH("controlStudent.json"), observations, n);
+	Network weighted = n;
+	DataDistribution db (n, observations);
+	db.assignObservationsToNodes();
+	db.distributeObservations();
+	SamplePatterns patterns (observations);
+	ASSERT_GT(observations.getColCount(), patterns.size());
+	DataDistribution dbw (weighted, patterns);
+	dbw.assignObservationsToNodes();
+	dbw.distributeObservations();
+	for(const Node& node : n.getNodes()){
+		const Matrix<int>& expected = node.getObservationMatrix();
+		const Matrix<int>& actual = weighted.getNode(node.getID()).getObservationMatrix();
+		ASSERT_EQ(expected.getColCount(), actual.getColCount());
+		ASSERT_EQ(expected.getRowCount(), actual.getRowCount());
+		for(unsigned int row = 0; row < expected.getRowCount(); row++){
+			for(unsigned int col = 0; col < expected.getColCount(); col++){
+				ASSERT_EQ(expected(col, row), actual(col, row));
+			}
+		}
+	}
+}
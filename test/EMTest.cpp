@@ -53,7 +53,8 @@ TEST_F(EMTest,Complete){
 	ASSERT_NEAR(0.05f,sat.getProbability(1,0),0.001);
 	ASSERT_NEAR(0.2f,sat.getProbability(0,1),0.001);
 	ASSERT_NEAR(0.8f,sat.getProbability(1,1),0.001);
-	
+	ASSERT_TRUE(std::isfinite(c.getLogLikelihood()));
+	ASSERT_LT(c.getLogLikelihood(), 0.0);
 }
 
 TEST_F(EMTest,UnComplete){
@@ -94,3 +95,115 @@ TEST_F(EMTest,UnComplete){
 	ASSERT_NEAR(0.2f,sat.getProbability(0,1),0.2);
 	ASSERT_NEAR(0.8f,sat.getProbability(1,1),0.2);
 }
+
+TEST_F(EMTest,UnCompleteExpectedCounts){
+	c.loadNetwork(TEST_DATA_PATH("Student.na"));
+	c.loadNetwork(TEST_DATA_PATH("Student.sif"));
+	c.loadObservations(TEST_DATA_PATH("dataStudent60.txt"),TEST_DATA_PATH("controlStudent.json"));
+	c.trainNetwork();
+	Network n = c.getNetwork();
+	Node grade = n.getNode("Grade");
+	ASSERT_NEAR(0.3f,grade.getProbability(0,0),0.06);
+	ASSERT_NEAR(0.9f,grade.getProbability(0,1),0.06);
+	ASSERT_NEAR(0.05f,grade.getProbability(0,2),0.06);
+	ASSERT_NEAR(0.5f,grade.getProbability(0,3),0.06);
+	ASSERT_NEAR(0.7f,grade.getProbability(2,2),0.06);
+	ASSERT_NEAR(0.2f,grade.getProbability(2,3),0.06);
+	Node letter = n.getNode("Letter");
+	ASSERT_NEAR(0.1f,letter.getProbability(0,0),0.06);
+	ASSERT_NEAR(0.4f,letter.getProbability(0,1),0.06);
+	ASSERT_NEAR(0.99f,letter.getProbability(0,2),0.06);
+	Node intelligence = n.getNode("Intelligence");
+	ASSERT_NEAR(0.7, intelligence.getProbability(0,0),0.06);
+	Node difficulty = n.getNode("Difficulty");
+	ASSERT_NEAR(0.6, difficulty.getProbability(0,0),0.06);
+	Node sat = n.getNode("SAT");
+	ASSERT_NEAR(0.95f,sat.getProbability(0,0),0.06);
+	ASSERT_NEAR(0.2f,sat.getProbability(0,1),0.06);
+}
+
+TEST_F(EMTest,UnCompleteRestarts){
+	c.loadNetwork(TEST_DATA_PATH("Student.na"));
+	c.loadNetwork(TEST_DATA_PATH("Student.sif"));
+	c.loadObservations(TEST_DATA_PATH("dataStudent60.txt"),TEST_DATA_PATH("controlStudent.json"));
+	c.trainNetwork();
+	double likelihood = c.getLogLikelihood();
+	NetworkController restarted;
+	restarted.loadNetwork(TEST_DATA_PATH("Student.na"));
+	restarted.loadNetwork(TEST_DATA_PATH("Student.sif"));
+	restarted.loadObservations(TEST_DATA_PATH("dataStudent60.txt"),TEST_DATA_PATH("controlStudent.json"));
+	restarted.setEMRestarts(4);
+	restarted.setEMThreads(2);
+	restarted.trainNetwork();
+	ASSERT_GE(restarted.getLogLikelihood(), likelihood);
+	ASSERT_GT(restarted.getNumberOfEMRuns(), 1);
+	Network n = restarted.getNetwork();
+	Node grade = n.getNode("Grade");
+	ASSERT_NEAR(0.3f,grade.getProbability(0,0),0.2);
+	ASSERT_NEAR(0.9f,grade.getProbability(0,1),0.2);
+	ASSERT_NEAR(0.7f,grade.getProbability(2,2),0.2);
+	Node intelligence = n.getNode("Intelligence");
+	ASSERT_NEAR(0.7, intelligence.getProbability(0,0),0.2);
+}
+
+TEST_F(EMTest,UnCompleteSQUAREM){
+	c.loadNetwork(TEST_DATA_PATH("Student.na"));
+	c.loadNetwork(TEST_DATA_PATH("Student.sif"));
+	c.loadObservations(TEST_DATA_PATH("dataStudent60.txt"),TEST_DATA_PATH("controlStudent.json"));
+	c.trainNetwork();
+	ASSERT_EQ(0, c.getEstimatedNumberOfSavedEMRuns());
+	Network plain = c.getNetwork();
+	NetworkController accelerated;
+	accelerated.loadNetwork(TEST_DATA_PATH("Student.na"));
+	accelerated.loadNetwork(TEST_DATA_PATH("Student.sif"));
+	accelerated.loadObservations(TEST_DATA_PATH("dataStudent60.txt"),TEST_DATA_PATH("controlStudent.json"));
+	accelerated.setEMStrategy(EMStrategy::SQUAREM);
+	accelerated.trainNetwork();
+	ASSERT_LE(accelerated.getParameterDifference(), 0.001f);
+	ASSERT_LE(accelerated.getNumberOfEMRuns(), c.getNumberOfEMRuns());
+	ASSERT_GE(accelerated.getEstimatedNumberOfSavedEMRuns(), 0);
+	for (const Node& n : accelerated.getNetwork().getNodes()){
+		const Matrix<float>& expected = plain.getNode(n.getID()).getProbabilityMatrix();
+		const Matrix<float>& actual = n.getProbabilityMatrix();
+		for(unsigned int row = 0; row < expected.getRowCount(); row++){
+			for(unsigned int col = 0; col < expected.getColCount(); col++){
+				ASSERT_NEAR(expected(col, row), actual(col, row), 0.02);
+			}
+		}
+	}
+}
+
+TEST_F(EMTest,RestartsSelectByObservedLikelihood){
+	//The class node is rarely observed, the initialisations converge to different optima
+	c.loadNetwork(TEST_DATA_PATH("LatentClass.na"));
+	c.loadNetwork(TEST_DATA_PATH("LatentClass.sif"));
+	c.loadObservations(TEST_DATA_PATH("dataLatentClass.txt"),TEST_DATA_PATH("controlLatentClass.json"));
+	c.trainNetwork();
+	double likelihood = c.getLogLikelihood();
+	ASSERT_TRUE(std::isfinite(likelihood));
+	NetworkController restarted;
+	restarted.loadNetwork(TEST_DATA_PATH("LatentClass.na"));
+	restarted.loadNetwork(TEST_DATA_PATH("LatentClass.sif"));
+	restarted.loadObservations(TEST_DATA_PATH("dataLatentClass.txt"),TEST_DATA_PATH("controlLatentClass.json"));
+	restarted.setEMRestarts(8);
+	restarted.trainNetwork();
+	ASSERT_GT(restarted.getLogLikelihood(), likelihood);
+}
+
+TEST_F(EMTest,SQUAREMLatentClass){
+	//The data based initialisation has zero cells which make samples impossible
+	c.loadNetwork(TEST_DATA_PATH("LatentClass.na"));
+	c.loadNetwork(TEST_DATA_PATH("LatentClass.sif"));
+	c.loadObservations(TEST_DATA_PATH("dataLatentClass.txt"),TEST_DATA_PATH("controlLatentClass.json"));
+	c.trainNetwork();
+	NetworkController accelerated;
+	accelerated.loadNetwork(TEST_DATA_PATH("LatentClass.na"));
+	accelerated.loadNetwork(TEST_DATA_PATH("LatentClass.sif"));
+	accelerated.loadObservations(TEST_DATA_PATH("dataLatentClass.txt"),TEST_DATA_PATH("controlLatentClass.json"));
+	accelerated.setEMStrategy(EMStrategy::SQUAREM);
+	accelerated.trainNetwork();
+	ASSERT_LE(accelerated.getParameterDifference(), 0.001f);
+	ASSERT_LT(accelerated.getNumberOfEMRuns(), c.getNumberOfEMRuns());
+	ASSERT_TRUE(std::isfinite(accelerated.getLogLikelihood()));
+	ASSERT_GE(accelerated.getLogLikelihood(), c.getLogLikelihood() - 1.0);
+}
@@ -0,0 +1,84 @@
+#include "gtest/gtest.h"
+#include "../core/EliminationOrdering.h"
+#include "../core/NetworkController.h"
+#include "config.h"
+
+class EliminationOrderingTest : public ::testing::Test{
+	protected:
+	EliminationOrderingTest()
+		:c(NetworkController())
+	{
+	}
+
+	void virtual SetUp(){
+		c.loadNetwork(TEST_DATA_PATH("Student.na"));
+		c.loadNetwork(TEST_DATA_PATH("Student.sif"));
+		c.loadObservations(TEST_DATA_PATH("StudentData.txt"),TEST_DATA_PATH("controlStudent.json"));
+		c.trainNetwork();
+	}
+
+	public:
+	NetworkController c;
+	std::vector<unsigned int> factorisation {0,1,2,3,4};
+};
+
+TEST_F(EliminationOrderingTest, moralGraph){
+	std::vector<int> values (5,-1);
+	EliminationOrdering o (c.getNetwork(), factorisation, values);
+	//Difficulty and Intelligence are married by their child Grade
+	std::set<unsigned int> difficulty {1,2};
+	ASSERT_TRUE(difficulty == o.getNeighbours(0));
+	std::set<unsigned int> intelligence {0,1,3};
+	ASSERT_TRUE(intelligence == o.getNeighbours(2));
+}
+
+TEST_F(EliminationOrderingTest, observedNodesAreIgnored){
+	std::vector<int> values (5,-1);
+	values[1]=0;
+	EliminationOrdering o (c.getNetwork(), factorisation, values);
+	ASSERT_TRUE(o.getNeighbours(1).empty());
+	//The reduced factor of Grade still contains Difficulty and Intelligence
+	std::set<unsigned int> difficulty {2};
+	ASSERT_TRUE(difficulty == o.getNeighbours(0));
+	std::set<unsigned int> intelligence {0,3};
+	ASSERT_TRUE(intelligence == o.getNeighbours(2));
+}
+
+TEST_F(EliminationOrderingTest, factorisation){
+	std::vector<int> values (5,-1);
+	EliminationOrdering o (c.getNetwork(), factorisation, values);
+	std::vector<unsigned int> nodes {2,0,1};
+	ASSERT_TRUE(nodes == o.getOrdering(nodes, EliminationHeuristic::Factorisation));
+}
+
+TEST_F(EliminationOrderingTest, minDegree){
+	std::vector<int> values (5,-1);
+	EliminationOrdering o (c.getNetwork(), factorisation, values);
+	std::vector<unsigned int> nodes {2,1,0,3,4};
+	std::vector<unsigned int> ordering = o.getOrdering(nodes, EliminationHeuristic::MinDegree);
+	ASSERT_EQ(5u, ordering.size());
+	//SAT and Letter have a single neighbour, SAT is listed first
+	ASSERT_EQ(3u, ordering[0]);
+	ASSERT_EQ(4u, ordering[1]);
+}
+
+TEST_F(EliminationOrderingTest, minFill){
+	std::vector<int> values (5,-1);
+	EliminationOrdering o (c.getNetwork(), factorisation, values);
+	//Difficulty does not introduce fill edges, as Grade and Intelligence are married
+	std::vector<unsigned int> nodes {1,2,0};
+	std::vector<unsigned int> expected {0,1,2};
+	ASSERT_TRUE(expected == o.getOrdering(nodes, EliminationHeuristic::MinFill));
+}
+
+TEST_F(EliminationOrderingTest, weightedMinFill){
+	std::vector<int> values (5,-1);
+	EliminationOrdering o (c.getNetwork(), factorisation, values);
+	std::vector<unsigned int> nodes {1,0,2,3,4};
+	std::vector<unsigned int> ordering = o.getOrdering(nodes, EliminationHeuristic::WeightedMinFill);
+	std::vector<unsigned int> sorted = ordering;
+	std::sort(sorted.begin(), sorted.end());
+	std::vector<unsigned int> expected {0,1,2,3,4};
+	ASSERT_TRUE(expected == sorted);
+	ASSERT_NE(1u, ordering[0]);
+}
@@ -0,0 +1,136 @@
+#include "gtest/gtest.h"
+#include "../core/FactorKernels.h"
+#include "../core/Factor.h"
+
+#include <vector>
+
+class FactorKernelsTest : public ::testing::Test{
+	protected:
+	void virtual SetUp(){
+		for (int set = 0; set <= static_cast<int>(FactorKernels::getSupportedInstructionSet()); set++){
+			sets.push_back(static_cast<InstructionSet>(set));
+		}
+	}
+
+	void virtual TearDown(){
+		FactorKernels::setInstructionSet(FactorKernels::getSupportedInstructionSet());
+	}
+
+	/**createFactor
+	 *
+	 * Creates a factor with deterministic, pairwise different probabilities
+	 */
+	Factor createFactor(const std::vector<unsigned int>& ids, const std::vector<unsigned int>& cardinalities, unsigned int seed){
+		Factor f (ids, cardinalities);
+		for (unsigned int i = 0; i < f.size(); i++){
+			f.setProbability(((i * 7 + seed) % 13 + 1) / 13.0f, i);
+		}
+		return f;
+	}
+
+	public:
+	std::vector<InstructionSet> sets;
+};
+
+TEST_F(FactorKernelsTest, unsupportedInstructionSet){
+	ASSERT_TRUE(FactorKernels::getInstructionSet() == FactorKernels::getSupportedInstructionSet());
+	if (FactorKernels::getSupportedInstructionSet() != InstructionSet::AVX2){
+		ASSERT_THROW(FactorKernels::setInstructionSet(InstructionSet::AVX2), std::invalid_argument);
+	}
+	FactorKernels::setInstructionSet(InstructionSet::Scalar);
+	ASSERT_TRUE(InstructionSet::Scalar == FactorKernels::getInstructionSet());
+}
+
+TEST_F(FactorKernelsTest, kernels){
+	for (auto set : sets){
+		FactorKernels::setInstructionSet(set);
+		for (size_t n = 0; n < 37; n++){
+			std::vector<float> a(n), b(n), target(n);
+			for (size_t i = 0; i < n; i++){
+				a[i] = i * 0.5f;
+				b[i] = (n - i) * 0.25f;
+			}
+			FactorKernels::multiply(target.data(), a.data(), b.data(), n);
+			for (size_t i = 0; i < n; i++){
+				ASSERT_FLOAT_EQ(a[i] * b[i], target[i]);
+			}
+			FactorKernels::multiply(target.data(), a.data(), 3.0f, n);
+			for (size_t i = 0; i < n; i++){
+				ASSERT_FLOAT_EQ(a[i] * 3.0f, target[i]);
+			}
+			target = b;
+			FactorKernels::add(target.data(), a.data(), n);
+			for (size_t i = 0; i < n; i++){
+				ASSERT_FLOAT_EQ(a[i] + b[i], target[i]);
+			}
+			target = b;
+			FactorKernels::maximum(target.data(), a.data(), n);
+			for (size_t i = 0; i < n; i++){
+				ASSERT_FLOAT_EQ(std::max(a[i], b[i]), target[i]);
+			}
+			ASSERT_NEAR(0.25f * n * (n - 1), FactorKernels::sum(a.data(), n), 0.001);
+			target = a;
+			FactorKernels::scale(target.data(), 0.5f, n);
+			for (size_t i = 0; i < n; i++){
+				ASSERT_FLOAT_EQ(a[i] * 0.5f, target[i]);
+			}
+		}
+	}
+}
+
+TEST_F(FactorKernelsTest, factorOperations){
+	Factor f1 = createFactor({0,1,2}, {3,4,5}, 1);
+	Factor f2 = createFactor({3,1,4}, {2,4,9}, 5);
+	Factor f3 = createFactor({2,0}, {5,3}, 3);
+	for (auto set : sets){
+		FactorKernels::setInstructionSet(set);
+		for (const Factor* other : {&f2, &f3}){
+			Factor product = f1.product(*other);
+			std::vector<unsigned int> counter (product.getIDs().size(), 0);
+			std::vector<int> values (5, -1);
+			for (unsigned int index = 0; index < product.size(); index++){
+				for (unsigned int i = 0; i < counter.size(); i++){
+					values[product.getIDs()[i]] = counter[i];
+				}
+				ASSERT_FLOAT_EQ(f1.getProbability(values) * other->getProbability(values),
+				                product.getProbability(index));
+				for (int i = counter.size() - 1; i >= 0; i--){
+					if (++counter[i] < product.getCardinalities()[i]){
+						break;
+					}
+					counter[i] = 0;
+				}
+			}
+		}
+		for (unsigned int id : {0,1,2}){
+			Factor sum = f1.sumOut(id);
+			Factor max = f1.maxOut(id);
+			unsigned int position = f1.getIndex(id);
+			std::vector<int> values (3, -1);
+			for (unsigned int index = 0; index < sum.size(); index++){
+				unsigned int rest = index;
+				for (int i = sum.getIDs().size() - 1; i >= 0; i--){
+					values[sum.getIDs()[i]] = rest % sum.getCardinalities()[i];
+					rest /= sum.getCardinalities()[i];
+				}
+				float expectedSum = 0.0f;
+				float expectedMax = 0.0f;
+				for (unsigned int value = 0; value < f1.getCardinalities()[position]; value++){
+					values[id] = value;
+					expectedSum += f1.getProbability(values);
+					expectedMax = std::max(expectedMax, f1.getProbability(values));
+				}
+				values[id] = -1;
+				ASSERT_NEAR(expectedSum, sum.getProbability(index), 0.0001);
+				ASSERT_FLOAT_EQ(expectedMax, max.getProbability(index));
+			}
+		}
+		Factor normalized = f1;
+		normalized.normalize();
+		float total = 0.0f;
+		for (unsigned int index = 0; index < normalized.size(); index++){
+			total += normalized.getProbability(index);
+		}
+		ASSERT_NEAR(1.0f, total, 0.0001);
+	}
+}
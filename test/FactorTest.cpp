@@ -30,13 +30,14 @@ TEST_F(FactorTest, FactorConstructorTestNode){
 
 TEST_F(FactorTest, FactorConstructorTestDirect){
 	std::vector<unsigned int> testIds = {0,1,2,3};
-	Factor f (100,testIds);
-	SUCCEED();
+	Factor f (testIds,{5,5,2,2});
+	ASSERT_EQ(100u, f.size());
+	ASSERT_THROW(Factor(testIds,{5,5}), std::invalid_argument);
 }
 
 TEST_F(FactorTest, getIDs){
 	std::vector<unsigned int> testIds = {0,1,2,3};
-	Factor f (10,testIds);
+	Factor f (testIds,{2,5,1,1});
 	ASSERT_TRUE(testIds == f.getIDs());
 }
 
@@ -54,23 +55,43 @@ TEST_F(FactorTest, knownValuesGetProbability){
 	
 }
 
-TEST_F(FactorTest, addGetProbability){
-	std::vector<unsigned int> testIds = {0,1,2,3};
-	Factor f (10,testIds);
-	f.addProbability(0.612f);
-	ASSERT_TRUE(0.612f == f.getProbability(10));
+TEST_F(FactorTest, observedNodeAndParent){
+	Network n = c.getNetwork();
+	const Node& grade = n.getNode("Grade");
+	const auto& p = grade.getProbabilityMatrix();
+	std::vector<int> values (5,-1);
+	values[0]=1;
+	values[1]=2;
+	Factor f (grade, values);
+	ASSERT_EQ(2u, f.size());
+	for(unsigned int i = 0; i < 2; i++) {
+		unsigned int row = grade.getFactor(0) + grade.getFactor(1) * i;
+		ASSERT_EQ(p(2, row), f.getProbability(i));
+	}
+	values[1]=3;
+	ASSERT_THROW(Factor(grade, values), std::invalid_argument);
+}
+
+TEST_F(FactorTest, stridedGetProbability){
+	std::vector<unsigned int> testIds = {0,1,2};
+	Factor f (testIds,{2,3,1},{-1,-1,1});
+	f.setProbability(0.612f, 4);
+	std::vector<int> values {1,1,1};
+	ASSERT_TRUE(0.612f == f.getProbability(values));
+	values[2]=0;
+	ASSERT_TRUE(1.0f == f.getProbability(values));
 }
 
 TEST_F(FactorTest, setGetProbability){
 	std::vector<unsigned int> testIds = {0,1,2,3};
-	Factor f (10,testIds);
+	Factor f (testIds,{2,5,1,1});
 	f.setProbability(0.429f, 1);
 	ASSERT_TRUE(0.429f == f.getProbability(1));
 }
 
 TEST_F(FactorTest, getIndex){	
 	std::vector<unsigned int> testIds = {3,2,1,0};
-	Factor f (10,testIds);
+	Factor f (testIds,{2,5,1,1});
 	ASSERT_EQ(0u, f.getIndex(3));
 	ASSERT_EQ(1u, f.getIndex(2));
 	ASSERT_EQ(2u, f.getIndex(1));
@@ -94,7 +115,7 @@ TEST_F(FactorTest, product){
 	std::vector<int> emptyValues (5,-1);
 	Factor fGrade (n.getNode("Grade"), emptyValues);
 	Factor fIntelligence (n.getNode("Intelligence"), emptyValues);
-	Factor product = fGrade.product(fIntelligence, n, emptyValues);
+	Factor product = fGrade.product(fIntelligence);
 	ASSERT_TRUE(fGrade.getIDs() == product.getIDs());
 	ASSERT_NEAR(0.21f,product.getProbability(0),0.001);
 	ASSERT_NEAR(0.27f,product.getProbability(1),0.001);
@@ -115,8 +136,8 @@ TEST_F(FactorTest, sumOut){
 	std::vector<int> emptyValues (5,-1);
 	Factor fGrade (n.getNode("Grade"), emptyValues);
 	Factor fIntelligence (n.getNode("Intelligence"), emptyValues);
-	Factor product = fGrade.product(fIntelligence, n, emptyValues);
-	Factor sumOut = product.sumOut(n.getNode("Intelligence").getID(), n, emptyValues);
+	Factor product = fGrade.product(fIntelligence);
+	Factor sumOut = product.sumOut(n.getNode("Intelligence").getID());
 	std::vector<unsigned int> newIDs {1,0};
 	ASSERT_TRUE(newIDs == sumOut.getIDs());
 	ASSERT_NEAR(0.48f,sumOut.getProbability(0),0.001);
@@ -127,10 +148,29 @@ TEST_F(FactorTest, sumOut){
 	ASSERT_NEAR(0.55f,sumOut.getProbability(5),0.001);
 }
 
+TEST_F(FactorTest, maxOut){
+	Network n = c.getNetwork();
+	std::vector<int> emptyValues (5,-1);
+	Factor fGrade (n.getNode("Grade"), emptyValues);
+	Factor fIntelligence (n.getNode("Intelligence"), emptyValues);
+	Factor product = fGrade.product(fIntelligence);
+	Factor maxOut = product.maxOut(n.getNode("Intelligence").getID());
+	std::vector<unsigned int> newIDs {1,0};
+	ASSERT_TRUE(newIDs == maxOut.getIDs());
+	ASSERT_NEAR(0.27f,maxOut.getProbability(0),0.001);
+	ASSERT_NEAR(0.15f,maxOut.getProbability(1),0.001);
+	ASSERT_NEAR(0.28f,maxOut.getProbability(2),0.001);
+	ASSERT_NEAR(0.175f,maxOut.getProbability(3),0.001);
+	ASSERT_NEAR(0.21f,maxOut.getProbability(4),0.001);
+	ASSERT_NEAR(0.49f,maxOut.getProbability(5),0.001);
+	Factor maxGrade = maxOut.maxOut(1);
+	ASSERT_NEAR(0.28f,maxGrade.getProbability(0),0.001);
+	ASSERT_NEAR(0.49f,maxGrade.getProbability(1),0.001);
+}
 
 TEST_F(FactorTest, normalize){
 	std::vector<unsigned int> testIds = {0};
-	Factor f (3,testIds);
+	Factor f (testIds,{3});
 	f.setProbability(0.612,0);
 	f.setProbability(0.411,1);
 	f.setProbability(0.429,2);
@@ -0,0 +1,112 @@
+#include "gtest/gtest.h"
+#include "../core/GibbsSampler.h"
+#include "../core/ProbabilityHandler.h"
+#include "../core/NetworkController.h"
+#include "config.h"
+
+class GibbsSamplerTest : public ::testing::Test{
+	protected:
+	GibbsSamplerTest()
+		:c(NetworkController())
+	{
+	}
+
+	void virtual SetUp(){
+		c.loadNetwork(TEST_DATA_PATH("Student.na"));
+		c.loadNetwork(TEST_DATA_PATH("Student.sif"));
+		c.loadObservations(TEST_DATA_PATH("StudentData.txt"),TEST_DATA_PATH("controlStudent.json"));
+		c.trainNetwork();
+	}
+
+	/**createValues
+	 *
+	 * @return a value vector of the network size containing the given assignment
+	 */
+	std::vector<int> createValues(const std::vector<std::pair<unsigned int, int>>& assignment){
+		std::vector<int> values (c.getNetwork().size(), -1);
+		for (const auto& a : assignment){
+			values[a.first] = a.second;
+		}
+		return values;
+	}
+
+	public:
+	NetworkController c;
+};
+
+TEST_F(GibbsSamplerTest, settings){
+	GibbsSampler g (c.getNetwork());
+	ASSERT_THROW(g.setNumberOfChains(0), std::invalid_argument);
+	ASSERT_THROW(g.setConvergenceThreshold(1.1f, 0), std::invalid_argument);
+	g.setSampleBudget(0);
+	ASSERT_THROW(g.computeProbability({1}, {0}, createValues({{1,0}}), createValues({{0,0}})), std::invalid_argument);
+	//The query value is required
+	g.setSampleBudget(100);
+	ASSERT_THROW(g.computeProbability({1}, {0}, createValues({}), createValues({{0,0}})), std::invalid_argument);
+}
+
+TEST_F(GibbsSamplerTest, budgetAndReproducibility){
+	GibbsSampler g (c.getNetwork());
+	g.setNumberOfChains(3);
+	g.setSampleBudget(2000);
+	g.setConvergenceThreshold(0.0f, 400);
+	SamplingEstimate first = g.computeProbability({0}, {1}, createValues({{0,0}}), createValues({{1,0}}));
+	SamplingEstimate second = g.computeProbability({0}, {1}, createValues({{0,0}}), createValues({{1,0}}));
+	ASSERT_EQ(6000u, first.samples);
+	ASSERT_FLOAT_EQ(first.probability, second.probability);
+	ASSERT_FLOAT_EQ(first.rHat, second.rHat);
+	//Early stop once the chains agree
+	g.setConvergenceThreshold(1.5f, 400);
+	g.setMinimumSamples(400);
+	ASSERT_EQ(1200u, g.computeProbability({0}, {1}, createValues({{0,0}}), createValues({{1,0}})).samples);
+}
+
+TEST_F(GibbsSamplerTest, certainEvent){
+	//Every chain hits the query state in every sweep, the chains agree
+	Network n = c.getNetwork();
+	n.getNode(3).setProbability(1.0f, 0, 0);
+	n.getNode(3).setProbability(0.0f, 1, 0);
+	GibbsSampler g (n);
+	g.setNumberOfChains(4);
+	g.setMinimumSamples(1000);
+	SamplingEstimate estimate = g.computeProbability({3}, {2}, createValues({{3,0}}), createValues({{2,0}}));
+	ASSERT_FLOAT_EQ(1.0f, estimate.probability);
+	ASSERT_FLOAT_EQ(1.0f, estimate.rHat);
+	ASSERT_EQ(4000u, estimate.samples);
+}
+
+TEST_F(GibbsSamplerTest, conditionalProbabilities){
+	ProbabilityHandler p (c.getNetwork());
+	GibbsSampler g (c.getNetwork());
+	g.setSampleBudget(50000);
+	//Condition on a child
+	SamplingEstimate estimate = g.computeProbability({0}, {1}, createValues({{0,0}}), createValues({{1,0}}));
+	ASSERT_NEAR(0.795f, estimate.probability, 5 * estimate.standardError + 0.005);
+	ASSERT_LT(estimate.rHat, 1.01f);
+	//Condition on multiple nodes
+	std::vector<int> query = createValues({{0,0},{2,1}});
+	std::vector<int> condition = createValues({{4,0},{3,1}});
+	float exact = p.computeConditionalProbability({0,2}, {4,3}, query, condition);
+	estimate = g.computeProbability({0,2}, {4,3}, query, condition);
+	ASSERT_NEAR(exact, estimate.probability, 5 * estimate.standardError + 0.005);
+}
+
+TEST_F(GibbsSamplerTest, rareEvent){
+	ProbabilityHandler p (c.getNetwork());
+	GibbsSampler g (c.getNetwork());
+	//The query state has a probability of about 0.00025, the chains must not
+	//stop before they reached it
+	std::vector<int> query = createValues({{1,2},{2,0},{3,1},{4,1}});
+	std::vector<int> condition = createValues({{0,1}});
+	float exact = p.computeConditionalProbability({1,2,3,4}, {0}, query, condition);
+	SamplingEstimate estimate = g.computeProbability({1,2,3,4}, {0}, query, condition);
+	ASSERT_GT(estimate.probability, 0.0f);
+	ASSERT_GT(estimate.standardError, 0.0f);
+	ASSERT_GT(estimate.samples, 4000u);
+	ASSERT_NEAR(exact, estimate.probability, 5 * estimate.standardError);
+	//Without any hit the whole budget is used
+	g.setSampleBudget(1500);
+	estimate = g.computeProbability({1,2,3,4}, {0}, query, condition);
+	ASSERT_FLOAT_EQ(0.0f, estimate.probability);
+	ASSERT_EQ(6000u, estimate.samples);
+}
@@ -0,0 +1,83 @@
+#include "gtest/gtest.h"
+#include "../core/InferenceSession.h"
+#include "../core/NetworkController.h"
+#include "config.h"
+
+class InferenceSessionTest : public ::testing::Test{
+	protected:
+	InferenceSessionTest()
+		:c(NetworkController())
+	{
+	}
+
+	void virtual SetUp(){
+		c.loadNetwork(TEST_DATA_PATH("Student.na"));
+		c.loadNetwork(TEST_DATA_PATH("Student.sif"));
+		c.loadObservations(TEST_DATA_PATH("StudentData.txt"),TEST_DATA_PATH("controlStudent.json"));
+		c.trainNetwork();
+	}
+
+	public:
+	NetworkController c;
+};
+
+TEST_F(InferenceSessionTest, startAndClose){
+	InferenceSession s (c.getNetwork());
+	ASSERT_FALSE(s.isOpen());
+	ASSERT_THROW(s.setEvidence(1, 0), std::invalid_argument);
+	ASSERT_THROW(s.start(std::vector<int>(3, -1)), std::invalid_argument);
+	s.start(std::vector<int>(5, -1));
+	ASSERT_TRUE(s.isOpen());
+	ASSERT_NEAR(0.362f, s.getPosterior(1)[0], 0.001);
+	ASSERT_THROW(s.setEvidence(1, 3), std::invalid_argument);
+	ASSERT_THROW(s.setEvidence(1, -1), std::invalid_argument);
+	s.close();
+	ASSERT_FALSE(s.isOpen());
+	ASSERT_THROW(s.getPosterior(1), std::invalid_argument);
+}
+
+TEST_F(InferenceSessionTest, updateEvidence){
+	InferenceSession s (c.getNetwork());
+	s.start(std::vector<int>(5, -1));
+	s.setEvidence(1, 0);
+	ASSERT_NEAR(0.795f, s.getPosterior(0)[0], 0.001);
+	ASSERT_EQ(1.0f, s.getPosterior(1)[0]);
+	s.removeEvidence(1);
+	s.setEvidence(3, 0);
+	ASSERT_EQ(-1, s.getEvidence()[1]);
+	ASSERT_NEAR(0.42f, s.getPosterior(4)[1], 0.001);
+	ASSERT_NEAR(0.6f, s.getPosterior(0)[0], 0.001);
+	s.removeEvidence(3);
+	ASSERT_NEAR(0.362f, s.getPosterior(1)[0], 0.001);
+}
+
+TEST_F(InferenceSessionTest, sameAsFullCalibration){
+	const Network& n = c.getNetwork();
+	InferenceSession s (n);
+	InferenceSession full (n);
+	std::vector<int> evidence (5, -1);
+	s.start(evidence);
+	// Toggle one evidence value at a time
+	std::vector<std::pair<unsigned int, int>> toggles =
+	    {{4, 1}, {0, 0}, {4, 0}, {2, 1}, {0, -1}, {3, 1}, {4, -1}, {1, 2}};
+	for (auto& toggle : toggles){
+		evidence[toggle.first] = toggle.second;
+		size_t sent = s.getNumberOfSentMessages();
+		if (toggle.second == -1){
+			s.removeEvidence(toggle.first);
+		} else {
+			s.setEvidence(toggle.first, toggle.second);
+		}
+		full.start(evidence);
+		// Messages sent towards the changed cliques are kept
+		ASSERT_LT(s.getNumberOfSentMessages() - sent,
+		          full.getNumberOfSentMessages());
+		for (unsigned int id = 0; id < n.size(); id++){
+			auto expected = full.getPosterior(id);
+			auto posterior = s.getPosterior(id);
+			for (unsigned int v = 0; v < expected.size(); v++){
+				ASSERT_NEAR(expected[v], posterior[v], 1e-5);
+			}
+		}
+	}
+}
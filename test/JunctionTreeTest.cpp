@@ -0,0 +1,109 @@
+#include "gtest/gtest.h"
+#include "../core/JunctionTree.h"
+#include "../core/NetworkController.h"
+#include "config.h"
+
+class JunctionTreeTest : public ::testing::Test{
+	protected:
+	JunctionTreeTest()
+		:c(NetworkController())
+	{
+	}
+
+	void virtual SetUp(){
+		c.loadNetwork(TEST_DATA_PATH("Student.na"));
+		c.loadNetwork(TEST_DATA_PATH("Student.sif"));
+		c.loadObservations(TEST_DATA_PATH("StudentData.txt"),TEST_DATA_PATH("controlStudent.json"));
+		c.trainNetwork();
+	}
+
+	public:
+	NetworkController c;
+};
+
+TEST_F(JunctionTreeTest, cliques){
+	JunctionTree t (c.getNetwork());
+	ASSERT_EQ(3u, t.getCliques().size());
+	//Every family is contained in a clique
+	for (const Node& n : c.getNetwork().getNodes()){
+		std::vector<unsigned int> family {n.getID()};
+		family.insert(family.end(), n.getParents().begin(), n.getParents().end());
+		ASSERT_NE(-1, t.findClique(family));
+	}
+	ASSERT_EQ(-1, t.findClique({3,4}));
+	unsigned int edges = 0;
+	for (unsigned int i = 0; i < t.getCliques().size(); i++){
+		edges += t.getNeighbours(i).size();
+	}
+	ASSERT_EQ(4u, edges);
+}
+
+TEST_F(JunctionTreeTest, notCalibrated){
+	JunctionTree t (c.getNetwork());
+	ASSERT_FALSE(t.isCalibrated());
+	ASSERT_THROW(t.getMarginal({1}), std::invalid_argument);
+}
+
+TEST_F(JunctionTreeTest, priors){
+	JunctionTree t (c.getNetwork());
+	std::vector<int> values (5,-1);
+	t.calibrate(values);
+	ASSERT_TRUE(t.isCalibrated());
+	values[1]=0;
+	ASSERT_NEAR(0.362f, t.getProbability({1}, values), 0.001);
+	values[1]=2;
+	ASSERT_NEAR(0.3496f, t.getProbability({1}, values), 0.001);
+	values[4]=0;
+	ASSERT_NEAR(0.497664f, t.getProbability({4}, values), 0.001);
+	values[0]=0;
+	values[1]=0;
+	ASSERT_NEAR(0.288f, t.getProbability({0,1}, values), 0.001);
+	ASSERT_THROW(t.getProbability({3,4}, values), std::invalid_argument);
+}
+
+TEST_F(JunctionTreeTest, posteriors){
+	JunctionTree t (c.getNetwork());
+	std::vector<int> evidence (5,-1);
+	evidence[1]=0;
+	t.calibrate(evidence);
+	std::vector<int> values (5,-1);
+	values[0]=0;
+	ASSERT_NEAR(0.795f, t.getProbability({0}, values), 0.001);
+	evidence[1]=-1;
+	evidence[3]=0;
+	t.calibrate(evidence);
+	values[4]=1;
+	ASSERT_NEAR(0.42f, t.getProbability({4}, values), 0.001);
+	ASSERT_NEAR(0.6f, t.getProbability({0}, values), 0.001);
+}
+
+TEST_F(JunctionTreeTest, heuristics){
+	for (auto heuristic : {EliminationHeuristic::Factorisation, EliminationHeuristic::MinDegree,
+	                       EliminationHeuristic::MinFill, EliminationHeuristic::WeightedMinFill}){
+		JunctionTree t (c.getNetwork(), heuristic);
+		std::vector<int> evidence (5,-1);
+		evidence[0]=0;
+		evidence[2]=0;
+		t.calibrate(evidence);
+		std::vector<int> values (5,-1);
+		values[1]=0;
+		ASSERT_NEAR(0.3f, t.getProbability({1}, values), 0.001);
+	}
+}
+
+TEST_F(JunctionTreeTest, evidenceProbability){
+	JunctionTree t (c.getNetwork());
+	ASSERT_THROW(t.getLogEvidenceProbability(), std::invalid_argument);
+	std::vector<int> evidence (5,-1);
+	t.calibrate(evidence);
+	ASSERT_NEAR(0.0, t.getLogEvidenceProbability(), 0.001);
+	evidence[1]=0;
+	t.calibrate(evidence);
+	ASSERT_NEAR(std::log(0.362), t.getLogEvidenceProbability(), 0.001);
+	t.updateEvidence(0, 0);
+	ASSERT_NEAR(std::log(0.288), t.getLogEvidenceProbability(), 0.001);
+	evidence[1]=2;
+	evidence[4]=0;
+	t.calibrate(evidence);
+	ASSERT_NEAR(std::log(0.3496*0.99), t.getLogEvidenceProbability(), 0.001);
+}
@@ -0,0 +1,85 @@
+#include "gtest/gtest.h"
+#include "../core/LoopyBeliefPropagation.h"
+#include "../core/ProbabilityHandler.h"
+#include "../core/NetworkController.h"
+#include "config.h"
+
+class LoopyBeliefPropagationTest : public ::testing::Test{
+	protected:
+	LoopyBeliefPropagationTest()
+		:c(NetworkController())
+	{
+	}
+
+	void virtual SetUp(){
+		c.loadNetwork(TEST_DATA_PATH("Student.na"));
+		c.loadNetwork(TEST_DATA_PATH("Student.sif"));
+		c.loadObservations(TEST_DATA_PATH("StudentData.txt"),TEST_DATA_PATH("controlStudent.json"));
+		c.trainNetwork();
+	}
+
+	/**comparePosteriors
+	 *
+	 * Compares the posteriors of loopy belief propagation to the exact ones
+	 */
+	void comparePosteriors(LoopyBeliefPropagation& bp, const std::vector<int>& evidence, float tolerance){
+		ProbabilityHandler p (c.getNetwork());
+		auto exact = p.computePosteriors(evidence);
+		auto approximate = bp.computePosteriors(evidence);
+		ASSERT_TRUE(bp.hasConverged());
+		ASSERT_EQ(exact.size(), approximate.size());
+		for (unsigned int id = 0; id < exact.size(); id++){
+			ASSERT_EQ(exact[id].size(), approximate[id].size());
+			for (unsigned int value = 0; value < exact[id].size(); value++){
+				ASSERT_NEAR(exact[id][value], approximate[id][value], tolerance);
+			}
+		}
+	}
+
+	public:
+	NetworkController c;
+};
+
+TEST_F(LoopyBeliefPropagationTest, damping){
+	LoopyBeliefPropagation bp (c.getNetwork());
+	ASSERT_THROW(bp.setDamping(1.0f), std::invalid_argument);
+	ASSERT_THROW(bp.setDamping(-0.1f), std::invalid_argument);
+}
+
+TEST_F(LoopyBeliefPropagationTest, tree){
+	//The factor graph of the student network is a tree, hence the posteriors are exact
+	LoopyBeliefPropagation bp (c.getNetwork());
+	std::vector<int> evidence (5,-1);
+	comparePosteriors(bp, evidence, 0.001);
+	auto posteriors = bp.computePosteriors(evidence);
+	ASSERT_NEAR(0.362f, posteriors[1][0], 0.001);
+	ASSERT_NEAR(0.497664f, posteriors[4][0], 0.001);
+	evidence[1]=0;
+	comparePosteriors(bp, evidence, 0.001);
+	ASSERT_NEAR(0.795f, bp.computePosteriors(evidence)[0][0], 0.001);
+	evidence[3]=1;
+	evidence[4]=0;
+	for (unsigned int batchSize : {1u, 3u, 16u}){
+		bp.setBatchSize(batchSize);
+		bp.setDamping(0.0f);
+		comparePosteriors(bp, evidence, 0.001);
+		bp.setDamping(0.5f);
+		comparePosteriors(bp, evidence, 0.001);
+	}
+}
+
+TEST_F(LoopyBeliefPropagationTest, loop){
+	//Difficulty influences the SAT score as well, which creates a loop
+	c.getNetwork().addEdge(3,0);
+	c.trainNetwork();
+	LoopyBeliefPropagation bp (c.getNetwork());
+	bp.setDamping(0.3f);
+	std::vector<int> evidence (5,-1);
+	evidence[4]=0;
+	comparePosteriors(bp, evidence, 0.05);
+	ASSERT_LT(0u, bp.getNumberOfUpdates());
+	bp.setMaxUpdates(0);
+	bp.computePosteriors(evidence);
+	ASSERT_FALSE(bp.hasConverged());
+	ASSERT_EQ(0u, bp.getNumberOfUpdates());
+}
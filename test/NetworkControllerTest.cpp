@@ -223,6 +223,46 @@ TEST_F(NetworkControllerTest, EdgeAdditionPossibility){
 
 	removedEdges.push_back(std::make_pair(0,1));
 	ASSERT_TRUE(n.isEdgePossible(4,0,addedEdges,removedEdges));
+
+	//The check does not modify the network
+	unsigned long version = n.getNetwork().getModelVersion();
+	addedEdges.push_back(std::make_pair(4,2));
+	ASSERT_FALSE(n.isEdgePossible(2,1,addedEdges,{}));
+	ASSERT_EQ(version, n.getNetwork().getModelVersion());
+	ASSERT_TRUE(n.getNetwork().getNode(2).getParents().empty());
+	ASSERT_EQ(2u, n.getNetwork().getNode(1).getParents().size());
 }
 
 
+
+TEST_F(NetworkControllerTest, trainChangedNodes){
+	NetworkController n;
+	n.loadNetwork(TEST_DATA_PATH("Student.na"));
+	n.loadNetwork(TEST_DATA_PATH("Student.sif"));
+	n.loadObservations(TEST_DATA_PATH("StudentData.txt"),TEST_DATA_PATH("controlStudent.json"));
+	n.trainNetwork();
+	const Network& trained = n.getNetwork();
+	Network incremental = trained;
+	incremental.removeEdge(4,1);
+	incremental.addEdge(4,3);
+	n.trainNetwork(incremental, {4});
+	Network full = trained;
+	full.removeEdge(4,1);
+	full.addEdge(4,3);
+	n.trainNetwork(full);
+	//Only the CPT of Letter is replaced, it equals the one of a full training
+	const Network& inc = incremental;
+	for(unsigned int id = 0; id < 4; id++){
+		ASSERT_EQ(trained.getNode(id).getProbabilityMatrix().getRawData(), inc.getNode(id).getProbabilityMatrix().getRawData());
+	}
+	const Node& letter = inc.getNode(4);
+	ASSERT_EQ(std::vector<unsigned int>{3}, letter.getParents());
+	ASSERT_EQ(full.getNode(4).getParentValueNames(), letter.getParentValueNames());
+	const auto& expected = full.getNode(4).getProbabilityMatrix();
+	ASSERT_EQ(expected.getRowCount(), letter.getProbabilityMatrix().getRowCount());
+	for(unsigned int row = 0; row < expected.getRowCount(); row++){
+		for(unsigned int col = 0; col < expected.getColCount(); col++){
+			ASSERT_FLOAT_EQ(expected(col,row), letter.getProbability(col,row));
+		}
+	}
+}
@@ -1,6 +1,7 @@
 #include "gtest/gtest.h"
 #include "../core/Network.h"
 #include "config.h"
+#include <algorithm>
 
 class NetworkTest : public ::testing::Test{
 	protected:
@@ -100,3 +101,57 @@ TEST_F(NetworkTest, cycle){
 	n_.readNetwork(TEST_DATA_PATH("test.tgf"));
 	ASSERT_FALSE(n_.checkCycleExistence(1));
 }
+
+TEST_F(NetworkTest, requisiteNodes){
+	n_.readNetwork(TEST_DATA_PATH("Student.na"));
+	n_.readNetwork(TEST_DATA_PATH("Student.sif"));
+	unsigned int d = n_.getNode("Difficulty").getID();
+	unsigned int g = n_.getNode("Grade").getID();
+	unsigned int i = n_.getNode("Intelligence").getID();
+	unsigned int s = n_.getNode("SAT").getID();
+	unsigned int l = n_.getNode("Letter").getID();
+	//Without evidence all ancestors are requisite
+	std::vector<unsigned int> dfs;
+	n_.setAllUnvisited();
+	n_.performDFS(l,dfs);
+	ASSERT_EQ(dfs, n_.getRequisiteNodes({l},{}));
+	//Observing Grade blocks all ancestors of Letter
+	ASSERT_EQ(std::vector<unsigned int>({l}), n_.getRequisiteNodes({l},{g}));
+	//Observing Intelligence blocks all ancestors of SAT
+	ASSERT_EQ(std::vector<unsigned int>({s}), n_.getRequisiteNodes({s},{i}));
+	//The observed common child Grade connects Difficulty and Intelligence, SAT is barren
+	auto requisite = n_.getRequisiteNodes({d},{g});
+	std::sort(requisite.begin(), requisite.end());
+	std::vector<unsigned int> expected {d,g,i};
+	std::sort(expected.begin(), expected.end());
+	ASSERT_EQ(expected, requisite);
+	//Observing SAT requires the probabilities of SAT and Intelligence
+	requisite = n_.getRequisiteNodes({g},{s});
+	std::sort(requisite.begin(), requisite.end());
+	expected = {d,g,i,s};
+	std::sort(expected.begin(), expected.end());
+	ASSERT_EQ(expected, requisite);
+}
+
+TEST_F(NetworkTest, prunedTwinNetwork){
+	n_.readNetwork(TEST_DATA_PATH("Student.na"));
+	n_.readNetwork(TEST_DATA_PATH("Student.sif"));
+	Network full = n_;
+	full.createTwinNetwork();
+	ASSERT_EQ(8u, full.size());
+	//Letter* depends on Grade*, whose parents are cut by the intervention
+	n_.createTwinNetwork({4}, {1});
+	ASSERT_EQ(7u, n_.size());
+	ASSERT_EQ(5u, n_.getHypoID(1));
+	ASSERT_EQ(6u, n_.getHypoID(4));
+	ASSERT_EQ("Letter*", n_.getNode(6u).getName());
+	ASSERT_EQ(std::vector<unsigned int>{5}, n_.getNode(6u).getParents());
+	ASSERT_EQ((std::vector<unsigned int>{0,2}), n_.getNode(5u).getParents());
+	//Without interventions, all hypothetical ancestors are created
+	Network unpruned;
+	unpruned.readNetwork(TEST_DATA_PATH("Student.na"));
+	unpruned.readNetwork(TEST_DATA_PATH("Student.sif"));
+	unpruned.createTwinNetwork({3}, {});
+	ASSERT_EQ(6u, unpruned.size());
+	ASSERT_EQ(std::vector<unsigned int>{2}, unpruned.getNode(5u).getParents());
+}
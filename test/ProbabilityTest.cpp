@@ -52,6 +52,19 @@ TEST_F(ProbabilityTest, TotalProbability){
 	ASSERT_NEAR(0.502336f,p.computeTotalProbability(4,1),0.001);	
 }
 
+TEST_F(ProbabilityTest, PriorsOutliveClear){
+	Network n = c.getNetwork();
+	auto grade = n.getPriors(1);
+	//Changing the network discards the stored priors, but not the ones in use
+	n.setIntervention(2, 0);
+	n.clearPriors();
+	auto changed = n.getPriors(1);
+	ASSERT_NE(grade.get(), changed.get());
+	ASSERT_NEAR(0.362f,(*grade)[0],0.001);
+	ASSERT_NEAR(0.2884f,(*grade)[1],0.001);
+	ASSERT_NEAR(0.3496f,(*grade)[2],0.001);
+}
+
 TEST_F(ProbabilityTest, TotalProbabilityNormalized){
 	Network n = c.getNetwork();
 	ProbabilityHandler p (n);
@@ -76,6 +89,23 @@ TEST_F(ProbabilityTest, TotalProbabilityNormalized){
 	ASSERT_NEAR(0.497664f,p.computeTotalProbabilityNormalized(4,0),0.001);
 	ASSERT_NEAR(0.502336f,p.computeTotalProbabilityNormalized(4,1),0.001);	
 }
+
+TEST_F(ProbabilityTest, PriorsAfterParameterChange){
+	Network n = c.getNetwork();
+	ProbabilityHandler p (n);
+	ASSERT_NEAR(0.497664f,p.computeTotalProbability(4,0),0.001);
+	//Fix Grade to its first value, Letter then follows the first CPT row
+	Node& grade = n.getNode(1);
+	grade.createBackupDoIntervention();
+	n.cutParents(1);
+	grade.setProbabilityTo1(0);
+	ASSERT_FLOAT_EQ(1.0f,p.computeTotalProbability(1,0));
+	ASSERT_FLOAT_EQ(n.getNode(4).getProbability(0,0),p.computeTotalProbability(4,0));
+	grade.loadBackupDoIntervention();
+	n.clearPriors();
+	ASSERT_NEAR(0.362f,p.computeTotalProbability(1,0),0.001);
+	ASSERT_NEAR(0.497664f,p.computeTotalProbability(4,0),0.001);
+}
 	
 
 TEST_F(ProbabilityTest, JointProbability){
@@ -191,3 +221,164 @@ TEST_F(ProbabilityTest, computeLikelihodOfTheData){
 	ASSERT_THROW(p.calculateLikelihoodOfTheData(testObservations2),std::invalid_argument);
 
 }
+
+TEST_F(ProbabilityTest, EliminationHeuristics){
+	Network n = c.getNetwork();
+	ProbabilityHandler p (n);
+	ASSERT_TRUE(EliminationHeuristic::WeightedMinFill == p.getEliminationHeuristic());
+	for (auto heuristic : {EliminationHeuristic::Factorisation, EliminationHeuristic::MinDegree,
+	                       EliminationHeuristic::MinFill, EliminationHeuristic::WeightedMinFill}){
+		p.setEliminationHeuristic(heuristic);
+		std::vector<int> m1(5,-1);
+		m1[0]=0;
+		m1[1]=0;
+		ASSERT_NEAR(0.288f, p.computeJointProbabilityUsingVariableElimination({0,1},m1),0.001);
+		std::vector<int> mn(5,-1);
+		mn[0]=0;
+		std::vector<int> md(5,-1);
+		md[1]=0;
+		ASSERT_NEAR(0.795f, p.computeConditionalProbability({0},{1},mn,md),0.001);
+		std::vector<int> mn2(5,-1);
+		mn2[4]=1;
+		std::vector<int> md2(5,-1);
+		md2[3]=0;
+		ASSERT_NEAR(0.42f, p.computeConditionalProbability({4},{3},mn2,md2),0.001);
+	}
+}
+
+TEST_F(ProbabilityTest, Posteriors){
+	Network n = c.getNetwork();
+	ProbabilityHandler p (n);
+	std::vector<int> values (5,-1);
+	std::vector<std::vector<float>> priors = p.computePosteriors(values);
+	ASSERT_EQ(5u, priors.size());
+	ASSERT_NEAR(0.362f, priors[1][0], 0.001);
+	ASSERT_NEAR(0.2884f, priors[1][1], 0.001);
+	ASSERT_NEAR(0.3496f, priors[1][2], 0.001);
+	ASSERT_NEAR(0.725f, priors[3][0], 0.001);
+	values[1]=0;
+	std::vector<std::vector<float>> posteriors = p.computePosteriors(values);
+	ASSERT_NEAR(0.795f, posteriors[0][0], 0.001);
+	ASSERT_NEAR(1.0f, posteriors[1][0], 0.001);
+	ASSERT_NEAR(0.0f, posteriors[1][1], 0.001);
+}
+
+TEST_F(ProbabilityTest, QueryPlans){
+	Network n = c.getNetwork();
+	ProbabilityHandler p (n);
+	ASSERT_EQ(0u, n.getQueryPlanCache().size());
+	std::vector<int> mn(5,-1);
+	mn[1]=0;
+	std::vector<int> md(5,-1);
+	md[0]=0;
+	ASSERT_NEAR(0.48f, p.computeConditionalProbability({1},{0},mn,md),0.001);
+	ASSERT_EQ(1u, n.getQueryPlanCache().size());
+	//Only the values differ, hence the plan is reused
+	std::vector<float> cached;
+	for (int grade = 0; grade < 3; grade++){
+		for (int difficulty = 0; difficulty < 2; difficulty++){
+			mn[1]=grade;
+			md[0]=difficulty;
+			cached.push_back(p.computeConditionalProbability({1},{0},mn,md));
+		}
+	}
+	ASSERT_EQ(1u, n.getQueryPlanCache().size());
+	n.clearQueryPlans();
+	ASSERT_EQ(0u, n.getQueryPlanCache().size());
+	unsigned int index = 0;
+	for (int grade = 0; grade < 3; grade++){
+		for (int difficulty = 0; difficulty < 2; difficulty++){
+			mn[1]=grade;
+			md[0]=difficulty;
+			ASSERT_FLOAT_EQ(cached[index], p.computeConditionalProbability({1},{0},mn,md));
+			n.clearQueryPlans();
+			index++;
+		}
+	}
+	//A different structure leads to a new plan
+	std::vector<int> m1(5,-1);
+	m1[0]=0;
+	m1[1]=0;
+	ASSERT_NEAR(0.288f, p.computeJointProbabilityUsingVariableElimination({0,1},m1),0.001);
+	ASSERT_NEAR(0.288f, p.computeJointProbabilityUsingVariableElimination({0,1},m1),0.001);
+	ASSERT_EQ(1u, n.getQueryPlanCache().size());
+	p.setEliminationHeuristic(EliminationHeuristic::MinDegree);
+	ASSERT_NEAR(0.288f, p.computeJointProbabilityUsingVariableElimination({0,1},m1),0.001);
+	ASSERT_EQ(2u, n.getQueryPlanCache().size());
+	//Cutting the parents of a node changes the structure of the query
+	n.cutParents(1);
+	p.computeJointProbabilityUsingVariableElimination({0,1},m1);
+	ASSERT_EQ(3u, n.getQueryPlanCache().size());
+	//Structural changes invalidate all plans
+	n.addEdge(3,0);
+	ASSERT_EQ(0u, n.getQueryPlanCache().size());
+	n.removeEdge(3,0);
+	ASSERT_EQ(0u, n.getQueryPlanCache().size());
+}
+
+TEST_F(ProbabilityTest, maxSearchMultipleNodes){
+	Network n = c.getNetwork();
+	ProbabilityHandler p (n);
+	std::vector<unsigned int> queryNodes {0,1,2,3};
+	for (auto conditionValue : {-1,0,1}){
+		std::vector<unsigned int> conditionNodes;
+		std::vector<int> conditionValues (5,-1);
+		if (conditionValue != -1){
+			conditionNodes.push_back(4);
+			conditionValues[4]=conditionValue;
+		}
+		//Enumerate all assignments of the query nodes
+		float maxprob = 0.0f;
+		std::vector<int> best;
+		std::vector<int> values (5,-1);
+		for (int d = 0; d < 2; d++){
+			for (int g = 0; g < 3; g++){
+				for (int i = 0; i < 2; i++){
+					for (int s = 0; s < 2; s++){
+						values[0]=d;
+						values[1]=g;
+						values[2]=i;
+						values[3]=s;
+						float prob = conditionNodes.empty()
+						    ? p.computeJointProbabilityUsingVariableElimination(queryNodes, values)
+						    : p.computeConditionalProbability(queryNodes, conditionNodes, values, conditionValues);
+						if (prob > maxprob){
+							maxprob = prob;
+							best = {d,g,i,s};
+						}
+					}
+				}
+			}
+		}
+		auto result = p.maxSearch(queryNodes, conditionNodes, conditionValues);
+		ASSERT_NEAR(maxprob, result.first, 0.0001);
+		ASSERT_EQ(4u, result.second.size());
+		for (unsigned int k = 0; k < queryNodes.size(); k++){
+			ASSERT_EQ(n.getNode(queryNodes[k]).getValueNamesProb()[best[k]], result.second[k]);
+		}
+	}
+}
+
+TEST_F(ProbabilityTest, ParallelElimination){
+	Network n = c.getNetwork();
+	ProbabilityHandler sequential (n);
+	sequential.setParallelElimination(false);
+	ProbabilityHandler parallel (n);
+	parallel.setParallelElimination(true, 0.0);
+	for (unsigned int query = 0; query < 5; query++){
+		for (unsigned int condition = 0; condition < 5; condition++){
+			if (query == condition){
+				continue;
+			}
+			std::vector<int> mn(5,-1);
+			mn[query]=0;
+			std::vector<int> md(5,-1);
+			md[condition]=1;
+			ASSERT_FLOAT_EQ(sequential.computeConditionalProbability({query},{condition},mn,md),
+			                parallel.computeConditionalProbability({query},{condition},mn,md));
+			mn[condition]=1;
+			ASSERT_FLOAT_EQ(sequential.computeJointProbabilityUsingVariableElimination({query,condition},mn),
+			                parallel.computeJointProbabilityUsingVariableElimination({query,condition},mn));
+		}
+	}
+}
@@ -0,0 +1,77 @@
+#include "gtest/gtest.h"
+#include "../core/QueryArena.h"
+#include "../core/Factor.h"
+#include "../core/NetworkController.h"
+#include "config.h"
+
+#include <cstdint>
+
+class QueryArenaTest : public ::testing::Test{
+	protected:
+	QueryArenaTest()
+		:c(NetworkController())
+	{
+	}
+
+	void virtual SetUp(){
+		c.loadNetwork(TEST_DATA_PATH("Student.na"));
+		c.loadNetwork(TEST_DATA_PATH("Student.sif"));
+		c.loadObservations(TEST_DATA_PATH("StudentData.txt"),TEST_DATA_PATH("controlStudent.json"));
+		c.trainNetwork();
+	}
+
+	public:
+	NetworkController c;
+};
+
+TEST_F(QueryArenaTest, allocate){
+	QueryArena arena(256);
+	ASSERT_EQ(0u, arena.getNumberOfBlocks());
+	char* first = static_cast<char*>(arena.allocate(3, 1));
+	double* second = static_cast<double*>(arena.allocate(sizeof(double), alignof(double)));
+	ASSERT_EQ(0u, reinterpret_cast<uintptr_t>(second) % alignof(double));
+	ASSERT_EQ(1u, arena.getNumberOfBlocks());
+	ASSERT_NE(static_cast<void*>(first), static_cast<void*>(second));
+	// Requests larger than a block get a block of their own
+	arena.allocate(1000, 1);
+	ASSERT_EQ(2u, arena.getNumberOfBlocks());
+	ASSERT_EQ(3u + sizeof(double) + 1000u, arena.getAllocatedBytes());
+}
+
+TEST_F(QueryArenaTest, scope){
+	ASSERT_EQ(nullptr, QueryArena::getCurrent());
+	QueryArena outer;
+	{
+		QueryArena::Scope outerScope(&outer);
+		ASSERT_EQ(&outer, QueryArena::getCurrent());
+		QueryArena inner;
+		{
+			QueryArena::Scope innerScope(&inner);
+			ASSERT_EQ(&inner, QueryArena::getCurrent());
+			ArenaVector<int> v(10, 1);
+			ASSERT_EQ(&inner, v.get_allocator().getArena());
+		}
+		ASSERT_EQ(&outer, QueryArena::getCurrent());
+	}
+	ASSERT_EQ(nullptr, QueryArena::getCurrent());
+	// Without an arena, the heap is used
+	ArenaVector<int> v(10, 1);
+	ASSERT_EQ(nullptr, v.get_allocator().getArena());
+}
+
+TEST_F(QueryArenaTest, factors){
+	Network n = c.getNetwork();
+	std::vector<int> values(5, -1);
+	Factor heap(n.getNode("Grade"), values);
+	QueryArena arena;
+	{
+		QueryArena::Scope scope(&arena);
+		Factor f(n.getNode("Grade"), values);
+		ASSERT_GT(arena.getAllocatedBytes(), f.size() * sizeof(float));
+		Factor g = f.product(Factor(n.getNode("Letter"), values)).sumOut(1);
+		for(unsigned int i = 0; i < f.size(); i++) {
+			ASSERT_EQ(heap.getProbability(i), f.getProbability(i));
+		}
+		ASSERT_EQ(f.size() / 3 * 2, g.size());
+	}
+}
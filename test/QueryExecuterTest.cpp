@@ -156,3 +156,300 @@ TEST_F(QueryExecuterTest, QECheck21){
 	qe.setCondition(0,0);	
 	ASSERT_NEAR(0.48f, qe.execute().first, 0.001);	
 }
+
+TEST_F(QueryExecuterTest, Batch){
+	std::vector<QueryExecuter> queries;
+	//Queries without evidence
+	for (unsigned int value = 0; value < 3; value++){
+		queries.push_back(QueryExecuter(c));
+		queries.back().setNonIntervention(1,value);
+	}
+	queries.push_back(QueryExecuter(c));
+	for (unsigned int id = 0; id < 5; id++){
+		queries.back().setNonIntervention(id,0);
+	}
+	//Queries sharing the same evidence
+	queries.push_back(QueryExecuter(c));
+	queries.back().setNonIntervention(1,0);
+	queries.back().setCondition(0,0);
+	queries.push_back(QueryExecuter(c));
+	queries.back().setArgMax(1);
+	queries.back().setCondition(0,0);
+	queries.push_back(QueryExecuter(c));
+	queries.back().setNonIntervention(2,0);
+	queries.back().setCondition(0,0);
+	//Queries sharing the same intervention
+	for (unsigned int value = 0; value < 2; value++){
+		queries.push_back(QueryExecuter(c));
+		queries.back().setNonIntervention(4,value);
+		queries.back().setDoIntervention(1,0);
+	}
+	//A counterfactual query
+	queries.push_back(QueryExecuter(c));
+	queries.back().setNonIntervention(4,1);
+	queries.back().setDoIntervention(1,0);
+	queries.back().setCondition(4,0);
+	queries.back().setCondition(1,2);
+
+	std::vector<std::pair<float, std::vector<std::string>>> expected;
+	for (const auto& qe : queries){
+		QueryExecuter single (qe);
+		single.setResultCaching(false);
+		expected.push_back(single.execute());
+	}
+	auto results = QueryExecuter::executeBatch(queries);
+	ASSERT_EQ(expected.size(), results.size());
+	for (unsigned int i = 0; i < results.size(); i++){
+		ASSERT_NEAR(expected[i].first, results[i].first, 0.0001);
+		ASSERT_EQ(expected[i].second, results[i].second);
+	}
+	ASSERT_NEAR(0.362f, results[0].first, 0.001);
+	ASSERT_NEAR(0.01197f, results[3].first, 0.001);
+	ASSERT_NEAR(0.48f, results[4].first, 0.001);
+	ASSERT_NEAR(0.48f, results[5].first, 0.001);
+	ASSERT_NEAR(0.7f, results[6].first, 0.001);
+
+	//The network is restored after the batch
+	QueryExecuter qe (c);
+	qe.setNonIntervention(4,0);
+	ASSERT_NEAR(0.497664f, qe.execute().first, 0.001);
+}
+
+TEST_F(QueryExecuterTest, BatchWithoutQueryNodes){
+	std::vector<QueryExecuter> queries;
+	queries.push_back(QueryExecuter(c));
+	queries.back().setNonIntervention(1,0);
+	queries.push_back(QueryExecuter(c));
+	queries.back().setCondition(0,0);
+	ASSERT_THROW(QueryExecuter::executeBatch(queries), std::invalid_argument);
+}
+
+TEST_F(QueryExecuterTest, LikelihoodWeighting){
+	QueryExecuter qe (c);
+	qe.setInferenceMethod(InferenceMethod::LikelihoodWeighting);
+	qe.getSamplingHandler().setSampleBudget(100000);
+	qe.setNonIntervention(4,1);
+	qe.setDoIntervention(1,0);
+	auto result = qe.execute();
+	ASSERT_LT(0.0f, qe.getStandardError());
+	ASSERT_NEAR(c.getNetwork().getNode(4).getProbability(1,0), result.first, 4 * qe.getStandardError() + 0.001);
+	qe.setInferenceMethod(InferenceMethod::Exact);
+	ASSERT_NEAR(c.getNetwork().getNode(4).getProbability(1,0), qe.execute().first, 0.001);
+	ASSERT_FLOAT_EQ(0.0f, qe.getStandardError());
+}
+
+TEST_F(QueryExecuterTest, GibbsCounterfactual){
+	QueryExecuter exact (c);
+	exact.setNonIntervention(4,0);
+	exact.setDoIntervention(3,0);
+	exact.setCondition(1,2);
+	QueryExecuter gibbs (exact);
+	gibbs.setInferenceMethod(InferenceMethod::Gibbs);
+	gibbs.getGibbsSampler().setSampleBudget(50000);
+	float expected = exact.execute().first;
+	float result = gibbs.execute().first;
+	ASSERT_LT(0.0f, gibbs.getStandardError());
+	ASSERT_NEAR(expected, result, 5 * gibbs.getStandardError() + 0.005);
+	//The twin network is removed afterwards
+	ASSERT_EQ(5u, c.getNetwork().size());
+}
+
+TEST_F(QueryExecuterTest, ResultCache){
+	Network& n = c.getNetwork();
+	QueryResultCache& cache = n.getQueryResultCache();
+	QueryExecuter qe (c);
+	qe.setNonIntervention(4,0);
+	qe.setDoIntervention(1,0);
+	qe.setCondition(0,0);
+	unsigned long version = n.getModelVersion();
+	float expected = qe.execute().first;
+	//The interventions of the query do not change the model version
+	ASSERT_EQ(version, n.getModelVersion());
+	ASSERT_EQ(1u, cache.size());
+	//The same query specified in a different order is answered from the cache
+	QueryExecuter same (c);
+	same.setCondition(0,0);
+	same.setDoIntervention(1,0);
+	same.setNonIntervention(4,0);
+	ASSERT_FLOAT_EQ(expected, same.execute().first);
+	ASSERT_EQ(1u, cache.size());
+	QueryExecuter other (c);
+	other.setNonIntervention(4,1);
+	other.setDoIntervention(1,0);
+	other.setCondition(0,0);
+	ASSERT_NEAR(1.0f - expected, other.execute().first, 0.001);
+	ASSERT_EQ(2u, cache.size());
+	//Structural edits and training invalidate the cache
+	std::vector<std::pair<unsigned int, unsigned int>> none;
+	ASSERT_TRUE(c.isEdgePossible(3, 4, none, none));
+	ASSERT_EQ(version, n.getModelVersion());
+	n.addEdge(4, 3);
+	ASSERT_LT(version, n.getModelVersion());
+	c.trainNetwork();
+	float changed = same.execute().first;
+	ASSERT_EQ(1u, cache.size());
+	n.removeEdge(4, 3);
+	c.trainNetwork();
+	ASSERT_NEAR(expected, same.execute().first, 0.001);
+	ASSERT_NE(expected, changed);
+}
+
+TEST_F(QueryExecuterTest, Overlay){
+	const Network& n = c.getNetwork();
+	std::vector<const float*> cpts;
+	std::vector<std::vector<unsigned int>> parents;
+	for(const Node& node : n.getNodes()) {
+		cpts.push_back(node.getProbabilityMatrix().getRawData());
+		parents.push_back(node.getParents());
+	}
+	unsigned long version = n.getModelVersion();
+	//Copies share the CPTs until one of them is modified
+	Network copy(n);
+	const Network& shared = copy;
+	ASSERT_EQ(cpts[1], shared.getNode(1).getProbabilityMatrix().getRawData());
+	copy.setIntervention(1,0);
+	ASSERT_NE(cpts[1], shared.getNode(1).getProbabilityMatrix().getRawData());
+	ASSERT_EQ(cpts[4], shared.getNode(4).getProbabilityMatrix().getRawData());
+	ASSERT_TRUE(shared.getNode(1).getParents().empty());
+	QueryExecuter doQuery (c);
+	doQuery.setNonIntervention(4,0);
+	doQuery.setDoIntervention(1,0);
+	ASSERT_NEAR(0.1f, doQuery.execute().first, 0.001);
+	QueryExecuter edgeQuery (c);
+	edgeQuery.setNonIntervention(4,0);
+	edgeQuery.setRemoveEdge(1,4);
+	edgeQuery.setAddEdge(3,4);
+	ASSERT_NEAR(0.49512f, edgeQuery.execute().first, 0.001);
+	QueryExecuter counterfactual (c);
+	counterfactual.setNonIntervention(4,0);
+	counterfactual.setDoIntervention(1,0);
+	counterfactual.setCondition(4,1);
+	ASSERT_NEAR(0.1f, counterfactual.execute().first, 0.001);
+	//The queries do not modify the model
+	ASSERT_EQ(version, n.getModelVersion());
+	ASSERT_EQ(5u, n.size());
+	for(const Node& node : n.getNodes()) {
+		ASSERT_EQ(cpts[node.getID()], node.getProbabilityMatrix().getRawData());
+		ASSERT_EQ(parents[node.getID()], node.getParents());
+	}
+}
+
+TEST_F(QueryExecuterTest, Concurrent){
+	Network& n = c.getNetwork();
+	std::vector<QueryExecuter> queries;
+	for(int round = 0; round < 8; round++) {
+		for(int value = 0; value < 2; value++) {
+			queries.emplace_back(c);
+			queries.back().setNonIntervention(4,value);
+			queries.back().setCondition(0,0);
+			queries.emplace_back(c);
+			queries.back().setNonIntervention(4,value);
+			queries.back().setDoIntervention(1,0);
+			queries.emplace_back(c);
+			queries.back().setNonIntervention(4,value);
+			queries.back().setRemoveEdge(1,4);
+			queries.back().setAddEdge(3,4);
+			queries.emplace_back(c);
+			queries.back().setNonIntervention(4,value);
+			queries.back().setDoIntervention(1,0);
+			queries.back().setCondition(4,1);
+		}
+		queries.emplace_back(c);
+		queries.back().setArgMax(1);
+		queries.back().setCondition(0,round % 2);
+	}
+	std::vector<float> expected;
+	for(auto& qe : queries) {
+		QueryExecuter single (qe);
+		single.setResultCaching(false);
+		expected.push_back(single.execute().first);
+	}
+	unsigned long version = n.getModelVersion();
+	ThreadPool pool(4);
+	auto results = QueryExecuter::executeConcurrently(queries, pool);
+	ASSERT_EQ(queries.size(), results.size());
+	for(unsigned int i = 0; i < queries.size(); i++) {
+		ASSERT_NEAR(expected[i], results[i].first, 0.00001);
+	}
+	//Cached results are returned concurrently as well
+	results = QueryExecuter::executeConcurrently(queries);
+	for(unsigned int i = 0; i < queries.size(); i++) {
+		ASSERT_NEAR(expected[i], results[i].first, 0.00001);
+	}
+	ASSERT_EQ(version, n.getModelVersion());
+	ASSERT_EQ(5u, n.size());
+	//Errors of single queries are rethrown
+	queries.emplace_back(c);
+	queries.back().setNonIntervention(4,0);
+	queries.back().setAddEdge(4,1);
+	ASSERT_THROW(QueryExecuter::executeConcurrently(queries, pool), std::invalid_argument);
+}
+
+TEST_F(QueryExecuterTest, TwinNetworkCache){
+	Network& n = c.getNetwork();
+	TwinNetworkCache& cache = n.getTwinNetworkCache();
+	std::vector<float> results;
+	for(int value = 0; value < 2; value++) {
+		QueryExecuter qe (c);
+		qe.setNonIntervention(4,value);
+		qe.setDoIntervention(1,0);
+		qe.setCondition(4,1);
+		qe.setCondition(0,value);
+		results.push_back(qe.execute().first);
+	}
+	ASSERT_NEAR(1.0f, results[0] + results[1], 0.001);
+	//Both queries share one twin network pruned to Grade* and Letter*
+	ASSERT_EQ(1u, cache.size());
+	TwinNetworkKey key;
+	key.nodes = {4};
+	key.interventions = {{1,0}};
+	auto twin = cache.find(key, n.getModelVersion());
+	ASSERT_NE(nullptr, twin);
+	ASSERT_EQ(7u, twin->size());
+	ASSERT_TRUE(twin->getNode(twin->getHypoID(1)).getParents().empty());
+	ASSERT_EQ(5u, n.size());
+	QueryExecuter other (c);
+	other.setNonIntervention(4,0);
+	other.setDoIntervention(1,1);
+	other.setCondition(4,1);
+	other.execute();
+	ASSERT_EQ(2u, cache.size());
+	//A new model version invalidates the twin networks
+	c.trainNetwork();
+	ASSERT_EQ(nullptr, cache.find(key, n.getModelVersion()));
+}
+
+TEST_F(QueryExecuterTest, QueriesDuringTraining){
+	std::vector<QueryExecuter> queries;
+	for(int value = 0; value < 2; value++) {
+		queries.emplace_back(c);
+		queries.back().setNonIntervention(4,value);
+		queries.back().setCondition(0,0);
+		queries.emplace_back(c);
+		queries.back().setNonIntervention(4,value);
+		queries.back().setRemoveEdge(1,4);
+		queries.back().setAddEdge(3,4);
+		queries.back().setResultCaching(false);
+	}
+	std::vector<float> expected;
+	for(auto& qe : queries) {
+		QueryExecuter single (qe);
+		single.setResultCaching(false);
+		expected.push_back(single.execute().first);
+	}
+	//EM tasks run on the global pool while queries help executing them
+	NetworkController training;
+	training.loadNetwork(TEST_DATA_PATH("Student.na"));
+	training.loadNetwork(TEST_DATA_PATH("Student.sif"));
+	training.loadObservations(TEST_DATA_PATH("dataStudent60.txt"),TEST_DATA_PATH("controlStudent.json"));
+	training.setEMRestarts(2);
+	std::thread trainer([&training]{ training.trainNetwork(); });
+	for(int round = 0; round < 20; round++) {
+		auto results = QueryExecuter::executeConcurrently(queries);
+		for(unsigned int i = 0; i < queries.size(); i++) {
+			EXPECT_NEAR(expected[i], results[i].first, 0.00001);
+		}
+	}
+	trainer.join();
+	ASSERT_NEAR(0.7, training.getNetwork().getNode("Intelligence").getProbability(0,0),0.06);
+}
@@ -0,0 +1,36 @@
+#include "gtest/gtest.h"
+#include "../core/QueryPlanCache.h"
+#include "../core/EliminationOrdering.h"
+
+TEST(QueryPlanCacheTest, findAndInsert){
+	QueryPlanCache cache;
+	QueryPlanKey key {{1},{0},{0,1,2},EliminationHeuristic::MinFill};
+	ASSERT_EQ(nullptr, cache.find(key));
+	QueryPlan plan;
+	plan.ordering = {0,1};
+	cache.insert(key, plan);
+	ASSERT_EQ(1u, cache.size());
+	ASSERT_NE(nullptr, cache.find(key));
+	ASSERT_EQ(plan.ordering, cache.find(key)->ordering);
+	QueryPlanKey other = key;
+	other.heuristic = EliminationHeuristic::MinDegree;
+	ASSERT_EQ(nullptr, cache.find(other));
+	other = key;
+	other.nodeStates[2] = 1;
+	ASSERT_EQ(nullptr, cache.find(other));
+	cache.clear();
+	ASSERT_EQ(0u, cache.size());
+	ASSERT_EQ(nullptr, cache.find(key));
+}
+
+TEST(QueryPlanCacheTest, capacity){
+	QueryPlanCache cache(2);
+	QueryPlan plan;
+	for (unsigned int i = 0; i < 2; i++){
+		cache.insert({{i},{},{},EliminationHeuristic::MinFill}, plan);
+	}
+	ASSERT_EQ(2u, cache.size());
+	cache.insert({{2},{},{},EliminationHeuristic::MinFill}, plan);
+	ASSERT_EQ(1u, cache.size());
+	ASSERT_NE(nullptr, cache.find({{2},{},{},EliminationHeuristic::MinFill}));
+}
@@ -0,0 +1,47 @@
+#include "gtest/gtest.h"
+#include "../core/QueryResultCache.h"
+
+TEST(QueryResultCacheTest, findAndInsert){
+	QueryResultCache cache;
+	QueryResultKey key;
+	key.nonInterventions = {{1,0}};
+	key.conditions = {{0,0}};
+	ASSERT_EQ(nullptr, cache.find(key, 0));
+	cache.insert(key, 0, std::make_pair(0.5f, std::vector<std::string>{"a"}));
+	ASSERT_EQ(1u, cache.size());
+	ASSERT_LT(0u, cache.getMemoryUsage());
+	ASSERT_NE(nullptr, cache.find(key, 0));
+	ASSERT_EQ(0.5f, cache.find(key, 0)->first);
+	ASSERT_EQ(std::vector<std::string>{"a"}, cache.find(key, 0)->second);
+	QueryResultKey other = key;
+	other.doInterventions = {{2,1}};
+	ASSERT_EQ(nullptr, cache.find(other, 0));
+	//A new model version removes all results
+	ASSERT_EQ(nullptr, cache.find(key, 1));
+	ASSERT_EQ(0u, cache.size());
+	ASSERT_EQ(0u, cache.getMemoryUsage());
+}
+
+TEST(QueryResultCacheTest, leastRecentlyUsed){
+	QueryResultCache cache;
+	std::vector<QueryResultKey> keys (3);
+	for (unsigned int i = 0; i < 3; i++){
+		keys[i].nonInterventions = {{i,0}};
+		cache.insert(keys[i], 0, std::make_pair(0.1f * i, std::vector<std::string>()));
+	}
+	size_t entry = cache.getMemoryUsage() / 3;
+	//Room for two results, the first one has been used most recently
+	cache.find(keys[0], 0);
+	cache.setCapacity(2 * entry);
+	ASSERT_EQ(2u, cache.size());
+	ASSERT_NE(nullptr, cache.find(keys[0], 0));
+	ASSERT_EQ(nullptr, cache.find(keys[1], 0));
+	ASSERT_NE(nullptr, cache.find(keys[2], 0));
+	cache.insert(keys[1], 0, std::make_pair(0.1f, std::vector<std::string>()));
+	ASSERT_EQ(2u, cache.size());
+	ASSERT_EQ(nullptr, cache.find(keys[0], 0));
+	ASSERT_LE(cache.getMemoryUsage(), 2 * entry);
+	//Results larger than the capacity are not stored
+	cache.insert(keys[0], 0, std::make_pair(0.0f, std::vector<std::string>(100, "value")));
+	ASSERT_EQ(nullptr, cache.find(keys[0], 0));
+}
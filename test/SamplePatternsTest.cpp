@@ -0,0 +1,30 @@
+#include "gtest/gtest.h"
+
+#include "../core/SamplePatterns.h"
+
+TEST(SamplePatternsTest, Empty){
+	SamplePatterns p;
+	ASSERT_EQ(0u, p.size());
+	ASSERT_EQ(0u, p.getPatterns().getColCount());
+}
+
+TEST(SamplePatternsTest, CollapseIdenticalSamples){
+	Matrix<int> ob (5, 2, 0, {"NA"}, {"A", "B"});
+	ob(0, 0) = 1; ob(0, 1) = -1;
+	ob(1, 0) = 0; ob(1, 1) = 1;
+	ob(2, 0) = 1; ob(2, 1) = -1;
+	ob(3, 0) = 1; ob(3, 1) = -1;
+	ob(4, 0) = 0; ob(4, 1) = 1;
+	SamplePatterns p (ob);
+	const Matrix<int>& patterns = p.getPatterns();
+	ASSERT_EQ(2u, p.size());
+	ASSERT_EQ(2u, patterns.getColCount());
+	ASSERT_EQ(2u, patterns.getRowCount());
+	ASSERT_EQ(1, patterns.findRow("B"));
+	ASSERT_EQ(0, patterns(0, 0));
+	ASSERT_EQ(1, patterns(0, 1));
+	ASSERT_EQ(1, patterns(1, 0));
+	ASSERT_EQ(-1, patterns(1, 1));
+	std::vector<unsigned int> weights {2, 3};
+	ASSERT_TRUE(weights == p.getWeights());
+}
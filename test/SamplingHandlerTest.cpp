@@ -0,0 +1,100 @@
+#include "gtest/gtest.h"
+#include "../core/SamplingHandler.h"
+#include "../core/ProbabilityHandler.h"
+#include "../core/NetworkController.h"
+#include "config.h"
+
+#include <chrono>
+
+class SamplingHandlerTest : public ::testing::Test{
+	protected:
+	SamplingHandlerTest()
+		:c(NetworkController())
+	{
+	}
+
+	void virtual SetUp(){
+		c.loadNetwork(TEST_DATA_PATH("Student.na"));
+		c.loadNetwork(TEST_DATA_PATH("Student.sif"));
+		c.loadObservations(TEST_DATA_PATH("StudentData.txt"),TEST_DATA_PATH("controlStudent.json"));
+		c.trainNetwork();
+	}
+
+	/**createValues
+	 *
+	 * @return a value vector of the network size assigning the given value to the given node
+	 */
+	std::vector<int> createValues(const std::vector<std::pair<unsigned int, int>>& assignment){
+		std::vector<int> values (c.getNetwork().size(), -1);
+		for (const auto& a : assignment){
+			values[a.first] = a.second;
+		}
+		return values;
+	}
+
+	public:
+	NetworkController c;
+};
+
+TEST_F(SamplingHandlerTest, budget){
+	SamplingHandler s (c.getNetwork());
+	s.setSampleBudget(0);
+	ASSERT_THROW(s.computeProbability({1}, {}, createValues({{1,0}}), createValues({})), std::invalid_argument);
+	ASSERT_THROW(s.setAdaptiveImportanceSampling(true, 10, 0), std::invalid_argument);
+	s.setTimeBudget(std::chrono::milliseconds(20));
+	SamplingEstimate estimate = s.computeProbability({1}, {}, createValues({{1,0}}), createValues({}));
+	ASSERT_LT(0u, estimate.samples);
+	ASSERT_NEAR(0.362f, estimate.probability, 5 * estimate.standardError + 0.01);
+	s.setSampleBudget(1000);
+	s.setTimeBudget(std::chrono::milliseconds(0));
+	ASSERT_EQ(1000u, s.computeProbability({1}, {}, createValues({{1,0}}), createValues({})).samples);
+}
+
+TEST_F(SamplingHandlerTest, reproducible){
+	SamplingHandler s (c.getNetwork());
+	s.setSampleBudget(5000);
+	s.setNumberOfTasks(3);
+	SamplingEstimate first = s.computeProbability({4}, {2}, createValues({{4,0}}), createValues({{2,1}}));
+	SamplingEstimate second = s.computeProbability({4}, {2}, createValues({{4,0}}), createValues({{2,1}}));
+	ASSERT_EQ(5000u, first.samples);
+	ASSERT_FLOAT_EQ(first.probability, second.probability);
+	ASSERT_FLOAT_EQ(first.standardError, second.standardError);
+}
+
+TEST_F(SamplingHandlerTest, likelihoodWeighting){
+	ProbabilityHandler p (c.getNetwork());
+	SamplingHandler s (c.getNetwork());
+	s.setSampleBudget(200000);
+	//Joint probability without conditions
+	SamplingEstimate estimate = s.computeProbability({0,1}, {}, createValues({{0,0},{1,0}}), createValues({}));
+	ASSERT_NEAR(0.288f, estimate.probability, 4 * estimate.standardError + 0.001);
+	ASSERT_LT(estimate.standardError, 0.002);
+	//Condition on a child
+	estimate = s.computeProbability({0}, {1}, createValues({{0,0}}), createValues({{1,0}}));
+	ASSERT_NEAR(0.795f, estimate.probability, 4 * estimate.standardError + 0.001);
+	//Condition on multiple nodes
+	std::vector<int> values = createValues({{1,0},{0,0},{2,0}});
+	estimate = s.computeProbability({1}, {0,2}, values, values);
+	ASSERT_NEAR(0.3f, estimate.probability, 4 * estimate.standardError + 0.001);
+	//Query the letter given the SAT score
+	std::vector<int> query = createValues({{4,1}});
+	std::vector<int> condition = createValues({{3,0}});
+	float exact = p.computeConditionalProbability({4}, {3}, query, condition);
+	estimate = s.computeProbability({4}, {3}, query, condition);
+	ASSERT_NEAR(exact, estimate.probability, 4 * estimate.standardError + 0.001);
+}
+
+TEST_F(SamplingHandlerTest, adaptiveImportanceSampling){
+	ProbabilityHandler p (c.getNetwork());
+	SamplingHandler s (c.getNetwork());
+	s.setSampleBudget(100000);
+	std::vector<int> query = createValues({{0,0},{2,1}});
+	std::vector<int> condition = createValues({{4,0},{3,1}});
+	float exact = p.computeConditionalProbability({0,2}, {4,3}, query, condition);
+	SamplingEstimate plain = s.computeProbability({0,2}, {4,3}, query, condition);
+	s.setAdaptiveImportanceSampling(true);
+	SamplingEstimate adaptive = s.computeProbability({0,2}, {4,3}, query, condition);
+	ASSERT_NEAR(exact, plain.probability, 4 * plain.standardError + 0.001);
+	ASSERT_NEAR(exact, adaptive.probability, 4 * adaptive.standardError + 0.001);
+	ASSERT_EQ(100000u, adaptive.samples);
+}
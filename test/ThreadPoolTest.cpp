@@ -0,0 +1,84 @@
+#include "gtest/gtest.h"
+#include "../core/ThreadPool.h"
+#include "../core/QueryArena.h"
+
+#include <chrono>
+#include <ctime>
+#include <thread>
+
+TEST(ThreadPoolTest, size){
+	ThreadPool pool (3);
+	ASSERT_EQ(3u, pool.size());
+	ThreadPool single (0);
+	ASSERT_EQ(1u, single.size());
+	ASSERT_LE(1u, ThreadPool::getGlobalPool().size());
+}
+
+TEST(ThreadPoolTest, submit){
+	ThreadPool pool (4);
+	std::atomic<unsigned int> counter (0);
+	for (unsigned int i = 0; i < 1000; i++){
+		pool.submit([&counter]{ counter++; });
+	}
+	pool.waitUntil([&counter]{ return counter == 1000; });
+	ASSERT_EQ(1000u, counter);
+	ASSERT_FALSE(pool.runPendingTask());
+}
+
+TEST(ThreadPoolTest, nestedTasks){
+	ThreadPool pool (2);
+	std::atomic<unsigned int> counter (0);
+	//Tasks waiting for their own subtasks must not block the pool
+	for (unsigned int i = 0; i < 8; i++){
+		pool.submit([&pool, &counter]{
+			std::atomic<unsigned int> children (0);
+			for (unsigned int j = 0; j < 16; j++){
+				pool.submit([&children]{ children++; });
+			}
+			pool.waitUntil([&children]{ return children == 16; });
+			counter += children;
+		});
+	}
+	pool.waitUntil([&counter]{ return counter == 128; });
+	ASSERT_EQ(128u, counter);
+}
+
+TEST(ThreadPoolTest, sleepingWaiter){
+	ThreadPool pool (1);
+	std::atomic<bool> started (false);
+	std::atomic<bool> finished (false);
+	pool.submit([&started, &finished]{
+		started = true;
+		std::this_thread::sleep_for(std::chrono::milliseconds(300));
+		finished = true;
+	});
+	while (!started){
+		std::this_thread::yield();
+	}
+	//Without pending tasks the waiter sleeps instead of polling the queues
+	std::clock_t begin = std::clock();
+	pool.waitUntil([&finished]{ return finished.load(); });
+	ASSERT_TRUE(finished);
+	ASSERT_LT(std::clock() - begin, CLOCKS_PER_SEC / 10);
+}
+
+TEST(ThreadPoolTest, noQueryArena){
+	ThreadPool pool (2);
+	QueryArena arena;
+	QueryArena::Scope scope(&arena);
+	std::atomic<unsigned int> counter (0);
+	std::atomic<unsigned int> withArena (0);
+	//Tasks executed by a helping thread must not use its arena
+	for (unsigned int i = 0; i < 256; i++){
+		pool.submit([&counter, &withArena]{
+			if (QueryArena::getCurrent() != nullptr){
+				withArena++;
+			}
+			counter++;
+		});
+	}
+	pool.waitUntil([&counter]{ return counter == 256; });
+	ASSERT_EQ(0u, withArena);
+	ASSERT_EQ(&arena, QueryArena::getCurrent());
+	ASSERT_EQ(0u, arena.getAllocatedBytes());
+}